@@ -133,21 +133,30 @@ void MVM_6model_find_method(MVMThreadContext *tc, MVMObject *obj, MVMString *nam
 
 MVMint32 MVM_6model_find_method_spesh(MVMThreadContext *tc, MVMObject *obj, MVMString *name,
                                       MVMint32 ss_idx, MVMRegister *res) {
-    /* Missed mono-morph; try cache-only lookup. */
-    MVMObject *meth = MVM_6model_find_method_cache_only(tc, obj, name);
+    /* Missed the cache; try cache-only lookup. */
+    MVMObject *meth;
+    if (tc->instance->profiling)
+        MVM_profiler_log_findmeth_cache(tc, 0);
+    meth = MVM_6model_find_method_cache_only(tc, obj, name);
     if (!MVM_is_null(tc, meth)) {
-        /* Got it; cache. Must be careful due to threads
-         * reading, races, etc. */
-        MVMStaticFrame *sf = tc->cur_frame->static_info;
+        /* Got it; cache it in the first free type/method pair of spesh
+         * slots, if there is one. Must be careful due to threads reading,
+         * races, etc. */
+        MVMStaticFrame  *sf    = tc->cur_frame->static_info;
+        MVMCollectable **slots = tc->cur_frame->effective_spesh_slots;
+        MVMint32         i;
         uv_mutex_lock(&tc->instance->mutex_spesh_install);
-        if (!tc->cur_frame->effective_spesh_slots[ss_idx + 1]) {
-            MVM_ASSIGN_REF(tc, &(sf->common.header),
-                           tc->cur_frame->effective_spesh_slots[ss_idx + 1],
-                           (MVMCollectable *)meth);
-            MVM_barrier();
-            MVM_ASSIGN_REF(tc, &(sf->common.header),
-                           tc->cur_frame->effective_spesh_slots[ss_idx],
-                           (MVMCollectable *)STABLE(obj));
+        for (i = ss_idx; i < ss_idx + 2 * MVM_FINDMETH_CACHE_TYPES; i += 2) {
+            if (slots[i] == (MVMCollectable *)STABLE(obj))
+                break;
+            if (!slots[i + 1]) {
+                MVM_ASSIGN_REF(tc, &(sf->common.header), slots[i + 1],
+                               (MVMCollectable *)meth);
+                MVM_barrier();
+                MVM_ASSIGN_REF(tc, &(sf->common.header), slots[i],
+                               (MVMCollectable *)STABLE(obj));
+                break;
+            }
         }
         uv_mutex_unlock(&tc->instance->mutex_spesh_install);
         res->o = meth;
@@ -161,6 +170,110 @@ MVMint32 MVM_6model_find_method_spesh(MVMThreadContext *tc, MVMObject *obj, MVMS
 }
 
 
+/* Locates a method for a findmeth instruction in unspecialized bytecode, at
+ * the specified bytecode offset, using and filling an inline cache for it.
+ * The caches are an open-addressed table on the static frame; a site with no
+ * cache (because the table is full) just does the full lookup, as does one
+ * whose cache is for another name (because a findmeth at the same offset in
+ * the other of the original and instrumented bytecode got there first). */
+static MVMFindMethCache * get_findmeth_cache(MVMThreadContext *tc, MVMStaticFrame *sf, MVMuint32 site) {
+    MVMFindMethCache *caches = sf->body.findmeth_caches;
+    MVMuint32         mask   = sf->body.num_findmeth_caches - 1;
+    MVMuint32         start  = (site * 2654435761U) & mask;
+    MVMuint32         i      = start;
+    AO_t              key    = (AO_t)site + 1;
+    if (!caches)
+        return NULL;
+    do {
+        AO_t cur = MVM_load(&(caches[i].site));
+        if (cur == key)
+            return &caches[i];
+        if (cur == 0 && (MVM_cas(&(caches[i].site), 0, key) == 0 || MVM_load(&(caches[i].site)) == key))
+            return &caches[i];
+        i = (i + 1) & mask;
+    } while (i != start);
+    return NULL;
+}
+void MVM_6model_find_method_cached(MVMThreadContext *tc, MVMObject *obj, MVMString *name,
+                                   MVMuint32 site, MVMRegister *res) {
+    MVMStaticFrame   *sf = tc->cur_frame->static_info;
+    MVMFindMethCache *cache;
+    MVMObject        *meth;
+    MVMuint32         gen, i;
+
+    /* Null is an error, which the full lookup will report. */
+    if (MVM_is_null(tc, obj)) {
+        MVM_6model_find_method(tc, obj, name, res);
+        return;
+    }
+
+    /* See if we have the type in the cache, for its current method cache.
+     * The generation is read before the method, so that a method being
+     * replaced concurrently is never taken as current. */
+    gen   = STABLE(obj)->method_cache_gen;
+    cache = get_findmeth_cache(tc, sf, site);
+    if (cache && cache->name && cache->name != name)
+        cache = NULL;
+    if (cache) {
+        MVMSTable *st = STABLE(obj);
+        for (i = 0; i < MVM_FINDMETH_CACHE_TYPES; i++) {
+            if (cache->types[i] == st) {
+                if (cache->gens[i] == gen) {
+                    MVMObject *cached;
+                    MVM_barrier();
+                    cached = cache->methods[i];
+                    MVM_barrier();
+                    if (cache->gens[i] == gen) {
+                        if (tc->instance->profiling)
+                            MVM_profiler_log_findmeth_cache(tc, 1);
+                        res->o = cached;
+                        return;
+                    }
+                }
+                break;
+            }
+        }
+    }
+    if (tc->instance->profiling)
+        MVM_profiler_log_findmeth_cache(tc, 0);
+
+    /* Missed; if the method cache can resolve it, then put it in the first
+     * free entry, if any; otherwise do a full lookup. */
+    meth = MVM_6model_find_method_cache_only(tc, obj, name);
+    if (MVM_is_null(tc, meth)) {
+        MVM_6model_find_method(tc, obj, name, res);
+        return;
+    }
+    if (cache) {
+        uv_mutex_lock(&tc->instance->mutex_spesh_install);
+        if (!cache->name) {
+            MVM_ASSIGN_REF(tc, &(sf->common.header), cache->name, name);
+            MVM_barrier();
+        }
+        for (i = 0; cache->name == name && i < MVM_FINDMETH_CACHE_TYPES; i++) {
+            if (cache->types[i] == STABLE(obj)) {
+                /* Refresh an entry from an older method cache; if it's for
+                 * a newer one than we looked in, leave it be. */
+                if ((MVMint32)(cache->gens[i] - gen) < 0) {
+                    MVM_ASSIGN_REF(tc, &(sf->common.header), cache->methods[i], meth);
+                    MVM_barrier();
+                    cache->gens[i] = gen;
+                }
+                break;
+            }
+            if (!cache->methods[i]) {
+                MVM_ASSIGN_REF(tc, &(sf->common.header), cache->methods[i], meth);
+                cache->gens[i] = gen;
+                MVM_barrier();
+                MVM_ASSIGN_REF(tc, &(sf->common.header), cache->types[i], STABLE(obj));
+                break;
+            }
+        }
+        uv_mutex_unlock(&tc->instance->mutex_spesh_install);
+    }
+    res->o = meth;
+}
+
 /* Locates a method by name. Returns 1 if it exists; otherwise 0. */
 static void late_bound_can_return(MVMThreadContext *tc, void *sr_data) {
     /* Transform to an integer result. */
@@ -273,6 +386,100 @@ static void mark_sr_data(MVMThreadContext *tc, MVMFrame *frame, MVMGCWorklist *w
     MVM_gc_worklist_add(tc, worklist, &atd->type);
 }
 
+/* Builds what type checks look in for a type check cache. For long caches,
+ * that includes a hash index, keyed on the type cache ID of the type's
+ * STable, which unlike the type object's address doesn't change when the GC
+ * moves things. */
+static MVMTypeCheckIndex * build_type_check_index(MVMThreadContext *tc, MVMObject **cache, MVMuint16 elems) {
+    MVMTypeCheckIndex *index;
+    MVMuint32          size = 0;
+    MVMuint16          i;
+    if (elems >= MVM_TYPE_CHECK_INDEX_MIN) {
+        size = 16;
+        while (size < 2 * (MVMuint32)elems)
+            size *= 2;
+    }
+    index        = MVM_fixed_size_alloc_zeroed(tc, tc->instance->fsa,
+        sizeof(MVMTypeCheckIndex) + size * sizeof(MVMuint16));
+    index->cache = cache;
+    index->elems = elems;
+    if (!size)
+        return index;
+    index->mask = (MVMuint16)(size - 1);
+    for (i = 0; i < elems; i++) {
+        MVMuint32 slot;
+        if (!cache[i])
+            continue;
+        slot = (MVMuint32)(STABLE(cache[i])->type_cache_id / MVM_TYPE_CACHE_ID_INCR) & index->mask;
+        while (index->slots[slot])
+            slot = (slot + 1) & index->mask;
+        index->slots[slot] = i + 1;
+    }
+    return index;
+}
+
+/* Sizes of a type check cache array and of an index, as allocated with the
+ * fixed size allocator. An empty cache still gets an allocation, since it
+ * differs from having no cache at all. */
+static size_t type_check_cache_bytes(MVMuint16 elems) {
+    return (elems ? elems : 1) * sizeof(MVMObject *);
+}
+static size_t type_check_index_bytes(MVMTypeCheckIndex *index) {
+    return sizeof(MVMTypeCheckIndex)
+        + (index->mask ? index->mask + 1 : 0) * sizeof(MVMuint16);
+}
+
+/* Allocates an array for a type check cache of the given number of elements,
+ * to be filled and then passed to MVM_6model_set_type_check_cache. */
+MVMObject ** MVM_6model_alloc_type_check_cache(MVMThreadContext *tc, MVMuint16 elems) {
+    return MVM_fixed_size_alloc(tc, tc->instance->fsa, type_check_cache_bytes(elems));
+}
+
+/* Installs a new type check cache on an STable, taking ownership of the
+ * cache array. Other threads may be looking at the old cache and index
+ * right now, so those are only freed at the next safepoint. */
+void MVM_6model_set_type_check_cache(MVMThreadContext *tc, MVMSTable *st, MVMObject **cache, MVMuint16 elems) {
+    MVMTypeCheckIndex *old_index = st->type_check_index;
+    MVMObject        **old_cache = st->type_check_cache;
+    MVMuint16          old_elems = st->type_check_cache_length;
+    MVMTypeCheckIndex *index     = cache ? build_type_check_index(tc, cache, elems) : NULL;
+    st->type_check_cache        = cache;
+    st->type_check_cache_length = elems;
+    MVM_barrier();
+    MVM_store(&(st->type_check_index), index);
+
+    if (old_index)
+        MVM_fixed_size_free_at_safepoint(tc, tc->instance->fsa,
+            type_check_index_bytes(old_index), old_index);
+    if (old_cache && old_cache != cache)
+        MVM_fixed_size_free_at_safepoint(tc, tc->instance->fsa,
+            type_check_cache_bytes(old_elems), old_cache);
+}
+
+/* Checks if a type is in an STable's type check cache. Short caches are
+ * scanned; longer ones are looked up through the hash index. */
+MVMint64 MVM_6model_in_type_check_cache(MVMThreadContext *tc, MVMSTable *st, MVMObject *type) {
+    MVMTypeCheckIndex *index = (MVMTypeCheckIndex *)MVM_load(&(st->type_check_index));
+    if (!index)
+        return 0;
+    if (!index->mask) {
+        MVMuint16 i;
+        for (i = 0; i < index->elems; i++)
+            if (index->cache[i] == type)
+                return 1;
+        return 0;
+    }
+    else {
+        MVMuint32 slot = (MVMuint32)(STABLE(type)->type_cache_id / MVM_TYPE_CACHE_ID_INCR) & index->mask;
+        while (index->slots[slot]) {
+            if (index->cache[index->slots[slot] - 1] == type)
+                return 1;
+            slot = (slot + 1) & index->mask;
+        }
+        return 0;
+    }
+}
+
 void MVM_6model_istype(MVMThreadContext *tc, MVMObject *obj, MVMObject *type, MVMRegister *res) {
     MVMObject **cache;
     MVMSTable  *st;
@@ -290,13 +497,9 @@ void MVM_6model_istype(MVMThreadContext *tc, MVMObject *obj, MVMObject *type, MV
     if (cache) {
         /* We have the cache, so just look for the type object we
          * want to be in there. */
-        MVMint64 elems = STABLE(obj)->type_check_cache_length;
-        MVMint64 i;
-        for (i = 0; i < elems; i++) {
-            if (cache[i] == type) {
-                res->i64 = 1;
-                return;
-            }
+        if (MVM_6model_in_type_check_cache(tc, st, type)) {
+            res->i64 = 1;
+            return;
         }
 
         /* If the type check cache is definitive, we're done. */
@@ -348,16 +551,8 @@ void MVM_6model_istype(MVMThreadContext *tc, MVMObject *obj, MVMObject *type, MV
 
 /* Checks if an object has a given type, using the cache only. */
 MVMint64 MVM_6model_istype_cache_only(MVMThreadContext *tc, MVMObject *obj, MVMObject *type) {
-    if (!MVM_is_null(tc, obj)) {
-        MVMuint16 i, elems = STABLE(obj)->type_check_cache_length;
-        MVMObject  **cache = STABLE(obj)->type_check_cache;
-        if (cache)
-            for (i = 0; i < elems; i++) {
-                if (cache[i] == type)
-                    return 1;
-            }
-    }
-
+    if (!MVM_is_null(tc, obj))
+        return MVM_6model_in_type_check_cache(tc, STABLE(obj), type);
     return 0;
 }
 
@@ -368,14 +563,10 @@ MVMint64 MVM_6model_istype_cache_only(MVMThreadContext *tc, MVMObject *obj, MVMO
  * not tell and a false value is returned and result is undefined. */
 MVMint64 MVM_6model_try_cache_type_check(MVMThreadContext *tc, MVMObject *obj, MVMObject *type, MVMint32 *result) {
     if (!MVM_is_null(tc, obj)) {
-        MVMuint16 i, elems = STABLE(obj)->type_check_cache_length;
-        MVMObject  **cache = STABLE(obj)->type_check_cache;
-        if (cache) {
-            for (i = 0; i < elems; i++) {
-                if (cache[i] == type) {
-                    *result = 1;
-                    return 1;
-                }
+        if (STABLE(obj)->type_check_cache) {
+            if (MVM_6model_in_type_check_cache(tc, STABLE(obj), type)) {
+                *result = 1;
+                return 1;
             }
             if ((STABLE(obj)->mode_flags & MVM_TYPE_CHECK_CACHE_THEN_METHOD) == 0 &&
                 (STABLE(type)->mode_flags & MVM_TYPE_CHECK_NEEDS_ACCEPTS) == 0) {
@@ -399,7 +590,12 @@ void MVM_6model_stable_gc_free(MVMThreadContext *tc, MVMSTable *st) {
         st->REPR->gc_free_repr_data(tc, st);
 
     /* free various storage. */
-    MVM_free(st->type_check_cache);
+    if (st->type_check_cache)
+        MVM_fixed_size_free(tc, tc->instance->fsa,
+            type_check_cache_bytes(st->type_check_cache_length), st->type_check_cache);
+    if (st->type_check_index)
+        MVM_fixed_size_free(tc, tc->instance->fsa,
+            type_check_index_bytes(st->type_check_index), st->type_check_index);
     if (st->container_spec && st->container_spec->gc_free_data)
         st->container_spec->gc_free_data(tc, st);
     MVM_free(st->invocation_spec);
@@ -233,6 +233,28 @@ struct MVMBoolificationSpec {
  * dispatch cache). */
 #define MVM_TYPE_CACHE_ID_INCR 128
 
+/* Type check caches at least this long get a hash index built for them;
+ * shorter ones are just scanned. */
+#define MVM_TYPE_CHECK_INDEX_MIN 8
+
+/* What type checks look in: a type check cache and its length, along with
+ * a hash index into it for long caches. Installing a cache swaps the whole
+ * thing in through one pointer, so a reader never pairs one cache with the
+ * length or index of another. */
+struct MVMTypeCheckIndex {
+    /* The cache and its length. */
+    MVMObject **cache;
+    MVMuint16   elems;
+
+    /* The mask for the hash table, or zero if the cache is short enough to
+     * just scan. */
+    MVMuint16   mask;
+
+    /* Open-addressed table of cache positions plus one (so zero is empty),
+     * keyed on the type cache ID of the type's STable. */
+    MVMuint16   slots[1];
+};
+
 /* S-table, representing a meta-object/representation pairing. Note that the
  * items are grouped in hope that it will pack decently and do decently in
  * terms of cache lines. */
@@ -262,9 +284,17 @@ struct MVMSTable {
      * all the things it isa and all the things it does). */
     MVMObject **type_check_cache;
 
+    /* The type check cache as type checks see it, with a hash index for
+     * long caches; see MVM_6model_set_type_check_cache. */
+    MVMTypeCheckIndex *type_check_index;
+
     /* By-name method dispatch cache. */
     MVMObject *method_cache;
 
+    /* Bumped whenever the method cache is replaced, so caches of lookups
+     * that were made through it can tell they are stale. */
+    MVMuint32 method_cache_gen;
+
     /* An ID solely for use in caches that last a VM instance. Thus it
      * should never, ever be serialized and you should NEVER make a
      * type directory based upon this ID. Otherwise you'll create memory
@@ -646,9 +676,14 @@ void MVM_6model_find_method(MVMThreadContext *tc, MVMObject *obj, MVMString *nam
 MVM_PUBLIC MVMObject * MVM_6model_find_method_cache_only(MVMThreadContext *tc, MVMObject *obj, MVMString *name);
 MVMint32 MVM_6model_find_method_spesh(MVMThreadContext *tc, MVMObject *obj, MVMString *name,
                                       MVMint32 ss_idx, MVMRegister *res);
+void MVM_6model_find_method_cached(MVMThreadContext *tc, MVMObject *obj, MVMString *name,
+                                   MVMuint32 site, MVMRegister *res);
 MVMint64 MVM_6model_can_method_cache_only(MVMThreadContext *tc, MVMObject *obj, MVMString *name);
 void MVM_6model_can_method(MVMThreadContext *tc, MVMObject *obj, MVMString *name, MVMRegister *res);
 void MVM_6model_istype(MVMThreadContext *tc, MVMObject *obj, MVMObject *type, MVMRegister *res);
+MVMObject ** MVM_6model_alloc_type_check_cache(MVMThreadContext *tc, MVMuint16 elems);
+void MVM_6model_set_type_check_cache(MVMThreadContext *tc, MVMSTable *st, MVMObject **cache, MVMuint16 elems);
+MVMint64 MVM_6model_in_type_check_cache(MVMThreadContext *tc, MVMSTable *st, MVMObject *type);
 MVM_PUBLIC MVMint64 MVM_6model_istype_cache_only(MVMThreadContext *tc, MVMObject *obj, MVMObject *type);
 MVMint64 MVM_6model_try_cache_type_check(MVMThreadContext *tc, MVMObject *obj, MVMObject *type, MVMint32 *result);
 void MVM_6model_invoke_default(MVMThreadContext *tc, MVMObject *invokee, MVMCallsite *callsite, MVMRegister *args);
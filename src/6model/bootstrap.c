@@ -127,6 +127,7 @@ static void add_attribute(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegist
 static void compose(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *args) {
     MVMObject *self, *type_obj, *method_table, *attributes, *BOOTArray, *BOOTHash,
               *repr_info_hash, *repr_info, *type_info, *attr_info_list, *parent_info;
+    MVMObject **type_check_cache;
     MVMuint64   num_attrs, i;
     MVMInstance *instance = tc->instance;
 
@@ -144,9 +145,9 @@ static void compose(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *ar
     method_table = ((MVMKnowHOWREPR *)self)->body.methods;
     MVM_ASSIGN_REF(tc, &(STABLE(type_obj)->header), STABLE(type_obj)->method_cache, method_table);
     STABLE(type_obj)->mode_flags              = MVM_METHOD_CACHE_AUTHORITATIVE;
-    STABLE(type_obj)->type_check_cache_length = 1;
-    STABLE(type_obj)->type_check_cache        = MVM_malloc(sizeof(MVMObject *));
-    MVM_ASSIGN_REF(tc, &(STABLE(type_obj)->header), STABLE(type_obj)->type_check_cache[0], type_obj);
+    type_check_cache = MVM_6model_alloc_type_check_cache(tc, 1);
+    MVM_ASSIGN_REF(tc, &(STABLE(type_obj)->header), type_check_cache[0], type_obj);
+    MVM_6model_set_type_check_cache(tc, STABLE(type_obj), type_check_cache, 1);
     attributes = ((MVMKnowHOWREPR *)self)->body.attributes;
 
     /* Next steps will allocate, so make sure we keep hold of the type
@@ -567,6 +568,10 @@ static void string_consts(MVMThreadContext *tc) {
     string_creator(stderr_bytes, "stderr_bytes");
     string_creator(buf_type, "buf_type");
     string_creator(write, "write");
+    string_creator(stdin_from, "stdin_from");
+    string_creator(stdout_to, "stdout_to");
+    string_creator(stderr_to, "stderr_to");
+    string_creator(stdout_pipe, "stdout_pipe");
     string_creator(nativeref, "nativeref");
     string_creator(refkind, "refkind");
     string_creator(positional, "positional");
@@ -578,6 +583,10 @@ static void string_consts(MVMThreadContext *tc) {
     string_creator(kind, "kind");
     string_creator(instrumented, "instrumented");
     string_creator(heap, "heap");
+    string_creator(path, "path");
+    string_creator(sampling, "sampling");
+    string_creator(interval, "interval");
+    string_creator(allocations, "allocations");
 }
 
 /* Drives the overall bootstrap process. */
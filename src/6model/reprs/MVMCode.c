@@ -137,7 +137,8 @@ MVM_PUBLIC MVMObject * MVM_code_location(MVMThreadContext *tc, MVMObject *code)
         MVM_exception_throw_adhoc(tc, "getcodelocation needs an object of MVMCode REPR, got %s instead", REPR(code)->name);
     } else {
         MVMObject * result = REPR(BOOTHash)->allocate(tc, STABLE(BOOTHash));
-        MVMBytecodeAnnotation *ann = MVM_bytecode_resolve_annotation(tc, &body->sf->body, 0);
+        MVMBytecodeAnnotation  ann_buf;
+        MVMBytecodeAnnotation *ann = MVM_bytecode_resolve_annotation(tc, &body->sf->body, 0, &ann_buf);
         MVMCompUnit            *cu = body->sf->body.cu;
         MVMint32           str_idx = ann ? ann->filename_string_heap_index : 0;
         MVMint32           line_nr = ann ? ann->line_number : 1;
@@ -160,7 +161,6 @@ MVM_PUBLIC MVMObject * MVM_code_location(MVMThreadContext *tc, MVMObject *code)
         } else {
             filename = cu->body.filename;
         }
-        MVM_free(ann);
 
         filename_boxed = MVM_repr_box_str(tc, tc->instance->boot_types.BOOTStr, filename);
 
@@ -91,6 +91,8 @@ static void gc_free(MVMThreadContext *tc, MVMObject *obj) {
     MVM_free(body->scs);
     MVM_free(body->scs_to_resolve);
     MVM_free(body->sc_handle_idxs);
+    if (body->preload)
+        MVM_preload_free_file(body->preload);
     switch (body->deallocate) {
     case MVM_DEALLOCATE_NOOP:
         break;
@@ -89,6 +89,9 @@ struct MVMCompUnitBody {
     MVMuint8  *string_heap_start;
     MVMuint8  *string_heap_read_limit;
 
+    /* The results of preloading the file, if it was; we own these. */
+    MVMPreloadedFile *preload;
+
     /* Serialized data, if any. */
     MVMint32  serialized_size;
     MVMuint8 *serialized;
@@ -111,6 +111,7 @@ static void copy_to(MVMThreadContext *tc, MVMSTable *st, void *src, MVMObject *d
     dest_body->num_handlers = src_body->num_handlers;
     dest_body->handlers     = MVM_malloc(src_body->num_handlers * sizeof(MVMFrameHandler));
     memcpy(dest_body->handlers, src_body->handlers, src_body->num_handlers * sizeof(MVMFrameHandler));
+    dest_body->handler_categories = src_body->handler_categories;
     dest_body->instrumentation_level = 0;
     dest_body->pool_index            = src_body->pool_index;
     dest_body->num_annotations       = src_body->num_annotations;
@@ -159,7 +160,7 @@ static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorkli
             for (j = 0; j < body->spesh_candidates[i].num_spesh_slots; j++)
                 MVM_gc_worklist_add(tc, worklist, &body->spesh_candidates[i].spesh_slots[j]);
             if (body->spesh_candidates[i].log_slots)
-                for (j = 0; j < body->spesh_candidates[i].num_log_slots * MVM_SPESH_LOG_RUNS; j++)
+                for (j = 0; j < body->spesh_candidates[i].num_log_slots * body->spesh_candidates[i].log_runs; j++)
                     MVM_gc_worklist_add(tc, worklist, &body->spesh_candidates[i].log_slots[j]);
             for (j = 0; j < body->spesh_candidates[i].num_inlines; j++)
                 MVM_gc_worklist_add(tc, worklist, &body->spesh_candidates[i].inlines[j].code);
@@ -167,6 +168,18 @@ static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorkli
                 MVM_spesh_graph_mark(tc, body->spesh_candidates[i].sg, worklist);
         }
     }
+
+    /* Method lookup inline caches. */
+    if (body->findmeth_caches) {
+        MVMuint32 i, j;
+        for (i = 0; i < body->num_findmeth_caches; i++) {
+            MVM_gc_worklist_add(tc, worklist, &body->findmeth_caches[i].name);
+            for (j = 0; j < MVM_FINDMETH_CACHE_TYPES; j++) {
+                MVM_gc_worklist_add(tc, worklist, &body->findmeth_caches[i].types[j]);
+                MVM_gc_worklist_add(tc, worklist, &body->findmeth_caches[i].methods[j]);
+            }
+        }
+    }
 }
 
 /* Called by the VM in order to free memory associated with this object. */
@@ -194,6 +207,7 @@ static void gc_free(MVMThreadContext *tc, MVMObject *obj) {
     for (i = 0; i < body->num_spesh_candidates; i++)
         MVM_spesh_candidate_destroy(tc, &body->spesh_candidates[i]);
     MVM_free(body->spesh_candidates);
+    MVM_free(body->findmeth_caches);
 }
 
 static const MVMStorageSpec storage_spec = {
@@ -286,6 +300,8 @@ static MVMuint64 unmanaged_size(MVMThreadContext *tc, MVMSTable *st, void *data)
             }
         }
 
+        size += sizeof(MVMFindMethCache) * body->num_findmeth_caches;
+
         if (body->instrumentation) {
             size += body->instrumentation->uninstrumented_bytecode_size;
             size += body->instrumentation->instrumented_bytecode_size;
@@ -349,7 +365,7 @@ static void describe_refs(MVMThreadContext *tc, MVMHeapSnapshotState *ss, MVMSTa
                     (MVMCollectable *)body->spesh_candidates[i].spesh_slots[j],
                     "Spesh slot entry");
             if (body->spesh_candidates[i].log_slots)
-                for (j = 0; j < body->spesh_candidates[i].num_log_slots * MVM_SPESH_LOG_RUNS; j++)
+                for (j = 0; j < body->spesh_candidates[i].num_log_slots * body->spesh_candidates[i].log_runs; j++)
                 MVM_profile_heap_add_collectable_rel_const_cstr(tc, ss,
                     (MVMCollectable *)body->spesh_candidates[i].log_slots[j],
                     "Spesh log slots");
@@ -368,6 +384,24 @@ static void describe_refs(MVMThreadContext *tc, MVMHeapSnapshotState *ss, MVMSTa
             }
         }
     }
+
+    /* Method lookup inline caches. */
+    if (body->findmeth_caches) {
+        MVMuint32 i, j;
+        for (i = 0; i < body->num_findmeth_caches; i++) {
+            MVM_profile_heap_add_collectable_rel_const_cstr(tc, ss,
+                (MVMCollectable *)body->findmeth_caches[i].name,
+                "Method lookup cache name");
+            for (j = 0; j < MVM_FINDMETH_CACHE_TYPES; j++) {
+                MVM_profile_heap_add_collectable_rel_const_cstr(tc, ss,
+                    (MVMCollectable *)body->findmeth_caches[i].types[j],
+                    "Method lookup cache type");
+                MVM_profile_heap_add_collectable_rel_const_cstr(tc, ss,
+                    (MVMCollectable *)body->findmeth_caches[i].methods[j],
+                    "Method lookup cache method");
+            }
+        }
+    }
 }
 
 /* Initializes the representation. */
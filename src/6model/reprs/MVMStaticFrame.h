@@ -64,6 +64,9 @@ struct MVMStaticFrameBody {
     /* The number of exception handlers this frame has. */
     MVMuint32 num_handlers;
 
+    /* Union of the category masks of the exception handlers. */
+    MVMuint32 handler_categories;
+
     /* The compilation unit unique ID of this frame. */
     MVMString *cuuid;
 
@@ -109,6 +112,20 @@ struct MVMStaticFrameBody {
 
     /* Extra profiling/instrumentation state. */
     MVMStaticFrameInstrumentation *instrumentation;
+
+    /* Number of findmeth instructions in the bytecode (counted when we
+     * validate it), and the inline caches for them, which are looked up by
+     * bytecode offset (see MVM_6model_find_method_cached). */
+    MVMuint32         num_findmeth_sites;
+    MVMuint32         num_findmeth_caches;
+    MVMFindMethCache *findmeth_caches;
+
+    /* What the MAST compiler recorded about the bytecode when it wrote it
+     * (version 6 and higher): a checksum of it and the number of findmeth
+     * instructions in it. Lets us skip validation if we trust the file. */
+    MVMuint8          has_frame_check;
+    MVMuint32         check_checksum;
+    MVMuint32         check_findmeth_sites;
 };
 struct MVMStaticFrame {
     MVMObject common;
@@ -126,5 +143,33 @@ struct MVMStaticFrameInstrumentation {
     MVMuint32        instrumented_bytecode_size;
 };
 
+/* The number of types a method lookup inline cache can hold, both in the
+ * interpreter and in specialized code. A site that sees more types than this
+ * is megamorphic, and just does the full lookup. */
+#define MVM_FINDMETH_CACHE_TYPES 4
+
+/* An inline cache for a findmeth instruction in unspecialized bytecode. The
+ * name and type slots are each written only once; the name is written first
+ * and the method before the type, so a matching type always has a method
+ * there, for the name there. When a type's method cache is replaced, the
+ * method for it is replaced too, then its generation. */
+struct MVMFindMethCache {
+    /* The bytecode offset of the findmeth instruction plus one, or zero if
+     * the cache was not yet claimed by a site. */
+    AO_t site;
+
+    /* The method name looked up. The original and instrumented bytecode
+     * share the caches, and may have different findmeths at an offset. */
+    MVMString *name;
+
+    /* Types seen and the methods they resolved to. */
+    MVMSTable *types[MVM_FINDMETH_CACHE_TYPES];
+    MVMObject *methods[MVM_FINDMETH_CACHE_TYPES];
+
+    /* The method cache generation of each type the method was found with;
+     * an entry for an older generation is a miss. */
+    MVMuint32  gens[MVM_FINDMETH_CACHE_TYPES];
+};
+
 /* Function for REPR setup. */
 const MVMREPROps * MVMStaticFrame_initialize(MVMThreadContext *tc);
@@ -101,7 +101,8 @@ static void switch_endian(char *bytes, size_t size)
 }
 #endif
 
-/* Base64 encoding */
+/* Base64 encoding. Goes a whole group of three bytes at a time, and only
+ * works out the padding at the end. */
 static char * base64_encode(const void *buf, size_t size)
 {
     static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -112,30 +113,24 @@ static char * base64_encode(const void *buf, size_t size)
     const unsigned char* q = (const unsigned char*) buf;
     size_t i = 0;
 
-    while (i < size) {
-        int c = q[i++];
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-
-        *p++ = base64[(c & 0x00fc0000) >> 18];
-        *p++ = base64[(c & 0x0003f000) >> 12];
-
-        if (i > size + 1)
-            *p++ = '=';
-        else
-            *p++ = base64[(c & 0x00000fc0) >> 6];
+    while (i + 3 <= size) {
+        MVMuint32 c = ((MVMuint32)q[i] << 16) | ((MVMuint32)q[i + 1] << 8) | q[i + 2];
+        p[0] = base64[(c >> 18) & 0x3f];
+        p[1] = base64[(c >> 12) & 0x3f];
+        p[2] = base64[(c >> 6) & 0x3f];
+        p[3] = base64[c & 0x3f];
+        p += 4;
+        i += 3;
+    }
 
-        if (i > size)
-            *p++ = '=';
-        else
-            *p++ = base64[c & 0x0000003f];
+    if (i < size) {
+        MVMuint32 c = (MVMuint32)q[i] << 16;
+        if (i + 1 < size)
+            c |= (MVMuint32)q[i + 1] << 8;
+        *p++ = base64[(c >> 18) & 0x3f];
+        *p++ = base64[(c >> 12) & 0x3f];
+        *p++ = i + 1 < size ? base64[(c >> 6) & 0x3f] : '=';
+        *p++ = '=';
     }
 
     *p = 0;
@@ -143,28 +138,31 @@ static char * base64_encode(const void *buf, size_t size)
     return str;
 }
 
-/* Base64 decoding */
-static int POS(char c)
-{
-    /* XXX TODO: investigate whether enumerating all 256 cases of
-     * this in a switch/case can help the compiler turn it into a
-     * jump table instead of a bunch of comparisons (if it doesn't
-     * already, of course!)... */
-    if (c>='A' && c<='Z') return c - 'A';
-    if (c>='a' && c<='z') return c - 'a' + 26;
-    if (c>='0' && c<='9') return c - '0' + 52;
-    if (c == '+') return 62;
-    if (c == '/') return 63;
-    if (c == '=') return -1;
-    return -2;
-}
+/* Base64 decoding. The table maps each character to its value, with -1 for
+ * the padding character and -2 for anything that can't appear. */
+static const signed char base64_pos[256] = {
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, 62, -2, -2, -2, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -2, -2, -2, -1, -2, -2,
+    -2,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -2, -2, -2, -2, -2,
+    -2, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2,
+    -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2
+};
 static void * base64_decode(const char *s, size_t *data_len)
 {
-    const char *p;
+    const unsigned char *p;
     unsigned char *q, *data;
-    /* XXX TODO: investigate whether putting these n[4] into 4
-     * separate locals helps the compiler optimize them better.. */
-    int n[4] = {-1, -1, -1, -1};
+    int n0 = -1, n1 = -1, n2 = -1, n3 = -1;
 
     size_t len = strlen(s);
     if (len % 4) {
@@ -174,34 +172,30 @@ static void * base64_decode(const char *s, size_t *data_len)
     data = (unsigned char*) MVM_malloc(len/4*3);
     q = (unsigned char*) data;
 
-    for (p = s; *p; ) {
-        n[0] = POS(*p++);
-        n[1] = POS(*p++);
-        n[2] = POS(*p++);
-        n[3] = POS(*p++);
-
-        /* XXX TODO: investigate jump table possibility here too,
-         * or at least collapse some of the branches... */
-        if (n[0] == -2
-         || n[1] == -2
-         || n[2] == -2
-         || n[3] == -2
-         || n[0] == -1
-         || n[1] == -1
-         || (n[2] == -1 && n[3] != -1)) {
-            MVM_free(data);
-            return NULL;
+    for (p = (const unsigned char *)s; *p; p += 4) {
+        n0 = base64_pos[p[0]];
+        n1 = base64_pos[p[1]];
+        n2 = base64_pos[p[2]];
+        n3 = base64_pos[p[3]];
+
+        /* Valid characters are all non-negative, so in the common case of a
+         * group with no padding one check will do. */
+        if ((n0 | n1 | n2 | n3) < 0) {
+            if (n0 < 0 || n1 < 0 || n2 == -2 || n3 == -2 || (n2 == -1 && n3 != -1)) {
+                MVM_free(data);
+                return NULL;
+            }
         }
 
-        q[0] = (n[0] << 2) + (n[1] >> 4);
-        if (n[2] != -1)
-            q[1] = ((n[1] & 15) << 4) + (n[2] >> 2);
-        if (n[3] != -1)
-            q[2] = ((n[2] & 3) << 6) + n[3];
+        q[0] = (n0 << 2) + (n1 >> 4);
+        if (n2 != -1)
+            q[1] = ((n1 & 15) << 4) + (n2 >> 2);
+        if (n3 != -1)
+            q[2] = ((n2 & 3) << 6) + n3;
         q += 3;
     }
 
-    *data_len = q-data - (n[2]==-1) - (n[3]==-1);
+    *data_len = q-data - (n2==-1) - (n3==-1);
 
     return data;
 }
@@ -315,10 +309,21 @@ static void get_stable_ref_info(MVMThreadContext *tc, MVMSerializationWriter *wr
     *sc_idx = (MVMuint32)MVM_sc_find_stable_idx(tc, MVM_sc_get_stable_sc(tc, st), st);
 }
 
-/* Expands current target storage as needed. */
+/* Expands current target storage as needed. Doubling once isn't always
+ * enough (a long string or blob may need far more than that), so keep on
+ * doubling until it fits and reallocate just the once. */
 static void expand_storage_if_needed(MVMThreadContext *tc, MVMSerializationWriter *writer, MVMint64 need) {
-    if (*(writer->cur_write_offset) + need > *(writer->cur_write_limit)) {
-        *(writer->cur_write_limit) *= 2;
+    MVMuint64 wanted = (MVMuint64)*(writer->cur_write_offset) + need;
+    if (wanted > *(writer->cur_write_limit)) {
+        MVMuint64 limit = *(writer->cur_write_limit);
+        if (limit == 0)
+            limit = 64;
+        while (limit < wanted)
+            limit *= 2;
+        if (limit > 0xFFFFFFFFULL)
+            MVM_exception_throw_adhoc(tc,
+                "Serialization error: segment would exceed 4GB");
+        *(writer->cur_write_limit)  = (MVMuint32)limit;
         *(writer->cur_write_buffer) = (char *)MVM_realloc(*(writer->cur_write_buffer),
             *(writer->cur_write_limit));
     }
@@ -772,29 +777,28 @@ void MVM_serialization_write_stable_ref(MVMThreadContext *tc, MVMSerializationWr
     write_sc_id_idx(tc, writer, sc_id, idx);
 }
 
-/* Concatenates the various output segments into a single binary MVMString. */
-static MVMString * concatenate_outputs(MVMThreadContext *tc, MVMSerializationWriter *writer) {
-    char      *output      = NULL;
-    char      *output_b64  = NULL;
-    MVMuint32  output_size = 0;
-    MVMuint32  offset      = 0;
-    MVMString *result;
-
-    /* Calculate total size. */
-    output_size += MVM_ALIGN_SECTION(HEADER_SIZE);
-    output_size += MVM_ALIGN_SECTION(writer->root.num_dependencies * DEP_TABLE_ENTRY_SIZE);
-    output_size += MVM_ALIGN_SECTION(writer->root.num_stables * STABLES_TABLE_ENTRY_SIZE);
-    output_size += MVM_ALIGN_SECTION(writer->stables_data_offset);
-    output_size += MVM_ALIGN_SECTION(writer->root.num_objects * OBJECTS_TABLE_ENTRY_SIZE);
-    output_size += MVM_ALIGN_SECTION(writer->objects_data_offset);
-    output_size += MVM_ALIGN_SECTION(writer->root.num_closures * CLOSURES_TABLE_ENTRY_SIZE);
-    output_size += MVM_ALIGN_SECTION(writer->root.num_contexts * CONTEXTS_TABLE_ENTRY_SIZE);
-    output_size += MVM_ALIGN_SECTION(writer->contexts_data_offset);
-    output_size += MVM_ALIGN_SECTION(writer->root.num_repos * REPOS_TABLE_ENTRY_SIZE);
-    output_size += MVM_ALIGN_SECTION(writer->param_interns_data_offset);
-
-    /* Allocate a buffer that size. */
-    output = (char *)MVM_malloc(output_size);
+/* Works out how big the output will be once the various segments are put
+ * together. */
+static MVMuint32 output_size(MVMSerializationWriter *writer) {
+    MVMuint32 size = 0;
+    size += MVM_ALIGN_SECTION(HEADER_SIZE);
+    size += MVM_ALIGN_SECTION(writer->root.num_dependencies * DEP_TABLE_ENTRY_SIZE);
+    size += MVM_ALIGN_SECTION(writer->root.num_stables * STABLES_TABLE_ENTRY_SIZE);
+    size += MVM_ALIGN_SECTION(writer->stables_data_offset);
+    size += MVM_ALIGN_SECTION(writer->root.num_objects * OBJECTS_TABLE_ENTRY_SIZE);
+    size += MVM_ALIGN_SECTION(writer->objects_data_offset);
+    size += MVM_ALIGN_SECTION(writer->root.num_closures * CLOSURES_TABLE_ENTRY_SIZE);
+    size += MVM_ALIGN_SECTION(writer->root.num_contexts * CONTEXTS_TABLE_ENTRY_SIZE);
+    size += MVM_ALIGN_SECTION(writer->contexts_data_offset);
+    size += MVM_ALIGN_SECTION(writer->root.num_repos * REPOS_TABLE_ENTRY_SIZE);
+    size += MVM_ALIGN_SECTION(writer->param_interns_data_offset);
+    return size;
+}
+
+/* Writes the header and the various output segments into a buffer of the
+ * size output_size gave. */
+static void write_outputs(MVMThreadContext *tc, MVMSerializationWriter *writer, char *output, MVMuint32 size) {
+    MVMuint32 offset = 0;
 
     /* Write version into header. */
     write_int32(output, 0, CURRENT_VERSION);
@@ -868,24 +872,22 @@ static MVMString * concatenate_outputs(MVMThreadContext *tc, MVMSerializationWri
     offset += MVM_ALIGN_SECTION(writer->param_interns_data_offset);
 
     /* Sanity check. */
-    if (offset != output_size)
+    if (offset != size)
         MVM_exception_throw_adhoc(tc,
             "Serialization sanity check failed: offset != output_size");
+}
 
-    /* If we are compiling at present, then just stash the output for later
-     * incorporation into the bytecode file. */
-    if (tc->compiling_scs && MVM_repr_elems(tc, tc->compiling_scs) &&
-            MVM_repr_at_pos_o(tc, tc->compiling_scs, 0) == (MVMObject *)writer->root.sc) {
-        if (tc->serialized)
-            MVM_free(tc->serialized);
-        tc->serialized = output;
-        tc->serialized_size = output_size;
-        tc->serialized_string_heap = writer->root.string_heap;
-        return NULL;
-    }
+/* Concatenates the various output segments into a single binary MVMString. */
+static MVMString * concatenate_outputs(MVMThreadContext *tc, MVMSerializationWriter *writer) {
+    MVMuint32  size   = output_size(writer);
+    char      *output = (char *)MVM_malloc(size);
+    char      *output_b64;
+    MVMString *result;
+
+    write_outputs(tc, writer, output, size);
 
     /* Base 64 encode. */
-    output_b64 = base64_encode(output, output_size);
+    output_b64 = base64_encode(output, size);
     MVM_free(output);
     if (output_b64 == NULL)
         MVM_exception_throw_adhoc(tc,
@@ -897,6 +899,40 @@ static MVMString * concatenate_outputs(MVMThreadContext *tc, MVMSerializationWri
     return result;
 }
 
+/* Frees a writer and the segments it wrote. */
+static void free_writer(MVMSerializationWriter *writer) {
+    MVM_free(writer->root.dependent_scs);
+    MVM_free(writer->root.dependencies_table);
+    MVM_free(writer->root.stables_table);
+    MVM_free(writer->root.stables_data);
+    MVM_free(writer->root.objects_table);
+    MVM_free(writer->root.objects_data);
+    MVM_free(writer->root.closures_table);
+    MVM_free(writer->root.contexts_table);
+    MVM_free(writer->root.contexts_data);
+    MVM_free(writer->root.param_interns_data);
+    MVM_free(writer->root.repos_table);
+    MVM_free(writer);
+}
+
+/* Gets the size of the serialized data stashed away while compiling, or 0
+ * if there is none. */
+MVMuint32 MVM_serialization_stashed_size(MVMThreadContext *tc) {
+    return tc->serialized_writer ? output_size(tc->serialized_writer) : 0;
+}
+
+/* Writes the serialized data stashed away while compiling straight into the
+ * bytecode output, which must have room for MVM_serialization_stashed_size
+ * bytes, and then lets go of it. */
+void MVM_serialization_write_stashed(MVMThreadContext *tc, char *output) {
+    MVMSerializationWriter *writer = tc->serialized_writer;
+    if (writer) {
+        write_outputs(tc, writer, output, output_size(writer));
+        tc->serialized_writer = NULL;
+        free_writer(writer);
+    }
+}
+
 /* Serializes the possibly-not-deserialized HOW. */
 static void serialize_how_lazy(MVMThreadContext *tc, MVMSerializationWriter *writer, MVMSTable *st) {
     if (st->HOW) {
@@ -1388,24 +1424,21 @@ MVMString * MVM_serialization_serialize(MVMThreadContext *tc, MVMSerializationCo
     /* Start serializing. */
     serialize(tc, writer);
 
-    /* Build a single result out of the serialized data; note if we're in the
-     * compiler pipeline this will return null and stash the output to write
-     * to a bytecode file later. */
-    result = concatenate_outputs(tc, writer);
-
-    /* Clear up afterwards. */
-    MVM_free(writer->root.dependent_scs);
-    MVM_free(writer->root.dependencies_table);
-    MVM_free(writer->root.stables_table);
-    MVM_free(writer->root.stables_data);
-    MVM_free(writer->root.objects_table);
-    MVM_free(writer->root.objects_data);
-    MVM_free(writer->root.closures_table);
-    MVM_free(writer->root.contexts_table);
-    MVM_free(writer->root.contexts_data);
-    MVM_free(writer->root.param_interns_data);
-    MVM_free(writer->root.repos_table);
-    MVM_free(writer);
+    /* If we are compiling at present, then stash the writer away, and its
+     * segments will be written straight into the bytecode file later, with
+     * no base64 and no copying them together here first. Otherwise, build a
+     * single result out of the serialized data. */
+    if (tc->compiling_scs && MVM_repr_elems(tc, tc->compiling_scs) &&
+            MVM_repr_at_pos_o(tc, tc->compiling_scs, 0) == (MVMObject *)sc) {
+        if (tc->serialized_writer)
+            free_writer(tc->serialized_writer);
+        tc->serialized_writer      = writer;
+        tc->serialized_string_heap = writer->root.string_heap;
+    }
+    else {
+        result = concatenate_outputs(tc, writer);
+        free_writer(writer);
+    }
 
     /* Exit gen2 allocation. */
     MVM_gc_allocate_gen2_default_clear(tc);
@@ -2415,6 +2448,7 @@ static void deserialize_stable(MVMThreadContext *tc, MVMSerializationReader *rea
     MVMString *hll_name;
     MVMuint8 flags;
     MVMuint8 mode;
+    MVMint64 type_check_elems;
 
     /* Set STable read position, and set current read buffer to the correct thing. */
     reader->stables_data_offset = read_int32(st_table_row, 4);
@@ -2429,13 +2463,18 @@ static void deserialize_stable(MVMThreadContext *tc, MVMSerializationReader *rea
 
     /* Method cache. */
     deserialize_method_cache_lazy(tc, st, reader);
+    st->method_cache_gen++;
 
     /* Type check cache. */
-    st->type_check_cache_length = MVM_serialization_read_varint(tc, reader);
-    if (st->type_check_cache_length > 0) {
-        st->type_check_cache = (MVMObject **)MVM_malloc(st->type_check_cache_length * sizeof(MVMObject *));
-        for (i = 0; i < st->type_check_cache_length; i++)
-            MVM_ASSIGN_REF(tc, &(st->header), st->type_check_cache[i], MVM_serialization_read_ref(tc, reader));
+    type_check_elems = MVM_serialization_read_varint(tc, reader);
+    if (type_check_elems > 0) {
+        MVMObject **cache = MVM_6model_alloc_type_check_cache(tc, (MVMuint16)type_check_elems);
+        for (i = 0; i < type_check_elems; i++)
+            MVM_ASSIGN_REF(tc, &(st->header), cache[i], MVM_serialization_read_ref(tc, reader));
+        MVM_6model_set_type_check_cache(tc, st, cache, (MVMuint16)type_check_elems);
+    }
+    else {
+        MVM_6model_set_type_check_cache(tc, st, NULL, 0);
     }
 
     /* Mode flags. */
@@ -172,6 +172,8 @@ void MVM_serialization_deserialize(MVMThreadContext *tc, MVMSerializationContext
 MVMString * MVM_sha1(MVMThreadContext *tc, MVMString *str);
 MVMString * MVM_serialization_serialize(MVMThreadContext *tc, MVMSerializationContext *sc,
     MVMObject *empty_string_heap);
+MVMuint32 MVM_serialization_stashed_size(MVMThreadContext *tc);
+void MVM_serialization_write_stashed(MVMThreadContext *tc, char *output);
 
 /* Functions for demanding an object/STable/code be made available (that is,
  * by lazily deserializing it). */
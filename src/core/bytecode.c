@@ -2,11 +2,13 @@
 
 /* Some constants. */
 #define HEADER_SIZE                 92
+#define HEADER_SIZE_V6              100
 #define MIN_BYTECODE_VERSION        5
-#define MAX_BYTECODE_VERSION        5
+#define MAX_BYTECODE_VERSION        6
 #define FRAME_HEADER_SIZE           (11 * 4 + 3 * 2)
 #define FRAME_HANDLER_SIZE          (4 * 4 + 2 * 2)
 #define FRAME_SLV_SIZE              (2 * 2 + 2 * 4)
+#define FRAME_CHECK_SIZE            (2 * 4)
 #define SCDEP_HEADER_OFFSET         12
 #define EXTOP_HEADER_OFFSET         20
 #define FRAME_HEADER_OFFSET         28
@@ -17,6 +19,7 @@
 #define ANNOTATION_HEADER_OFFSET    68
 #define HLL_NAME_HEADER_OFFSET      76
 #define SPECIAL_FRAME_HEADER_OFFSET 80
+#define FRAME_CHECK_HEADER_OFFSET   92
 
 /* Frame flags. */
 #define FRAME_FLAG_EXIT_HANDLER     1
@@ -56,6 +59,9 @@ typedef struct {
     MVMuint8  *annotation_seg;
     MVMuint32  annotation_size;
 
+    /* The frame checks segment, if any. */
+    MVMuint8  *frame_check_seg;
+
     /* HLL name string index */
     MVMuint32  hll_str_idx;
 
@@ -148,6 +154,8 @@ static ReaderState * dissect_bytecode(MVMThreadContext *tc, MVMCompUnit *cu) {
         MVM_exception_throw_adhoc(tc, "Bytecode stream version too low");
     if (version > MAX_BYTECODE_VERSION)
         MVM_exception_throw_adhoc(tc, "Bytecode stream version too high");
+    if (version >= 6 && cu_body->data_size < HEADER_SIZE_V6)
+        MVM_exception_throw_adhoc(tc, "Bytecode stream shorter than header");
 
     /* Allocate reader state. */
     rs = MVM_malloc(sizeof(ReaderState));
@@ -233,6 +241,24 @@ static ReaderState * dissect_bytecode(MVMThreadContext *tc, MVMCompUnit *cu) {
     rs->annotation_seg  = cu_body->data_start + offset;
     rs->annotation_size = size;
 
+    /* Locate frame checks (version 6 and higher); there's either none or
+     * one per frame. */
+    if (version >= 6) {
+        offset = read_int32(cu_body->data_start, FRAME_CHECK_HEADER_OFFSET);
+        size = read_int32(cu_body->data_start, FRAME_CHECK_HEADER_OFFSET + 4);
+        if (size) {
+            if (size != rs->expected_frames) {
+                cleanup_all(tc, rs);
+                MVM_exception_throw_adhoc(tc, "Frame checks segment has wrong number of entries");
+            }
+            if (offset > cu_body->data_size || offset + size * FRAME_CHECK_SIZE > cu_body->data_size) {
+                cleanup_all(tc, rs);
+                MVM_exception_throw_adhoc(tc, "Frame checks segment overflows end of stream");
+            }
+            rs->frame_check_seg = cu_body->data_start + offset;
+        }
+    }
+
     /* Locate HLL name */
     rs->hll_str_idx = read_int32(cu_body->data_start, HLL_NAME_HEADER_OFFSET);
 
@@ -250,6 +276,36 @@ static ReaderState * dissect_bytecode(MVMThreadContext *tc, MVMCompUnit *cu) {
     return rs;
 }
 
+/* Computes the checksum of a frame's bytecode that the MAST compiler records
+ * for it (32-bit FNV-1a). */
+MVMuint32 MVM_bytecode_checksum(const MVMuint8 *bytecode, MVMuint32 size) {
+    MVMuint32 hash = 2166136261U;
+    MVMuint32 i;
+    for (i = 0; i < size; i++) {
+        hash ^= bytecode[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/* Locates the string heap of a bytecode file and says how many strings it
+ * holds. Needs no thread context, so the preloader's workers can use it;
+ * hands back NULL if the header doesn't look right, leaving it to the full
+ * unpack to complain. */
+MVMuint8 * MVM_bytecode_locate_string_heap(MVMuint8 *data, MVMuint32 size, MVMuint32 *num_strings) {
+    MVMuint32 version, offset;
+    if (size < HEADER_SIZE || memcmp(data, "MOARVM\r\n", 8) != 0)
+        return NULL;
+    version = read_int32(data, 8);
+    if (version < MIN_BYTECODE_VERSION || version > MAX_BYTECODE_VERSION)
+        return NULL;
+    offset = read_int32(data, STRING_HEADER_OFFSET);
+    if (offset > size)
+        return NULL;
+    *num_strings = read_int32(data, STRING_HEADER_OFFSET + 4);
+    return data + offset;
+}
+
 /* Loads the SC dependencies list. */
 static void deserialize_sc_deps(MVMThreadContext *tc, MVMCompUnit *cu, ReaderState *rs) {
     MVMCompUnitBody *cu_body = &cu->body;
@@ -524,6 +580,14 @@ static MVMStaticFrame ** deserialize_frames(MVMThreadContext *tc, MVMCompUnit *c
             static_frame_body->code_obj_sc_idx     = read_int32(pos, 46);
         }
 
+        /* Read what the compiler recorded about the bytecode, if anything. */
+        if (rs->frame_check_seg) {
+            MVMuint8 *check = rs->frame_check_seg + i * FRAME_CHECK_SIZE;
+            static_frame_body->has_frame_check      = 1;
+            static_frame_body->check_checksum       = read_int32(check, 0);
+            static_frame_body->check_findmeth_sites = read_int32(check, 4);
+        }
+
         /* Associate frame with compilation unit. */
         MVM_ASSIGN_REF(tc, &(static_frame->common.header), static_frame_body->cu, cu);
 
@@ -650,6 +714,8 @@ void MVM_bytecode_finish_frame(MVMThreadContext *tc, MVMCompUnit *cu,
                 pos += 2;
             }
         }
+        sf->body.handler_categories = MVM_exception_handler_categories(
+            sf->body.handlers, sf->body.num_handlers);
     }
 
     /* Allocate default lexical environment storage. */
@@ -896,26 +962,32 @@ void MVM_bytecode_unpack(MVMThreadContext *tc, MVMCompUnit *cu) {
     MVM_gc_allocate_gen2_default_clear(tc);
 }
 
-/* returns the annotation for that bytecode offset */
-MVMBytecodeAnnotation * MVM_bytecode_resolve_annotation(MVMThreadContext *tc, MVMStaticFrameBody *sfb, MVMuint32 offset) {
-    MVMBytecodeAnnotation *ba = NULL;
-    MVMuint32 i;
+/* Finds the annotation for a bytecode offset, filling out the one passed
+ * in and returning it, or returning NULL if the frame has none. Annotations
+ * are written in bytecode offset order, so we binary search for the last one
+ * that starts at or before the offset (or take the first, if none do). */
+MVMBytecodeAnnotation * MVM_bytecode_resolve_annotation(MVMThreadContext *tc, MVMStaticFrameBody *sfb,
+        MVMuint32 offset, MVMBytecodeAnnotation *ba) {
+    MVMuint8 *cur_anno;
+    MVMuint32 lo, hi;
 
-    if (sfb->num_annotations && offset < sfb->bytecode_size) {
-        MVMuint8 *cur_anno = sfb->annotations_data;
-        for (i = 0; i < sfb->num_annotations; i++) {
-            MVMint32 ann_offset = read_int32(cur_anno, 0);
-            if (ann_offset > offset)
-                break;
-            cur_anno += 12;
-        }
-        if (i)
-            cur_anno -= 12;
-        ba = MVM_malloc(sizeof(MVMBytecodeAnnotation));
-        ba->bytecode_offset = read_int32(cur_anno, 0);
-        ba->filename_string_heap_index = read_int32(cur_anno, 4);
-        ba->line_number = read_int32(cur_anno, 8);
+    if (!sfb->num_annotations || offset >= sfb->bytecode_size)
+        return NULL;
+
+    /* Find the first annotation starting after the offset. */
+    lo = 0;
+    hi = sfb->num_annotations;
+    while (lo < hi) {
+        MVMuint32 mid = lo + (hi - lo) / 2;
+        if (read_int32(sfb->annotations_data, mid * 12) > offset)
+            hi = mid;
+        else
+            lo = mid + 1;
     }
 
+    cur_anno = sfb->annotations_data + (lo ? lo - 1 : 0) * 12;
+    ba->bytecode_offset = read_int32(cur_anno, 0);
+    ba->filename_string_heap_index = read_int32(cur_anno, 4);
+    ba->line_number = read_int32(cur_anno, 8);
     return ba;
 }
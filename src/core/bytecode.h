@@ -6,6 +6,9 @@ struct MVMBytecodeAnnotation {
 };
 
 void MVM_bytecode_unpack(MVMThreadContext *tc, MVMCompUnit *cu);
-MVMBytecodeAnnotation * MVM_bytecode_resolve_annotation(MVMThreadContext *tc, MVMStaticFrameBody *sfb, MVMuint32 offset);
+MVMBytecodeAnnotation * MVM_bytecode_resolve_annotation(MVMThreadContext *tc, MVMStaticFrameBody *sfb,
+    MVMuint32 offset, MVMBytecodeAnnotation *ba);
 void MVM_bytecode_finish_frame(MVMThreadContext *tc, MVMCompUnit *cu, MVMStaticFrame *sf, MVMint32 dump_only);
 MVMuint8 MVM_bytecode_find_static_lexical_scref(MVMThreadContext *tc, MVMCompUnit *cu, MVMStaticFrame *sf, MVMuint16 index, MVMint32 *sc, MVMint32 *id);
+MVMuint32 MVM_bytecode_checksum(const MVMuint8 *bytecode, MVMuint32 size);
+MVMuint8 * MVM_bytecode_locate_string_heap(MVMuint8 *data, MVMuint32 size, MVMuint32 *num_strings);
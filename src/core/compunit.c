@@ -6,8 +6,10 @@
 #define O_RDONLY _O_RDONLY
 #endif
 
-/* Creates a compilation unit from a byte array. */
-MVMCompUnit * MVM_cu_from_bytes(MVMThreadContext *tc, MVMuint8 *bytes, MVMuint32 size) {
+/* Creates a compilation unit from a byte array, with the preloading of the
+ * file it came from, if any. */
+static MVMCompUnit * cu_from_bytes(MVMThreadContext *tc, MVMuint8 *bytes, MVMuint32 size,
+                                   MVMPreloadedFile *preload) {
     /* Create compilation unit data structure. Allocate it in gen2 always, so
      * it will never move (the JIT relies on this). */
     MVMCompUnit *cu;
@@ -15,6 +17,7 @@ MVMCompUnit * MVM_cu_from_bytes(MVMThreadContext *tc, MVMuint8 *bytes, MVMuint32
     cu = (MVMCompUnit *)MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTCompUnit);
     cu->body.data_start = bytes;
     cu->body.data_size  = size;
+    cu->body.preload    = preload;
     MVM_gc_allocate_gen2_default_clear(tc);
 
     /* Process the input. */
@@ -30,13 +33,20 @@ MVMCompUnit * MVM_cu_from_bytes(MVMThreadContext *tc, MVMuint8 *bytes, MVMuint32
     return cu;
 }
 
+/* Creates a compilation unit from a byte array. */
+MVMCompUnit * MVM_cu_from_bytes(MVMThreadContext *tc, MVMuint8 *bytes, MVMuint32 size) {
+    return cu_from_bytes(tc, bytes, size, NULL);
+}
+
 /* Loads a compilation unit from a bytecode file, mapping it into memory. */
 MVMCompUnit * MVM_cu_map_from_file(MVMThreadContext *tc, const char *filename) {
-    MVMCompUnit *cu          = NULL;
-    void        *block       = NULL;
-    void        *handle      = NULL;
+    MVMCompUnit      *cu          = NULL;
+    void             *block       = NULL;
+    void             *handle      = NULL;
+    MVMPreloadedFile *preload;
     uv_file      fd;
     MVMuint64    size;
+    MVMint64     mtime_sec, mtime_nsec;
     uv_fs_t req;
 
     /* Ensure the file exists, and get its size. */
@@ -44,24 +54,35 @@ MVMCompUnit * MVM_cu_map_from_file(MVMThreadContext *tc, const char *filename) {
         MVM_exception_throw_adhoc(tc, "While looking for '%s': %s", filename, uv_strerror(req.result));
     }
 
-    size = req.statbuf.st_size;
+    size       = req.statbuf.st_size;
+    mtime_sec  = req.statbuf.st_mtim.tv_sec;
+    mtime_nsec = req.statbuf.st_mtim.tv_nsec;
 
-    /* Map the bytecode file into memory. */
-    if ((fd = uv_fs_open(tc->loop, &req, filename, O_RDONLY, 0, NULL)) < 0) {
-        MVM_exception_throw_adhoc(tc, "While trying to open '%s': %s", filename, uv_strerror(req.result));
+    /* If the file was preloaded, take over its mapping. */
+    preload = MVM_preload_claim(tc, filename, size, mtime_sec, mtime_nsec);
+    if (preload) {
+        block          = preload->block;
+        handle         = preload->handle;
+        preload->block = NULL;
     }
+    else {
+        /* Map the bytecode file into memory. */
+        if ((fd = uv_fs_open(tc->loop, &req, filename, O_RDONLY, 0, NULL)) < 0) {
+            MVM_exception_throw_adhoc(tc, "While trying to open '%s': %s", filename, uv_strerror(req.result));
+        }
 
-    if ((block = MVM_platform_map_file(fd, &handle, (size_t)size, 0)) == NULL) {
-        /* FIXME: check errno or GetLastError() */
-        MVM_exception_throw_adhoc(tc, "Could not map file '%s' into memory: %s", filename, "FIXME");
-    }
+        if ((block = MVM_platform_map_file(fd, &handle, (size_t)size, 0)) == NULL) {
+            /* FIXME: check errno or GetLastError() */
+            MVM_exception_throw_adhoc(tc, "Could not map file '%s' into memory: %s", filename, "FIXME");
+        }
 
-    if (uv_fs_close(tc->loop, &req, fd, NULL) < 0) {
-        MVM_exception_throw_adhoc(tc, "Failed to close filehandle: %s", uv_strerror(req.result));
+        if (uv_fs_close(tc->loop, &req, fd, NULL) < 0) {
+            MVM_exception_throw_adhoc(tc, "Failed to close filehandle: %s", uv_strerror(req.result));
+        }
     }
 
     /* Turn it into a compilation unit. */
-    cu = MVM_cu_from_bytes(tc, (MVMuint8 *)block, (MVMuint32)size);
+    cu = cu_from_bytes(tc, (MVMuint8 *)block, (MVMuint32)size, preload);
     cu->body.handle = handle;
     cu->body.deallocate = MVM_DEALLOCATE_UNMAP;
     return cu;
@@ -160,29 +181,39 @@ static void compute_fast_table_upto(MVMThreadContext *tc, MVMCompUnit *cu, MVMui
     cu->body.string_heap_fast_table_top = end_bin;
 }
 MVMString * MVM_cu_obtain_string(MVMThreadContext *tc, MVMCompUnit *cu, MVMuint32 idx) {
-    MVMuint32  cur_idx;
+    MVMuint32  cur_idx, fast_bin;
     MVMuint8  *cur_pos;
     MVMuint8  *limit = cu->body.string_heap_read_limit;
 
-    /* Make sure we've enough entries in the fast table to jump close to where
-     * the string will be. */
-    MVMuint32 fast_bin = idx / MVM_STRING_FAST_TABLE_SPAN;
-    if (fast_bin > cu->body.string_heap_fast_table_top)
-        compute_fast_table_upto(tc, cu, fast_bin);
-
-    /* Scan from that position to find the string we need. */
-    cur_idx = fast_bin * MVM_STRING_FAST_TABLE_SPAN;
-    cur_pos = cu->body.string_heap_start + cu->body.string_heap_fast_table[fast_bin];
-    while (cur_idx != idx) {
-        if (cur_pos + 4 < limit) {
-            MVMuint32 bytes = read_uint32(cur_pos) >> 1;
-            cur_pos += 4 + bytes + (bytes & 3 ? 4 - (bytes & 3) : 0);
-        }
-        else {
-            MVM_exception_throw_adhoc(tc,
-                "Attempt to read past end of string heap when locating string");
+    /* If the file was preloaded, we may have the string decoded already, and
+     * otherwise know where it is. */
+    if (cu->body.preload && idx < cu->body.preload->num_strings) {
+        MVMString *s = MVM_preload_string(tc, cu, idx);
+        if (s)
+            return s;
+        cur_pos = cu->body.string_heap_start + cu->body.preload->string_offsets[idx];
+    }
+    else {
+        /* Make sure we've enough entries in the fast table to jump close to
+         * where the string will be. */
+        fast_bin = idx / MVM_STRING_FAST_TABLE_SPAN;
+        if (fast_bin > cu->body.string_heap_fast_table_top)
+            compute_fast_table_upto(tc, cu, fast_bin);
+
+        /* Scan from that position to find the string we need. */
+        cur_idx = fast_bin * MVM_STRING_FAST_TABLE_SPAN;
+        cur_pos = cu->body.string_heap_start + cu->body.string_heap_fast_table[fast_bin];
+        while (cur_idx != idx) {
+            if (cur_pos + 4 < limit) {
+                MVMuint32 bytes = read_uint32(cur_pos) >> 1;
+                cur_pos += 4 + bytes + (bytes & 3 ? 4 - (bytes & 3) : 0);
+            }
+            else {
+                MVM_exception_throw_adhoc(tc,
+                    "Attempt to read past end of string heap when locating string");
+            }
+            cur_idx++;
         }
-        cur_idx++;
     }
 
     /* Read the string. */
@@ -82,6 +82,17 @@ static MVMint32 handler_can_handle(MVMFrame *f, MVMFrameHandler *fh, MVMint32 ca
         || ((category_mask & MVM_EX_CAT_CONTROL) && cat != MVM_EX_CAT_CATCH);
 }
 
+/* Works out the union of the category masks of a set of handlers. This is
+ * kept with a frame's handlers, so a throw can skip over frames that can't
+ * possibly handle it without looking at each of their handlers. */
+MVMuint32 MVM_exception_handler_categories(MVMFrameHandler *handlers, MVMuint32 num_handlers) {
+    MVMuint32 categories = 0;
+    MVMuint32 i;
+    for (i = 0; i < num_handlers; i++)
+        categories |= handlers[i].category_mask;
+    return categories;
+}
+
 /* Looks through the handlers of a particular scope, and sees if one will
  * match what we're looking for. Returns 1 to it if so; if not,
  * returns 0. */
@@ -89,6 +100,16 @@ static MVMint32 search_frame_handlers(MVMThreadContext *tc, MVMFrame *f,
                                       MVMuint32 cat, MVMObject *payload,
                                       LocatedHandler *lh) {
     MVMuint32  i;
+
+    /* If no handler in the frame covers the category (and none is a control
+     * handler that takes any non-catch category), there's nothing to find. */
+    MVMuint32 categories = f->spesh_cand
+        ? f->spesh_cand->handler_categories
+        : f->static_info->body.handler_categories;
+    if ((categories & cat) != cat
+            && !((categories & MVM_EX_CAT_CONTROL) && cat != MVM_EX_CAT_CATCH))
+        return 0;
+
     if (f->spesh_cand && f->spesh_cand->jitcode && f->jit_entry_label) {
         MVMJitHandler    *jhs = f->spesh_cand->jitcode->handlers;
         MVMFrameHandler  *fhs = f->effective_handlers;
@@ -288,8 +309,9 @@ char * MVM_exception_backtrace_line(MVMThreadContext *tc, MVMFrame *cur_frame, M
     char *o = MVM_malloc(1024);
     MVMuint8 *cur_op = not_top ? cur_frame->return_address : cur_frame->throw_address;
     MVMuint32 offset = cur_op - cur_frame->effective_bytecode;
+    MVMBytecodeAnnotation annot_buf;
     MVMBytecodeAnnotation *annot = MVM_bytecode_resolve_annotation(tc, &cur_frame->static_info->body,
-                                        offset > 0 ? offset - 1 : 0);
+                                        offset > 0 ? offset - 1 : 0, &annot_buf);
 
     MVMuint32 line_number = annot ? annot->line_number : 1;
     MVMuint16 string_heap_index = annot ? annot->filename_string_heap_index : 0;
@@ -319,8 +341,6 @@ char * MVM_exception_backtrace_line(MVMThreadContext *tc, MVMFrame *cur_frame, M
 
     if (tmp1)
         MVM_free(tmp1);
-    if (annot)
-        MVM_free(annot);
 
     return o;
 }
@@ -356,8 +376,9 @@ MVMObject * MVM_exception_backtrace(MVMThreadContext *tc, MVMObject *ex_obj) {
     while (cur_frame != NULL) {
         MVMuint8             *cur_op = count ? cur_frame->return_address : cur_frame->throw_address;
         MVMuint32             offset = cur_op - cur_frame->effective_bytecode;
+        MVMBytecodeAnnotation annot_buf;
         MVMBytecodeAnnotation *annot = MVM_bytecode_resolve_annotation(tc, &cur_frame->static_info->body,
-                                            offset > 0 ? offset - 1 : 0);
+                                            offset > 0 ? offset - 1 : 0, &annot_buf);
         MVMint32              fshi   = annot ? (MVMint32)annot->filename_string_heap_index : -1;
         char            *line_number = MVM_malloc(16);
         snprintf(line_number, 16, "%d", annot ? annot->line_number : 1);
@@ -386,7 +407,6 @@ MVMObject * MVM_exception_backtrace(MVMThreadContext *tc, MVMObject *ex_obj) {
         MVM_repr_bind_key_o(tc, row, k_anno, annotations);
 
         MVM_repr_push_o(tc, arr, row);
-        MVM_free(annot);
 
         cur_frame = cur_frame->caller;
         while (cur_frame && cur_frame->static_info->body.is_thunk)
@@ -69,6 +69,7 @@ struct MVMActiveHandler {
 };
 
 /* Exception related functions. */
+MVMuint32 MVM_exception_handler_categories(MVMFrameHandler *handlers, MVMuint32 num_handlers);
 MVMObject * MVM_exception_backtrace(MVMThreadContext *tc, MVMObject *ex_obj);
 MVMObject * MVM_exception_backtrace_strings(MVMThreadContext *tc, MVMObject *exObj);
 void MVM_dump_backtrace(MVMThreadContext *tc);
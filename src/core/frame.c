@@ -20,8 +20,20 @@ static void prepare_and_verify_static_frame(MVMThreadContext *tc, MVMStaticFrame
         static_frame_body->work_size = sizeof(MVMRegister) *
             (static_frame_body->num_locals + static_frame_body->cu->body.max_callsite_size);
 
-        /* Validate the bytecode. */
-        MVM_validate_static_frame(tc, static_frame);
+        /* Validate the bytecode, unless we may trust it as is. */
+        if (!MVM_validate_static_frame_trusted(tc, static_frame))
+            MVM_validate_static_frame(tc, static_frame);
+
+        /* Allocate inline caches for method lookups, with room to spare so
+         * that sites rarely collide, and so instrumented bytecode (where the
+         * sites are at different offsets) can have its own. */
+        if (static_frame_body->num_findmeth_sites && !static_frame_body->findmeth_caches) {
+            MVMuint32 num_caches = 4;
+            while (num_caches < 2 * static_frame_body->num_findmeth_sites)
+                num_caches *= 2;
+            static_frame_body->findmeth_caches = MVM_calloc(num_caches, sizeof(MVMFindMethCache));
+            static_frame_body->num_findmeth_caches = num_caches;
+        }
 
         /* Obtain an index to each threadcontext's lexotic pool table */
         static_frame_body->pool_index = MVM_incr(&tc->instance->num_frames_run);
@@ -320,6 +332,88 @@ void MVM_frame_invoke_code(MVMThreadContext *tc, MVMCode *code,
         (MVMObject*)code, spesh_cand);
 }
 
+/* Checks if the arguments meet the guards of a specialization. */
+static MVMint32 spesh_guards_match(MVMThreadContext *tc, MVMSpeshCandidate *cand,
+                                   MVMRegister *args) {
+    MVMint32 match = 1;
+    MVMint32 j;
+    for (j = 0; j < cand->num_guards; j++) {
+        MVMint32   pos = cand->guards[j].slot;
+        MVMSTable *st  = (MVMSTable *)cand->guards[j].match;
+        MVMObject *arg = args[pos].o;
+        if (!arg) {
+            match = 0;
+            break;
+        }
+        switch (cand->guards[j].kind) {
+        case MVM_SPESH_GUARD_CONC:
+            if (!IS_CONCRETE(arg) || STABLE(arg) != st)
+                match = 0;
+            break;
+        case MVM_SPESH_GUARD_TYPE:
+            if (IS_CONCRETE(arg) || STABLE(arg) != st)
+                match = 0;
+            break;
+        case MVM_SPESH_GUARD_DC_CONC: {
+            MVMRegister dc;
+            STABLE(arg)->container_spec->fetch(tc, arg, &dc);
+            if (!dc.o || !IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
+                match = 0;
+            break;
+        }
+        case MVM_SPESH_GUARD_DC_TYPE: {
+            MVMRegister dc;
+            STABLE(arg)->container_spec->fetch(tc, arg, &dc);
+            if (!dc.o || IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
+                match = 0;
+            break;
+        }
+        case MVM_SPESH_GUARD_DC_CONC_RW: {
+            if (STABLE(arg)->container_spec->can_store(tc, arg)) {
+                MVMRegister dc;
+                STABLE(arg)->container_spec->fetch(tc, arg, &dc);
+                if (!dc.o || !IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
+                    match = 0;
+            }
+            else {
+                match = 0;
+            }
+            break;
+        }
+        case MVM_SPESH_GUARD_DC_TYPE_RW: {
+            if (STABLE(arg)->container_spec->can_store(tc, arg)) {
+                MVMRegister dc;
+                STABLE(arg)->container_spec->fetch(tc, arg, &dc);
+                if (!dc.o || IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
+                    match = 0;
+            }
+            else {
+                match = 0;
+            }
+            break;
+        }
+        }
+        if (!match)
+            break;
+    }
+    return match;
+}
+
+/* Checks if code keeps on deoptimizing whatever we make for it with these
+ * arguments, so that we've reached the last tier of specialization. */
+static MVMint32 spesh_reached_max_tier(MVMThreadContext *tc, MVMStaticFrameBody *sfb,
+                                       MVMCallsite *callsite, MVMRegister *args) {
+    MVMint32 num_spesh = sfb->num_spesh_candidates;
+    MVMint32 i;
+    for (i = 0; i < num_spesh; i++) {
+        MVMSpeshCandidate *cand = &sfb->spesh_candidates[i];
+        if (cand->retired && cand->tier >= MVM_SPESH_MAX_TIER && cand->cs == callsite
+                && spesh_guards_match(tc, cand, args))
+            return 1;
+    }
+    return 0;
+}
+
 /* Takes a static frame and a thread context. Invokes the static frame. */
 void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
                       MVMCallsite *callsite, MVMRegister *args,
@@ -338,7 +432,7 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
     found_spesh = 0;
     if (spesh_cand >= 0 && spesh_cand < static_frame_body->num_spesh_candidates) {
         MVMSpeshCandidate *chosen_cand = &static_frame_body->spesh_candidates[spesh_cand];
-        if (!chosen_cand->sg) {
+        if (!chosen_cand->sg && !chosen_cand->retired) {
             frame = allocate_frame(tc, static_frame_body, chosen_cand);
             frame->effective_bytecode    = chosen_cand->bytecode;
             frame->effective_handlers    = chosen_cand->handlers;
@@ -352,80 +446,20 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
         /* Look for specialized bytecode. */
         MVMint32 num_spesh = static_frame_body->num_spesh_candidates;
         MVMSpeshCandidate *chosen_cand = NULL;
-        MVMint32 i, j;
+        MVMint32 i;
         for (i = 0; i < num_spesh; i++) {
             MVMSpeshCandidate *cand = &static_frame_body->spesh_candidates[i];
-            if (cand->cs == callsite) {
-                MVMint32 match = 1;
-                for (j = 0; j < cand->num_guards; j++) {
-                    MVMint32   pos = cand->guards[j].slot;
-                    MVMSTable *st  = (MVMSTable *)cand->guards[j].match;
-                    MVMObject *arg = args[pos].o;
-                    if (!arg) {
-                        match = 0;
-                        break;
-                    }
-                    switch (cand->guards[j].kind) {
-                    case MVM_SPESH_GUARD_CONC:
-                        if (!IS_CONCRETE(arg) || STABLE(arg) != st)
-                            match = 0;
-                        break;
-                    case MVM_SPESH_GUARD_TYPE:
-                        if (IS_CONCRETE(arg) || STABLE(arg) != st)
-                            match = 0;
-                        break;
-                    case MVM_SPESH_GUARD_DC_CONC: {
-                        MVMRegister dc;
-                        STABLE(arg)->container_spec->fetch(tc, arg, &dc);
-                        if (!dc.o || !IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
-                            match = 0;
-                        break;
-                    }
-                    case MVM_SPESH_GUARD_DC_TYPE: {
-                        MVMRegister dc;
-                        STABLE(arg)->container_spec->fetch(tc, arg, &dc);
-                        if (!dc.o || IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
-                            match = 0;
-                        break;
-                    }
-                    case MVM_SPESH_GUARD_DC_CONC_RW: {
-                        if (STABLE(arg)->container_spec->can_store(tc, arg)) {
-                            MVMRegister dc;
-                            STABLE(arg)->container_spec->fetch(tc, arg, &dc);
-                            if (!dc.o || !IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
-                                match = 0;
-                        }
-                        else {
-                            match = 0;
-                        }
-                        break;
-                    }
-                    case MVM_SPESH_GUARD_DC_TYPE_RW: {
-                        if (STABLE(arg)->container_spec->can_store(tc, arg)) {
-                            MVMRegister dc;
-                            STABLE(arg)->container_spec->fetch(tc, arg, &dc);
-                            if (!dc.o || IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
-                                match = 0;
-                        }
-                        else {
-                            match = 0;
-                        }
-                        break;
-                    }
-                    }
-                    if (!match)
-                        break;
-                }
-                if (match) {
-                    chosen_cand = cand;
-                    break;
-                }
+            if (cand->cs == callsite && !cand->retired && spesh_guards_match(tc, cand, args)) {
+                chosen_cand = cand;
+                break;
             }
         }
 
         /* If we didn't find any, and we're below the limit, can set up a
-         * specialization. */
-        if (!chosen_cand && num_spesh < MVM_SPESH_LIMIT && tc->instance->spesh_enabled)
+         * specialization, unless any we make for these arguments just keep
+         * on deoptimizing. */
+        if (!chosen_cand && num_spesh < MVM_SPESH_LIMIT && tc->instance->spesh_enabled
+                && !spesh_reached_max_tier(tc, static_frame_body, callsite, args))
             chosen_cand = MVM_spesh_candidate_setup(tc, static_frame,
                 callsite, args, 0);
 
@@ -436,7 +470,7 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
                 /* In the logging phase. Try to get a logging index; ensure it
                  * is not being used as an OSR logging candidate elsewhere. */
                 AO_t cur_idx = MVM_load(&(chosen_cand->log_enter_idx));
-                if (!chosen_cand->osr_logging && cur_idx < MVM_SPESH_LOG_RUNS) {
+                if (!chosen_cand->osr_logging && cur_idx < chosen_cand->log_runs) {
                     if (MVM_cas(&(chosen_cand->log_enter_idx), cur_idx, cur_idx + 1) == cur_idx) {
                         /* We get to log. */
                         frame = allocate_frame(tc, static_frame_body, chosen_cand);
@@ -68,6 +68,10 @@ struct MVMStringConsts {
     MVMString *stderr_bytes;
     MVMString *buf_type;
     MVMString *write;
+    MVMString *stdin_from;
+    MVMString *stdout_to;
+    MVMString *stderr_to;
+    MVMString *stdout_pipe;
     MVMString *nativeref;
     MVMString *refkind;
     MVMString *positional;
@@ -79,6 +83,10 @@ struct MVMStringConsts {
     MVMString *kind;
     MVMString *instrumented;
     MVMString *heap;
+    MVMString *path;
+    MVMString *sampling;
+    MVMString *interval;
+    MVMString *allocations;
 };
 
 /* An entry in the representations registry. */
@@ -130,6 +138,9 @@ struct MVMInstance {
     MVMObject        *event_loop_active;
     uv_async_t       *event_loop_wakeup;
 
+    /* The timer wheel that all timers on the event loop are kept in. */
+    MVMTimerWheel    *timer_wheel;
+
     /* The VM null object. */
     MVMObject *VMNull;
 
@@ -192,6 +203,10 @@ struct MVMInstance {
     /* Flag for if NFA debugging is enabled. */
     MVMint8 nfa_debug_enabled;
 
+    /* Flag for if bytecode whose checksum matches what the MAST compiler
+     * recorded may skip validation. */
+    MVMint8 trust_bytecode;
+
     /* Flag for if jit is enabled */
     MVMint32 jit_enabled;
 
@@ -204,6 +219,16 @@ struct MVMInstance {
     FILE *jit_bytecode_map;
     /* sequence number for JIT compiled frames */
     AO_t  jit_seq_nr;
+    /* Linux perf map and jitdump files for JIT compiled frames, plus the
+     * executable mapping of the jitdump that lets perf find it */
+    FILE *jit_perf_map;
+    FILE *jit_perf_dump;
+    void *jit_perf_dump_marker;
+    /* Executable memory for JIT compiled frames */
+    MVMJitArena *jit_arena;
+    /* Number of frames not compiled because of each op, indexed by opcode;
+     * extops share the slot at MVM_OP_EXT_BASE */
+    AO_t *jit_bail_counts;
 
     /* Number of representations registered so far. */
     MVMuint32 num_reprs;
@@ -357,6 +382,22 @@ struct MVMInstance {
     /* Heap snapshots, if we're doing heap snapshotting. */
     MVMHeapSnapshotCollection *heap_snapshots;
 
+    /* The sampling profiler, if it was ever started, and the tick it moves
+     * along for each sample threads should take. */
+    MVMSamplingProfiler *sampling;
+    AO_t sample_tick;
+
+    /* The allocation profiler, if it was ever started, and the number of
+     * bytes of nursery allocation between samples (zero when it's off). */
+    MVMAllocProfiler *alloc_profiler;
+    AO_t alloc_sample_interval;
+
+    /* GC telemetry, which is always kept. */
+    MVMGCStats *gc_stats;
+
+    /* Bytecode preloading state. */
+    MVMPreloader *preloader;
+
     /* Whether cross-thread write logging is turned on or not, and an output
      * mutex for it. */
     MVMuint32  cross_thread_write_logging;
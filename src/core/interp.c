@@ -1678,8 +1678,14 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 MVMRegister *res  = &GET_REG(cur_op, 0);
                 MVMObject   *obj  = GET_REG(cur_op, 2).o;
                 MVMString   *name = MVM_cu_string(tc, cu, GET_UI32(cur_op, 4));
+                MVMuint32    site = (MVMuint32)(cur_op - bytecode_start);
                 cur_op += 8;
-                MVM_6model_find_method(tc, obj, name, res);
+                /* Specialized code (with whatever it inlined) has offsets
+                 * of its own, so may not use the caches. */
+                if (tc->cur_frame->spesh_cand)
+                    MVM_6model_find_method(tc, obj, name, res);
+                else
+                    MVM_6model_find_method_cached(tc, obj, name, site, res);
                 goto NEXT;
             }
             OP(findmeth_s):  {
@@ -2395,6 +2401,7 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 stable = STABLE(GET_REG(cur_op, 0).o);
                 MVM_ASSIGN_REF(tc, &(stable->header), stable->method_cache, cache);
                 stable->method_cache_sc = NULL;
+                stable->method_cache_gen++;
                 MVM_SC_WB_ST(tc, stable);
 
                 cur_op += 4;
@@ -2416,15 +2423,11 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 MVMObject *types  = GET_REG(cur_op, 2).o;
                 MVMSTable *st     = STABLE(obj);
                 MVMint64 i, elems = REPR(types)->elems(tc, STABLE(types), types, OBJECT_BODY(types));
-                MVMObject **cache = MVM_malloc(sizeof(MVMObject *) * elems);
+                MVMObject **cache = MVM_6model_alloc_type_check_cache(tc, (MVMuint16)elems);
                 for (i = 0; i < elems; i++) {
                     MVM_ASSIGN_REF(tc, &(st->header), cache[i], MVM_repr_at_pos_o(tc, types, i));
                 }
-                /* technically this free isn't thread safe */
-                if (st->type_check_cache)
-                    MVM_free(st->type_check_cache);
-                st->type_check_cache = cache;
-                st->type_check_cache_length = (MVMuint16)elems;
+                MVM_6model_set_type_check_cache(tc, st, cache, (MVMuint16)elems);
                 MVM_SC_WB_ST(tc, st);
                 cur_op += 4;
                 goto NEXT;
@@ -4986,11 +4989,41 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 cur_op += 4;
                 goto NEXT;
             }
+            OP(settimeouts_sk):
+                MVM_io_set_timeouts(tc, GET_REG(cur_op, 0).o,
+                    GET_REG(cur_op, 2).i64, GET_REG(cur_op, 4).i64);
+                cur_op += 6;
+                goto NEXT;
+            OP(copy_fh):
+                GET_REG(cur_op, 0).i64 = MVM_io_copy(tc, GET_REG(cur_op, 2).o,
+                    GET_REG(cur_op, 4).o, GET_REG(cur_op, 6).i64);
+                cur_op += 8;
+                goto NEXT;
+            OP(asynccopy):
+                GET_REG(cur_op, 0).o = MVM_io_copy_async(tc, GET_REG(cur_op, 2).o,
+                    GET_REG(cur_op, 4).o, GET_REG(cur_op, 6).o, GET_REG(cur_op, 8).o,
+                    GET_REG(cur_op, 10).i64, GET_REG(cur_op, 12).o);
+                cur_op += 14;
+                goto NEXT;
+            OP(setreadahead_fh):
+                MVM_io_set_read_ahead(tc, GET_REG(cur_op, 0).o,
+                    GET_REG(cur_op, 2).i64, GET_REG(cur_op, 4).i64);
+                cur_op += 6;
+                goto NEXT;
+            OP(gcstats):
+                GET_REG(cur_op, 0).o = MVM_gc_stats_query(tc);
+                cur_op += 2;
+                goto NEXT;
+            OP(preloadbytecode):
+                MVM_preload_bytecode(tc, GET_REG(cur_op, 0).o);
+                cur_op += 2;
+                goto NEXT;
             OP(sp_log):
                 if (tc->cur_frame->spesh_log_idx >= 0) {
                     MVM_ASSIGN_REF(tc, &(tc->cur_frame->static_info->common.header),
                         tc->cur_frame->spesh_log_slots[
-                            GET_UI16(cur_op, 2) * MVM_SPESH_LOG_RUNS + tc->cur_frame->spesh_log_idx
+                            GET_UI16(cur_op, 2) * tc->cur_frame->spesh_cand->log_runs
+                            + tc->cur_frame->spesh_log_idx
                         ],
                         GET_REG(cur_op, 0).o);
                 }
@@ -5001,11 +5034,19 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 if (cand) {
                     tc->cur_frame->spesh_log_idx = cand->log_enter_idx;
                     cand->log_enter_idx++;
-                    if (cand->log_enter_idx >= MVM_SPESH_LOG_RUNS)
+                    if (cand->log_enter_idx >= cand->log_runs)
                         MVM_spesh_osr_finalize(tc);
                 }
                 goto NEXT;
             }
+            OP(sp_countcall): {
+                MVMSpeshCandidate *cand = tc->cur_frame->spesh_cand;
+                if (tc->cur_frame->spesh_log_idx >= 0 && cand->call_counts)
+                    cand->call_counts[GET_UI16(cur_op, 0) * cand->log_runs
+                        + tc->cur_frame->spesh_log_idx] = 1;
+                cur_op += 2;
+                goto NEXT;
+            }
             OP(sp_guardconc): {
                 MVMObject *check = GET_REG(cur_op, 0).o;
                 MVMSTable *want  = (MVMSTable *)tc->cur_frame
@@ -5198,11 +5239,19 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 cur_op += 4;
                 goto NEXT;
             OP(sp_findmeth): {
-                /* Obtain object and cache index; see if we get a match. */
-                MVMObject *obj = GET_REG(cur_op, 2).o;
-                MVMuint16  idx = GET_UI16(cur_op, 8);
-                if ((MVMSTable *)tc->cur_frame->effective_spesh_slots[idx] == STABLE(obj)) {
-                    GET_REG(cur_op, 0).o = (MVMObject *)tc->cur_frame->effective_spesh_slots[idx + 1];
+                /* Obtain object and cache index; see if we get a match on
+                 * any of the cached types. */
+                MVMObject       *obj   = GET_REG(cur_op, 2).o;
+                MVMuint16        idx   = GET_UI16(cur_op, 8);
+                MVMCollectable **slots = tc->cur_frame->effective_spesh_slots + idx;
+                MVMSTable       *st    = STABLE(obj);
+                MVMuint32        i     = 0;
+                while (i < 2 * MVM_FINDMETH_CACHE_TYPES && (MVMSTable *)slots[i] != st)
+                    i += 2;
+                if (i < 2 * MVM_FINDMETH_CACHE_TYPES) {
+                    if (tc->instance->profiling)
+                        MVM_profiler_log_findmeth_cache(tc, 1);
+                    GET_REG(cur_op, 0).o = (MVMObject *)slots[i + 1];
                     cur_op += 10;
                 }
                 else {
@@ -5,10 +5,14 @@
  * really only means we need to do this enough to make sure tight native
  * loops trigger it. */
 /* Don't use a MVM_load(&tc->gc_status) here for performance, it's okay
- * if the interrupt is delayed a bit. */
+ * if the interrupt is delayed a bit. Sync points are also where we take a
+ * sample for the sampling profiler, if its tick moved on. */
 #define GC_SYNC_POINT(tc) \
     if (tc->gc_status) { \
         MVM_gc_enter_from_interrupt(tc); \
+    } \
+    if (tc->instance->sample_tick != tc->sample_tick) { \
+        MVM_profile_sampling_take_sample(tc); \
     }
 
 /* Different views of a register. */
@@ -740,8 +740,15 @@ static const void * const LABELS[] = {
     &&OP_stat_time,
     &&OP_lstat_time,
     &&OP_setdebugtypename,
+    &&OP_settimeouts_sk,
+    &&OP_copy_fh,
+    &&OP_asynccopy,
+    &&OP_setreadahead_fh,
+    &&OP_gcstats,
+    &&OP_preloadbytecode,
     &&OP_sp_log,
     &&OP_sp_osrfinalize,
+    &&OP_sp_countcall,
     &&OP_sp_guardconc,
     &&OP_sp_guardtype,
     &&OP_sp_guardcontconc,
@@ -1018,13 +1025,6 @@ static const void * const LABELS[] = {
     NULL,
     NULL,
     NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
     &&OP_CALL_EXTOP,
     &&OP_CALL_EXTOP,
     &&OP_CALL_EXTOP,
@@ -740,66 +740,73 @@
 #define MVM_OP_stat_time 736
 #define MVM_OP_lstat_time 737
 #define MVM_OP_setdebugtypename 738
-#define MVM_OP_sp_log 739
-#define MVM_OP_sp_osrfinalize 740
-#define MVM_OP_sp_guardconc 741
-#define MVM_OP_sp_guardtype 742
-#define MVM_OP_sp_guardcontconc 743
-#define MVM_OP_sp_guardconttype 744
-#define MVM_OP_sp_guardrwconc 745
-#define MVM_OP_sp_guardrwtype 746
-#define MVM_OP_sp_getarg_o 747
-#define MVM_OP_sp_getarg_i 748
-#define MVM_OP_sp_getarg_n 749
-#define MVM_OP_sp_getarg_s 750
-#define MVM_OP_sp_fastinvoke_v 751
-#define MVM_OP_sp_fastinvoke_i 752
-#define MVM_OP_sp_fastinvoke_n 753
-#define MVM_OP_sp_fastinvoke_s 754
-#define MVM_OP_sp_fastinvoke_o 755
-#define MVM_OP_sp_namedarg_used 756
-#define MVM_OP_sp_getspeshslot 757
-#define MVM_OP_sp_findmeth 758
-#define MVM_OP_sp_fastcreate 759
-#define MVM_OP_sp_get_o 760
-#define MVM_OP_sp_get_i64 761
-#define MVM_OP_sp_get_i32 762
-#define MVM_OP_sp_get_i16 763
-#define MVM_OP_sp_get_i8 764
-#define MVM_OP_sp_get_n 765
-#define MVM_OP_sp_get_s 766
-#define MVM_OP_sp_bind_o 767
-#define MVM_OP_sp_bind_i64 768
-#define MVM_OP_sp_bind_i32 769
-#define MVM_OP_sp_bind_i16 770
-#define MVM_OP_sp_bind_i8 771
-#define MVM_OP_sp_bind_n 772
-#define MVM_OP_sp_bind_s 773
-#define MVM_OP_sp_p6oget_o 774
-#define MVM_OP_sp_p6ogetvt_o 775
-#define MVM_OP_sp_p6ogetvc_o 776
-#define MVM_OP_sp_p6oget_i 777
-#define MVM_OP_sp_p6oget_n 778
-#define MVM_OP_sp_p6oget_s 779
-#define MVM_OP_sp_p6obind_o 780
-#define MVM_OP_sp_p6obind_i 781
-#define MVM_OP_sp_p6obind_n 782
-#define MVM_OP_sp_p6obind_s 783
-#define MVM_OP_sp_deref_get_i64 784
-#define MVM_OP_sp_deref_get_n 785
-#define MVM_OP_sp_deref_bind_i64 786
-#define MVM_OP_sp_deref_bind_n 787
-#define MVM_OP_sp_jit_enter 788
-#define MVM_OP_sp_boolify_iter 789
-#define MVM_OP_sp_boolify_iter_arr 790
-#define MVM_OP_sp_boolify_iter_hash 791
-#define MVM_OP_prof_enter 792
-#define MVM_OP_prof_enterspesh 793
-#define MVM_OP_prof_enterinline 794
-#define MVM_OP_prof_enternative 795
-#define MVM_OP_prof_exit 796
-#define MVM_OP_prof_allocated 797
-#define MVM_OP_ctw_check 798
+#define MVM_OP_settimeouts_sk 739
+#define MVM_OP_copy_fh 740
+#define MVM_OP_asynccopy 741
+#define MVM_OP_setreadahead_fh 742
+#define MVM_OP_gcstats 743
+#define MVM_OP_preloadbytecode 744
+#define MVM_OP_sp_log 745
+#define MVM_OP_sp_osrfinalize 746
+#define MVM_OP_sp_countcall 747
+#define MVM_OP_sp_guardconc 748
+#define MVM_OP_sp_guardtype 749
+#define MVM_OP_sp_guardcontconc 750
+#define MVM_OP_sp_guardconttype 751
+#define MVM_OP_sp_guardrwconc 752
+#define MVM_OP_sp_guardrwtype 753
+#define MVM_OP_sp_getarg_o 754
+#define MVM_OP_sp_getarg_i 755
+#define MVM_OP_sp_getarg_n 756
+#define MVM_OP_sp_getarg_s 757
+#define MVM_OP_sp_fastinvoke_v 758
+#define MVM_OP_sp_fastinvoke_i 759
+#define MVM_OP_sp_fastinvoke_n 760
+#define MVM_OP_sp_fastinvoke_s 761
+#define MVM_OP_sp_fastinvoke_o 762
+#define MVM_OP_sp_namedarg_used 763
+#define MVM_OP_sp_getspeshslot 764
+#define MVM_OP_sp_findmeth 765
+#define MVM_OP_sp_fastcreate 766
+#define MVM_OP_sp_get_o 767
+#define MVM_OP_sp_get_i64 768
+#define MVM_OP_sp_get_i32 769
+#define MVM_OP_sp_get_i16 770
+#define MVM_OP_sp_get_i8 771
+#define MVM_OP_sp_get_n 772
+#define MVM_OP_sp_get_s 773
+#define MVM_OP_sp_bind_o 774
+#define MVM_OP_sp_bind_i64 775
+#define MVM_OP_sp_bind_i32 776
+#define MVM_OP_sp_bind_i16 777
+#define MVM_OP_sp_bind_i8 778
+#define MVM_OP_sp_bind_n 779
+#define MVM_OP_sp_bind_s 780
+#define MVM_OP_sp_p6oget_o 781
+#define MVM_OP_sp_p6ogetvt_o 782
+#define MVM_OP_sp_p6ogetvc_o 783
+#define MVM_OP_sp_p6oget_i 784
+#define MVM_OP_sp_p6oget_n 785
+#define MVM_OP_sp_p6oget_s 786
+#define MVM_OP_sp_p6obind_o 787
+#define MVM_OP_sp_p6obind_i 788
+#define MVM_OP_sp_p6obind_n 789
+#define MVM_OP_sp_p6obind_s 790
+#define MVM_OP_sp_deref_get_i64 791
+#define MVM_OP_sp_deref_get_n 792
+#define MVM_OP_sp_deref_bind_i64 793
+#define MVM_OP_sp_deref_bind_n 794
+#define MVM_OP_sp_jit_enter 795
+#define MVM_OP_sp_boolify_iter 796
+#define MVM_OP_sp_boolify_iter_arr 797
+#define MVM_OP_sp_boolify_iter_hash 798
+#define MVM_OP_prof_enter 799
+#define MVM_OP_prof_enterspesh 800
+#define MVM_OP_prof_enterinline 801
+#define MVM_OP_prof_enternative 802
+#define MVM_OP_prof_exit 803
+#define MVM_OP_prof_allocated 804
+#define MVM_OP_ctw_check 805
 
 #define MVM_OP_EXT_BASE 1024
 #define MVM_OP_EXT_CU_LIMIT 1024
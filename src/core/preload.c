@@ -0,0 +1,316 @@
+#include "moar.h"
+#include "platform/mmap.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#define O_RDONLY _O_RDONLY
+#endif
+
+/* Sets up preloader state. */
+void MVM_preload_init(MVMInstance *instance) {
+    MVMPreloader *pl = MVM_calloc(1, sizeof(MVMPreloader));
+    int init_stat;
+    if ((init_stat = uv_mutex_init(&pl->mutex)) < 0
+            || (init_stat = uv_cond_init(&pl->cond)) < 0) {
+        fprintf(stderr, "MoarVM: Initialization of bytecode preloader failed\n    %s\n",
+            uv_strerror(init_stat));
+        exit(1);
+    }
+    instance->preloader = pl;
+}
+
+static MVMuint32 read_uint32(MVMuint8 *src) {
+#ifdef MVM_BIGENDIAN
+    MVMuint32 value;
+    size_t i;
+    MVMuint8 *destbytes = (MVMuint8 *)&value;
+    for (i = 0; i < 4; i++)
+         destbytes[4 - i - 1] = src[i];
+    return value;
+#else
+    return *((MVMuint32 *)src);
+#endif
+}
+
+/* Decodes a string from the string heap if that needs no normalization: a
+ * Latin-1 string maps byte for byte, as does a UTF-8 one that's all ASCII,
+ * so long as there's no CRLF (which is a single grapheme). Otherwise, hands
+ * back NULL and the string gets decoded as usual when it's wanted. */
+static MVMGrapheme32 * decode_simple(MVMuint8 *bytes, MVMuint32 num_bytes, MVMuint32 utf8) {
+    MVMGrapheme32 *result;
+    MVMuint32 i;
+    if (num_bytes == 0)
+        return NULL;
+    for (i = 0; i < num_bytes; i++) {
+        if (utf8 && bytes[i] >= 0x80)
+            return NULL;
+        if (bytes[i] == '\r' && i + 1 < num_bytes && bytes[i + 1] == '\n')
+            return NULL;
+    }
+    result = MVM_malloc(num_bytes * sizeof(MVMGrapheme32));
+    for (i = 0; i < num_bytes; i++)
+        result[i] = bytes[i];
+    return result;
+}
+
+/* Frees the decoded strings and offsets of a preloaded file. */
+static void free_strings(MVMPreloadedFile *pf) {
+    MVMuint32 i;
+    if (pf->strings) {
+        for (i = 0; i < pf->num_strings; i++)
+            MVM_free(pf->strings[i]);
+        MVM_free(pf->strings);
+        pf->strings = NULL;
+    }
+    MVM_free(pf->string_offsets);
+    pf->string_offsets = NULL;
+    pf->num_strings    = 0;
+}
+
+/* Does the preloading of a file: maps it, faults it in, and walks its string
+ * heap. Touches nothing in the VM, so it can run on any thread; errors just
+ * leave the file marked invalid, for the loader to report properly. */
+static void preload_file(uv_loop_t *loop, MVMPreloadedFile *pf) {
+    uv_fs_t    req;
+    uv_file    fd;
+    MVMuint8  *data, *heap, *pos, *limit;
+    MVMuint32  num_strings, i;
+    volatile MVMuint8 touched = 0;
+    size_t     offset;
+
+    /* Map the file. */
+    if (uv_fs_stat(loop, &req, pf->filename, NULL) < 0)
+        return;
+    pf->file_size  = req.statbuf.st_size;
+    pf->mtime_sec  = req.statbuf.st_mtim.tv_sec;
+    pf->mtime_nsec = req.statbuf.st_mtim.tv_nsec;
+    if (pf->file_size == 0 || pf->file_size > 0xFFFFFFFF)
+        return;
+    if ((fd = uv_fs_open(loop, &req, pf->filename, O_RDONLY, 0, NULL)) < 0)
+        return;
+    pf->block = MVM_platform_map_file(fd, &(pf->handle), (size_t)pf->file_size, 0);
+    uv_fs_close(loop, &req, fd, NULL);
+    if (!pf->block)
+        return;
+    data  = (MVMuint8 *)pf->block;
+    limit = data + pf->file_size;
+
+    /* Fault it in, so the loading thread doesn't wait on the disk. */
+    for (offset = 0; offset < pf->file_size; offset += 4096)
+        touched += data[offset];
+
+    /* Find every string and decode those that are simple. */
+    heap = MVM_bytecode_locate_string_heap(data, (MVMuint32)pf->file_size, &num_strings);
+    if (!heap)
+        return;
+    pf->num_strings    = num_strings;
+    pf->string_offsets = MVM_malloc((num_strings ? num_strings : 1) * sizeof(MVMuint32));
+    pf->strings        = MVM_calloc(num_strings ? num_strings : 1, sizeof(MVMGrapheme32 *));
+    pos = heap;
+    for (i = 0; i < num_strings; i++) {
+        MVMuint32 ss, bytes;
+        if (pos + 4 >= limit)
+            break;
+        ss    = read_uint32(pos);
+        bytes = ss >> 1;
+        if (pos + 4 + bytes >= limit)
+            break;
+        pf->string_offsets[i] = (MVMuint32)(pos - heap);
+        pf->strings[i]        = decode_simple(pos + 4, bytes, ss & 1);
+        pos += 4 + bytes + (bytes & 3 ? 4 - (bytes & 3) : 0);
+    }
+    if (i == num_strings)
+        pf->valid = 1;
+    else
+        free_strings(pf);
+}
+
+/* Worker thread, which preloads queued files until there are none left. */
+static void worker(void *arg) {
+    MVMPreloader *pl   = ((MVMInstance *)arg)->preloader;
+    uv_loop_t    *loop = uv_loop_new();
+    while (1) {
+        MVMPreloadedFile *pf;
+        uv_mutex_lock(&pl->mutex);
+        for (pf = pl->files; pf; pf = pf->next)
+            if (pf->state == MVM_PRELOAD_QUEUED)
+                break;
+        if (!pf) {
+            pl->running--;
+            uv_mutex_unlock(&pl->mutex);
+            break;
+        }
+        pf->state = MVM_PRELOAD_WORKING;
+        uv_mutex_unlock(&pl->mutex);
+
+        preload_file(loop, pf);
+
+        uv_mutex_lock(&pl->mutex);
+        pf->state = MVM_PRELOAD_DONE;
+        uv_cond_broadcast(&pl->cond);
+        uv_mutex_unlock(&pl->mutex);
+    }
+    uv_loop_delete(loop);
+}
+
+/* Queues files to be preloaded, resolving them against the library path as
+ * loading them would, and starts workers to do it. Files already loaded or
+ * queued are skipped. */
+void MVM_preload_bytecode(MVMThreadContext *tc, MVMObject *filenames) {
+    MVMPreloader *pl = tc->instance->preloader;
+    MVMint64      i, n;
+    MVMuint32     queued = 0;
+
+    if (!IS_CONCRETE(filenames) || REPR(filenames)->ID != MVM_REPR_ID_MVMArray)
+        MVM_exception_throw_adhoc(tc, "preloadbytecode requires a concrete list of filenames");
+    n = MVM_repr_elems(tc, filenames);
+
+    MVMROOT(tc, filenames, {
+        for (i = 0; i < n; i++) {
+            MVMString             *filename = MVM_file_in_libpath(tc,
+                MVM_repr_at_pos_s(tc, filenames, i));
+            MVMLoadedCompUnitName *loaded_name;
+            MVMPreloadedFile      *pf;
+            MVMPreloadedFile     **tail;
+            char                  *c_filename;
+
+            uv_mutex_lock(&tc->instance->mutex_loaded_compunits);
+            MVM_tc_set_ex_release_mutex(tc, &tc->instance->mutex_loaded_compunits);
+            MVM_string_flatten(tc, filename);
+            MVM_HASH_GET(tc, tc->instance->loaded_compunits, filename, loaded_name);
+            MVM_tc_clear_ex_release_mutex(tc);
+            uv_mutex_unlock(&tc->instance->mutex_loaded_compunits);
+            if (loaded_name)
+                continue;
+
+            c_filename = MVM_string_utf8_c8_encode_C_string(tc, filename);
+            uv_mutex_lock(&pl->mutex);
+            for (tail = &(pl->files); (pf = *tail); tail = &(pf->next))
+                if (strcmp(pf->filename, c_filename) == 0)
+                    break;
+            if (pf) {
+                MVM_free(c_filename);
+            }
+            else {
+                pf = MVM_calloc(1, sizeof(MVMPreloadedFile));
+                pf->filename = c_filename;
+                pf->state    = MVM_PRELOAD_QUEUED;
+                *tail        = pf;
+                queued++;
+            }
+            uv_mutex_unlock(&pl->mutex);
+        }
+    });
+
+    /* Start enough workers; if we can't start any, the loader will do the
+     * work itself when it claims the file. */
+    uv_mutex_lock(&pl->mutex);
+    while (queued-- && pl->running < MVM_PRELOAD_MAX_THREADS) {
+        if (pl->num_threads == pl->alloc_threads) {
+            pl->alloc_threads = pl->alloc_threads ? pl->alloc_threads * 2 : MVM_PRELOAD_MAX_THREADS;
+            pl->threads = MVM_realloc(pl->threads, pl->alloc_threads * sizeof(uv_thread_t));
+        }
+        if (uv_thread_create(&(pl->threads[pl->num_threads]), worker, tc->instance) < 0)
+            break;
+        pl->num_threads++;
+        pl->running++;
+    }
+    uv_mutex_unlock(&pl->mutex);
+}
+
+/* Claims the preloading of a file that's being loaded, if there is one,
+ * doing it right away if no worker got to it yet, and waiting for it if one
+ * is on it. Hands back the preloaded file if it's good and still matches the
+ * file on disk, and NULL otherwise. */
+MVMPreloadedFile * MVM_preload_claim(MVMThreadContext *tc, const char *filename,
+        MVMuint64 file_size, MVMint64 mtime_sec, MVMint64 mtime_nsec) {
+    MVMPreloader     *pl = tc->instance->preloader;
+    MVMPreloadedFile *pf, **prev;
+
+    uv_mutex_lock(&pl->mutex);
+    for (prev = &(pl->files); (pf = *prev); prev = &(pf->next))
+        if (strcmp(pf->filename, filename) == 0)
+            break;
+    if (!pf) {
+        uv_mutex_unlock(&pl->mutex);
+        return NULL;
+    }
+    *prev    = pf->next;
+    pf->next = NULL;
+    if (pf->state == MVM_PRELOAD_QUEUED) {
+        pf->state = MVM_PRELOAD_WORKING;
+        uv_mutex_unlock(&pl->mutex);
+        preload_file(tc->loop, pf);
+    }
+    else {
+        /* Unblocking waits for any GC run to finish, and that may need a
+         * thread waiting for the mutex, so we must let go of it first. */
+        if (pf->state != MVM_PRELOAD_DONE) {
+            MVM_gc_mark_thread_blocked(tc);
+            while (pf->state != MVM_PRELOAD_DONE)
+                uv_cond_wait(&pl->cond, &pl->mutex);
+            uv_mutex_unlock(&pl->mutex);
+            MVM_gc_mark_thread_unblocked(tc);
+        }
+        else {
+            uv_mutex_unlock(&pl->mutex);
+        }
+    }
+
+    if (!pf->valid || pf->file_size != file_size
+            || pf->mtime_sec != mtime_sec || pf->mtime_nsec != mtime_nsec) {
+        MVM_preload_free_file(pf);
+        return NULL;
+    }
+    return pf;
+}
+
+/* Makes a string of a compilation unit from the preloaded graphemes, taking
+ * them over, and stores it in the string heap. Returns NULL if we don't
+ * have them. */
+MVMString * MVM_preload_string(MVMThreadContext *tc, MVMCompUnit *cu, MVMuint32 idx) {
+    MVMPreloadedFile *pf     = cu->body.preload;
+    MVMGrapheme32    *graphs = pf->strings[idx];
+    if (graphs && MVM_casptr(&(pf->strings[idx]), graphs, NULL) == graphs) {
+        MVMObject *type = tc->instance->VMString;
+        MVMString *s;
+        MVM_gc_allocate_gen2_default_set(tc);
+        s = (MVMString *)REPR(type)->allocate(tc, STABLE(type));
+        s->body.storage_type    = MVM_STRING_GRAPHEME_32;
+        s->body.storage.blob_32 = graphs;
+        s->body.num_graphs      = read_uint32(cu->body.string_heap_start
+            + pf->string_offsets[idx]) >> 1;
+        MVM_ASSIGN_REF(tc, &(cu->common.header), cu->body.strings[idx], s);
+        MVM_gc_allocate_gen2_default_clear(tc);
+        return s;
+    }
+    return NULL;
+}
+
+/* Frees a preloaded file, unmapping it unless a compilation unit has taken
+ * over the mapping. */
+void MVM_preload_free_file(MVMPreloadedFile *pf) {
+    if (pf->block)
+        MVM_platform_unmap_file(pf->block, pf->handle, (size_t)pf->file_size);
+    free_strings(pf);
+    MVM_free(pf->filename);
+    MVM_free(pf);
+}
+
+/* Waits for the workers and frees anything never claimed. */
+void MVM_preload_destroy(MVMInstance *instance) {
+    MVMPreloader     *pl = instance->preloader;
+    MVMPreloadedFile *pf;
+    MVMuint32 i;
+    for (i = 0; i < pl->num_threads; i++)
+        uv_thread_join(&(pl->threads[i]));
+    MVM_free(pl->threads);
+    while ((pf = pl->files)) {
+        pl->files = pf->next;
+        MVM_preload_free_file(pf);
+    }
+    uv_cond_destroy(&pl->cond);
+    uv_mutex_destroy(&pl->mutex);
+    MVM_free(pl);
+    instance->preloader = NULL;
+}
@@ -0,0 +1,74 @@
+/* Bytecode preloading. Programs that load many precompiled modules spend a
+ * good part of startup mapping the files in and decoding their string heaps,
+ * one compilation unit after another. The preloadbytecode op takes a list of
+ * files that are about to be loaded and has worker threads do the parts that
+ * don't touch the VM heap: mapping each file (and faulting it into memory),
+ * locating every string in the string heap, and decoding the strings that
+ * need no normalization (ASCII, or Latin-1 with no CRLF) into grapheme
+ * buffers. When the file is loaded it takes over the mapping and the decoded
+ * buffers, so making such a string only allocates its header. Resolving the
+ * object graph, frames and callsites still happens on the loading thread. */
+
+/* Maximum number of worker threads preloading at once. */
+#define MVM_PRELOAD_MAX_THREADS 4
+
+/* States of a file being preloaded. */
+#define MVM_PRELOAD_QUEUED      0
+#define MVM_PRELOAD_WORKING     1
+#define MVM_PRELOAD_DONE        2
+
+/* A file being preloaded, or the results of having done so. Once claimed by
+ * a compilation unit, it hangs off that and is freed with it. */
+struct MVMPreloadedFile {
+    /* The file, as it will be asked for by the loader. */
+    char *filename;
+
+    /* One of the states above; protected by the preloader's mutex. */
+    MVMuint8 state;
+
+    /* Whether the file was mapped and its string heap looked sane. */
+    MVMuint8 valid;
+
+    /* What we found when we looked at the file. */
+    MVMuint64 file_size;
+    MVMint64  mtime_sec;
+    MVMint64  mtime_nsec;
+
+    /* The mapping, until a compilation unit takes it. */
+    void *block;
+    void *handle;
+
+    /* Offset of each string from the start of the string heap, and the
+     * decoded graphemes of each string we could decode (or NULL). */
+    MVMuint32       num_strings;
+    MVMuint32      *string_offsets;
+    MVMGrapheme32 **strings;
+
+    /* Next file in the preloader's list. */
+    MVMPreloadedFile *next;
+};
+
+/* Preloader state, hung off the instance. */
+struct MVMPreloader {
+    /* Protects everything here and file states; the condition variable is
+     * signalled whenever a file is done. */
+    uv_mutex_t mutex;
+    uv_cond_t  cond;
+
+    /* Files preloading or preloaded, and not yet claimed. */
+    MVMPreloadedFile *files;
+
+    /* Worker threads started, and how many are still working. */
+    uv_thread_t *threads;
+    MVMuint32    num_threads;
+    MVMuint32    alloc_threads;
+    MVMuint32    running;
+};
+
+void MVM_preload_init(MVMInstance *instance);
+void MVM_preload_bytecode(MVMThreadContext *tc, MVMObject *filenames);
+MVMPreloadedFile * MVM_preload_claim(MVMThreadContext *tc, const char *filename,
+    MVMuint64 file_size, MVMint64 mtime_sec, MVMint64 mtime_nsec);
+MVMString * MVM_preload_string(MVMThreadContext *tc, MVMCompUnit *cu, MVMuint32 idx);
+void MVM_preload_free_file(MVMPreloadedFile *pf);
+void MVM_preload_destroy(MVMInstance *instance);
@@ -70,6 +70,10 @@ void MVM_tc_destroy(MVMThreadContext *tc) {
     /* Free per-thread lexotic cache. */
     MVM_free(tc->lexotic_cache);
 
+    /* Free any sampling or allocation profiler data. */
+    MVM_profile_sampling_destroy_buffer(tc);
+    MVM_profile_allocations_destroy_thread(tc);
+
     /* Destroy the libuv event loop */
     uv_loop_delete(tc->loop);
 
@@ -44,6 +44,10 @@ struct MVMThreadContext {
     /* This thread's GC status. */
     AO_t gc_status;
 
+    /* The last sample tick this thread saw; when the instance's one moves
+     * on, we take a sample at the next safe point. */
+    AO_t sample_tick;
+
     /* Non-zero is we should allocate in gen2; incremented/decremented as we
      * enter/leave a region wanting gen2 allocation. */
     MVMuint32 allocate_in_gen2;
@@ -111,12 +115,21 @@ struct MVMThreadContext {
     /* Number of bytes promoted to gen2 in current GC run. */
     MVMuint32 gc_promoted_bytes;
 
-    /* Memory buffer pointing to the last thing we serialized, intended to go
-     * into the next compilation unit we write. Also the serialized string
-     * heap, which will be used to seed the compilation unit string heap. */
-    MVMint32      serialized_size;
-    char         *serialized;
-    MVMObject    *serialized_string_heap;
+    /* Number of bytes that survived the current GC run but stayed in the
+     * nursery. */
+    MVMuint32 gc_survivor_bytes;
+
+    /* GC telemetry for this thread: runs taken part in, time spent in them
+     * in nanoseconds, and size of gen2 as of the last run. */
+    MVMuint64 gc_stats_runs;
+    MVMuint64 gc_stats_time;
+    MVMuint64 gc_gen2_bytes;
+
+    /* The writer holding the last thing we serialized, intended to go into
+     * the next compilation unit we write. Also the serialized string heap,
+     * which will be used to seed the compilation unit string heap. */
+    MVMSerializationWriter *serialized_writer;
+    MVMObject              *serialized_string_heap;
 
     /* Temporarily rooted objects. This is generally used by code written in
      * C that wants to keep references to objects. Since those may change
@@ -201,6 +214,14 @@ struct MVMThreadContext {
 
     /* Profiling data collected for this thread, if profiling is on. */
     MVMProfileThreadData *prof_data;
+
+    /* Samples not yet folded, if sampling profiling was ever on. */
+    MVMSamplingBuffer *sampling_buffer;
+
+    /* Bytes left to allocate until the next allocation profiler sample, and
+     * the samples being tracked. */
+    MVMint64 alloc_sample_countdown;
+    MVMAllocProfileThread *alloc_samples;
 };
 
 MVMThreadContext * MVM_tc_create(MVMInstance *instance);
@@ -76,6 +76,11 @@ static void start_thread(void *data) {
     /* Enter the interpreter, to run code. */
     MVM_interp_run(tc, thread_initial_invoke, ts);
 
+    /* Fold any samples we took, since nobody will look at our buffers once
+     * we've exited. */
+    MVM_profile_sampling_flush(tc, tc);
+    MVM_profile_allocations_flush(tc, tc, 1);
+
     /* mark as exited, so the GC will know to clear our stuff. */
     tc->thread_obj->body.stage = MVM_thread_stage_exited;
 
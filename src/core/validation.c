@@ -652,6 +652,8 @@ void MVM_validate_static_frame(MVMThreadContext *tc,
             case MARK_regular:
             case MARK_special:
                 validate_operands(val);
+                if (val->cur_info->opcode == MVM_OP_findmeth)
+                    fb->num_findmeth_sites++;
                 break;
 
             case MARK_sequence:
@@ -673,3 +675,41 @@ void MVM_validate_static_frame(MVMThreadContext *tc,
     /* Validation successful. Clear up instruction offsets. */
     MVM_free(val->labels);
 }
+
+/* Sees if a static frame's bytecode can go without validation, since it is
+ * exactly what the MAST compiler wrote (which type-checks operands as it
+ * goes) and we were told to trust that. If so, does the parts of validation
+ * that the interpreter relies on, and returns non-zero; otherwise returns
+ * zero, and the frame should be validated as usual. */
+MVMint32 MVM_validate_static_frame_trusted(MVMThreadContext *tc,
+        MVMStaticFrame *static_frame) {
+#ifdef MVM_BIGENDIAN
+    /* Validation also swaps the bytecode into our byte order. */
+    return 0;
+#else
+    MVMStaticFrameBody *fb = &static_frame->body;
+    MVMCompUnit        *cu = fb->cu;
+    MVMStaticFrame     *outer;
+    MVMuint32           i;
+
+    if (!tc->instance->trust_bytecode || !fb->has_frame_check)
+        return 0;
+    if (MVM_bytecode_checksum(fb->bytecode, fb->bytecode_size) != fb->check_checksum)
+        return 0;
+
+    /* Extension ops are resolved while validating them; the interpreter
+     * calls through the resolved records. */
+    for (i = 0; i < cu->body.num_extops; i++)
+        if (!MVM_ext_resolve_extop_record(tc, &cu->body.extops[i]))
+            return 0;
+
+    /* Lexical operands may refer to any frame we're nested in, so they need
+     * to be fully deserialized. */
+    for (outer = fb->outer; outer; outer = outer->body.outer)
+        if (!outer->body.fully_deserialized)
+            MVM_bytecode_finish_frame(tc, outer->body.cu, outer, 0);
+
+    fb->num_findmeth_sites = fb->check_findmeth_sites;
+    return 1;
+#endif
+}
@@ -6,3 +6,4 @@ enum {
 };
 
 void MVM_validate_static_frame(MVMThreadContext *tc, MVMStaticFrame *static_frame);
+MVMint32 MVM_validate_static_frame_trusted(MVMThreadContext *tc, MVMStaticFrame *static_frame);
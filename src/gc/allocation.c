@@ -35,6 +35,13 @@ void * MVM_gc_allocate_nursery(MVMThreadContext *tc, size_t size) {
         /* Allocate (just bump the pointer). */
         allocated = tc->nursery_alloc;
         tc->nursery_alloc = (char *)tc->nursery_alloc + size;
+
+        /* If profiling allocations, count down to the next sample. */
+        if (tc->instance->alloc_sample_interval) {
+            tc->alloc_sample_countdown -= size;
+            if (tc->alloc_sample_countdown <= 0)
+                MVM_profile_allocations_sample(tc, allocated, size);
+        }
     }
     else {
         MVM_panic(MVM_exitcode_gcalloc, "Cannot allocate 0 bytes of memory in the nursery");
@@ -269,6 +269,7 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
                  * iteration. Allocate space in the nursery. */
                 new_addr = (MVMCollectable *)tc->nursery_alloc;
                 tc->nursery_alloc = (char *)tc->nursery_alloc + item->size;
+                tc->gc_survivor_bytes += item->size;
                 GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : copying an object %p (reprid %d) of size %d to tospace %p\n",
                     item, REPR(item)->ID, item->size, new_addr);
 
@@ -525,6 +526,10 @@ void MVM_gc_collect_free_nursery_uncopied(MVMThreadContext *tc, void *limit) {
     /* We start scanning the fromspace, and keep going until we hit
      * the end of the area allocated in it. */
     void *scan = tc->nursery_fromspace;
+
+    /* Find out which sampled allocations survived, before we clear up. */
+    MVM_profile_allocations_update(tc);
+
     while (scan < limit) {
         /* The object here is dead if it never got a forwarding pointer
          * written in to it. */
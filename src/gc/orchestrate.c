@@ -209,6 +209,7 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
                 "Thread %d run %d : transferring gen2 of thread %d\n", other->thread_id);
             MVM_gc_gen2_transfer(other, tc);
+            tc->gc_gen2_bytes += other->gc_gen2_bytes;
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
                 "Thread %d run %d : destroying thread %d\n", other->thread_id);
             MVM_tc_destroy(other);
@@ -301,6 +302,7 @@ static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : starting collection for thread %d\n",
             other->thread_id);
         other->gc_promoted_bytes = 0;
+        other->gc_survivor_bytes = 0;
         MVM_gc_collect(other, (other == tc ? what_to_do : MVMGCWhatToDo_NoInstance), gen);
     }
 
@@ -332,6 +334,9 @@ static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
                 other->thread_id);
             MVM_gc_collect_free_gen2_unmarked(other, 0);
         }
+
+        /* Add this thread's figures to the GC telemetry. */
+        MVM_gc_stats_thread_done(tc, other);
     }
 }
 
@@ -346,6 +351,8 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
     if (MVM_trycas(&tc->instance->gc_start, 0, 1)) {
         MVMThread *last_starter = NULL;
         MVMuint32 num_threads = 0;
+        MVMuint64 start_time = uv_hrtime();
+        MVMuint8 full;
 
         /* Need to wait for other threads to reset their gc_status. */
         while (MVM_load(&tc->instance->gc_ack)) {
@@ -363,7 +370,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
             (int)MVM_load(&tc->instance->gc_seq_number));
 
         /* Decide if it will be a full collection. */
-        tc->instance->gc_full_collect = is_full_collection(tc);
+        tc->instance->gc_full_collect = full = is_full_collection(tc);
 
         /* If profiling, record that GC is starting. */
         if (tc->instance->profiling)
@@ -437,6 +444,11 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : coordinator entering run_gc\n");
         run_gc(tc, MVMGCWhatToDo_All);
 
+        /* Record the run in the GC telemetry. */
+        MVM_gc_stats_run_done(tc, start_time, full);
+        tc->gc_stats_runs++;
+        tc->gc_stats_time += uv_hrtime() - start_time;
+
         /* If profiling, record that GC is over. */
         if (tc->instance->profiling)
             MVM_profiler_log_gc_end(tc);
@@ -456,6 +468,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
  * try and do that, just enlist in the run. */
 void MVM_gc_enter_from_interrupt(MVMThreadContext *tc) {
     AO_t curr;
+    MVMuint64 start_time = uv_hrtime();
 
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Entered from interrupt\n");
 
@@ -486,6 +499,10 @@ void MVM_gc_enter_from_interrupt(MVMThreadContext *tc) {
     run_gc(tc, MVMGCWhatToDo_NoInstance);
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : GC complete\n");
 
+    /* Account for our time in the GC telemetry. */
+    tc->gc_stats_runs++;
+    tc->gc_stats_time += uv_hrtime() - start_time;
+
     /* If profiling, record that GC is over. */
     if (tc->instance->profiling)
         MVM_profiler_log_gc_end(tc);
@@ -78,6 +78,7 @@ void MVM_gc_root_add_instance_roots_to_worklist(MVMThreadContext *tc, MVMGCWorkl
     add_collectable(tc, worklist, snapshot, tc->instance->event_loop_todo_queue, "Event loop todo queue");
     add_collectable(tc, worklist, snapshot, tc->instance->event_loop_cancel_queue, "Event loop cancel queue");
     add_collectable(tc, worklist, snapshot, tc->instance->event_loop_active, "Event loop active");
+    MVM_io_timer_wheel_mark(tc, worklist, snapshot);
 
     int_to_str_cache = tc->instance->int_to_str_cache;
     for (i = 0; i < MVM_INT_TO_STR_CACHE_SIZE; i++)
@@ -157,8 +158,11 @@ void MVM_gc_root_add_tc_roots_to_worklist(MVMThreadContext *tc, MVMGCWorklist *w
     }
 
     /* Profiling data. */
-    if (worklist)
+    if (worklist) {
         MVM_profile_instrumented_mark_data(tc, worklist);
+        MVM_profile_sampling_mark_data(tc, worklist);
+        MVM_profile_allocations_mark_data(tc, worklist);
+    }
 
     /* Serialized string heap, if any. */
     add_collectable(tc, worklist, snapshot, tc->serialized_string_heap,
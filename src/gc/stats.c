@@ -0,0 +1,235 @@
+#include "moar.h"
+
+#define HIST_SUB_MASK ((1 << MVM_GC_STATS_HIST_SUB_BITS) - 1)
+
+/* Sets up GC telemetry, with the log to dump to if any. */
+void MVM_gc_stats_init(MVMInstance *instance, FILE *log_fh, const char *interval) {
+    MVMGCStats *stats = MVM_calloc(1, sizeof(MVMGCStats));
+    int init_stat;
+    if ((init_stat = uv_mutex_init(&stats->mutex)) < 0) {
+        fprintf(stderr, "MoarVM: Initialization of GC stats mutex failed\n    %s\n",
+            uv_strerror(init_stat));
+        exit(1);
+    }
+    stats->start_time     = uv_hrtime();
+    stats->last_full_time = stats->start_time;
+    stats->log_last       = stats->start_time;
+    stats->log_fh         = log_fh;
+    stats->log_interval   = (MVMuint64)MVM_GC_STATS_DEFAULT_INTERVAL * 1000000000;
+    if (interval && strlen(interval)) {
+        MVMnum64 seconds = atof(interval);
+        if (seconds > 0)
+            stats->log_interval = (MVMuint64)(seconds * 1e9);
+    }
+    instance->gc_stats = stats;
+}
+
+/* Finds the histogram bucket for a pause time. */
+static MVMuint32 bucket_of(MVMuint64 ns) {
+    MVMuint32 msb = 0;
+    MVMuint64 v   = ns;
+    if (ns < ((MVMuint64)1 << MVM_GC_STATS_HIST_MIN_BITS))
+        return 0;
+    while (v >>= 1)
+        msb++;
+    if (msb >= MVM_GC_STATS_HIST_MAX_BITS)
+        return MVM_GC_STATS_HIST_BUCKETS - 1;
+    return 1 + ((msb - MVM_GC_STATS_HIST_MIN_BITS) << MVM_GC_STATS_HIST_SUB_BITS)
+        + (MVMuint32)((ns >> (msb - MVM_GC_STATS_HIST_SUB_BITS)) & HIST_SUB_MASK);
+}
+
+/* The smallest pause time that goes into a bucket. */
+static MVMuint64 bucket_start(MVMuint32 i) {
+    MVMuint32 k, msb;
+    if (i == 0)
+        return 0;
+    if (i >= MVM_GC_STATS_HIST_BUCKETS - 1)
+        return (MVMuint64)1 << MVM_GC_STATS_HIST_MAX_BITS;
+    k   = i - 1;
+    msb = MVM_GC_STATS_HIST_MIN_BITS + (k >> MVM_GC_STATS_HIST_SUB_BITS);
+    return ((MVMuint64)1 << msb)
+        + ((MVMuint64)(k & HIST_SUB_MASK) << (msb - MVM_GC_STATS_HIST_SUB_BITS));
+}
+
+/* Estimates a percentile of the pause times, as the end of the bucket it
+ * falls in (but no more than the longest pause). Expects the lock held. */
+static MVMuint64 pause_percentile(MVMGCStats *stats, MVMuint32 percent) {
+    MVMuint64 runs   = stats->nursery_runs + stats->full_runs;
+    MVMuint64 target = (runs * percent + 99) / 100;
+    MVMuint64 seen   = 0;
+    MVMuint32 i;
+    if (!runs)
+        return 0;
+    for (i = 0; i < MVM_GC_STATS_HIST_BUCKETS - 1; i++) {
+        seen += stats->pause_hist[i];
+        if (seen >= target) {
+            MVMuint64 end = bucket_start(i + 1);
+            return end < stats->pause_max ? end : stats->pause_max;
+        }
+    }
+    return stats->pause_max;
+}
+
+/* Works out how much space a gen2 allocator takes: the pages of its size
+ * classes and the objects too big for them. */
+static MVMuint64 gen2_bytes(MVMGen2Allocator *al) {
+    MVMuint64 total = 0;
+    MVMuint32 i;
+    for (i = 0; i < MVM_GEN2_BINS; i++)
+        total += (MVMuint64)al->size_classes[i].num_pages * MVM_GEN2_PAGE_ITEMS
+            * ((i + 1) << MVM_GEN2_BIN_BITS);
+    for (i = 0; i < al->num_overflows; i++)
+        if (al->overflows[i])
+            total += al->overflows[i]->size;
+    return total;
+}
+
+/* Called by a thread once it has finished the GC work for another (or
+ * itself), to add in the bytes promoted and surviving in the nursery, and
+ * update how big that thread's gen2 is. */
+void MVM_gc_stats_thread_done(MVMThreadContext *tc, MVMThreadContext *other) {
+    MVMGCStats *stats = tc->instance->gc_stats;
+    MVMuint64   now_gen2;
+    MVM_add(&stats->promoted_bytes, other->gc_promoted_bytes);
+    MVM_add(&stats->survivor_bytes, other->gc_survivor_bytes);
+    now_gen2 = gen2_bytes(other->gen2);
+    MVM_add(&stats->gen2_bytes, (AO_t)(now_gen2 - other->gc_gen2_bytes));
+    other->gc_gen2_bytes = now_gen2;
+}
+
+/* Writes a line to the log. Expects the lock held. */
+static void write_log(MVMGCStats *stats, MVMuint64 now) {
+    fprintf(stats->log_fh,
+        "%"PRIu64" nursery=%"PRIu64" full=%"PRIu64" pause_total=%"PRIu64" pause_max=%"PRIu64
+        " pause_p50=%"PRIu64" pause_p99=%"PRIu64" promoted=%"PRIu64" survivors=%"PRIu64
+        " gen2=%"PRIu64"\n",
+        (now - stats->start_time) / 1000000,
+        stats->nursery_runs, stats->full_runs,
+        stats->pause_total, stats->pause_max,
+        pause_percentile(stats, 50), pause_percentile(stats, 99),
+        (MVMuint64)MVM_load(&stats->promoted_bytes),
+        (MVMuint64)MVM_load(&stats->survivor_bytes),
+        (MVMuint64)MVM_load(&stats->gen2_bytes));
+    fflush(stats->log_fh);
+}
+
+/* Called by the coordinator at the end of a GC run, with the time it
+ * started; records the pause, and dumps to the log if it's time. */
+void MVM_gc_stats_run_done(MVMThreadContext *tc, MVMuint64 start, MVMuint8 full) {
+    MVMGCStats *stats = tc->instance->gc_stats;
+    MVMuint64   now   = uv_hrtime();
+    MVMuint64   pause = now - start;
+    uv_mutex_lock(&stats->mutex);
+    if (full) {
+        stats->full_runs++;
+        stats->last_full_time = now;
+    }
+    else {
+        stats->nursery_runs++;
+    }
+    stats->pause_total += pause;
+    stats->pause_last   = pause;
+    if (pause > stats->pause_max)
+        stats->pause_max = pause;
+    stats->pause_hist[bucket_of(pause)]++;
+    if (stats->log_fh && now - stats->log_last >= stats->log_interval) {
+        write_log(stats, now);
+        stats->log_last = now;
+    }
+    uv_mutex_unlock(&stats->mutex);
+}
+
+/* Gets the GC telemetry as a hash. Times are in nanoseconds. */
+#define vmstr(tc, cstr) MVM_string_utf8_decode(tc, tc->instance->VMString, cstr, strlen(cstr))
+#define box_i(tc, i) MVM_repr_box_int(tc, MVM_hll_current(tc)->int_box_type, i)
+#define bind_i(tc, hash, key, i) MVM_repr_bind_key_o(tc, hash, vmstr(tc, key), box_i(tc, i))
+MVMObject * MVM_gc_stats_query(MVMThreadContext *tc) {
+    MVMGCStats *stats = tc->instance->gc_stats;
+    MVMObject  *result, *hist, *threads;
+    MVMThread  *thread;
+    MVMuint64   copy[MVM_GC_STATS_HIST_BUCKETS];
+    MVMuint64   nursery_runs, full_runs, pause_total, pause_max, pause_last;
+    MVMuint64   p50, p90, p99, last_full_time, now;
+    MVMuint32   i;
+
+    /* Take a copy under the lock, since building the result allocates. */
+    uv_mutex_lock(&stats->mutex);
+    nursery_runs   = stats->nursery_runs;
+    full_runs      = stats->full_runs;
+    pause_total    = stats->pause_total;
+    pause_max      = stats->pause_max;
+    pause_last     = stats->pause_last;
+    last_full_time = stats->last_full_time;
+    p50            = pause_percentile(stats, 50);
+    p90            = pause_percentile(stats, 90);
+    p99            = pause_percentile(stats, 99);
+    memcpy(copy, stats->pause_hist, sizeof(copy));
+    uv_mutex_unlock(&stats->mutex);
+    now = uv_hrtime();
+
+    /* Allocate in gen2, so as not to trigger GC; besides keeping what we
+     * build safe, no GC can start while we walk the threads list. */
+    MVM_gc_allocate_gen2_default_set(tc);
+    result = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+    bind_i(tc, result, "uptime", now - stats->start_time);
+    bind_i(tc, result, "nursery_collections", nursery_runs);
+    bind_i(tc, result, "full_collections", full_runs);
+    bind_i(tc, result, "since_full_collection", now - last_full_time);
+    bind_i(tc, result, "pause_total", pause_total);
+    bind_i(tc, result, "pause_max", pause_max);
+    bind_i(tc, result, "pause_last", pause_last);
+    bind_i(tc, result, "pause_p50", p50);
+    bind_i(tc, result, "pause_p90", p90);
+    bind_i(tc, result, "pause_p99", p99);
+    bind_i(tc, result, "promoted_bytes", MVM_load(&stats->promoted_bytes));
+    bind_i(tc, result, "survivor_bytes", MVM_load(&stats->survivor_bytes));
+    bind_i(tc, result, "promoted_since_full",
+        MVM_load(&tc->instance->gc_promoted_bytes_since_last_full));
+    bind_i(tc, result, "gen2_bytes", MVM_load(&stats->gen2_bytes));
+
+    /* The histogram, as a list of the non-empty buckets, giving the
+     * shortest pause that goes in each and how many there were. */
+    hist = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_array_type);
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "pause_histogram"), hist);
+    for (i = 0; i < MVM_GC_STATS_HIST_BUCKETS; i++) {
+        if (copy[i]) {
+            MVMObject *bucket = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+            MVM_repr_push_o(tc, hist, bucket);
+            bind_i(tc, bucket, "from", bucket_start(i));
+            bind_i(tc, bucket, "count", copy[i]);
+        }
+    }
+
+    /* Per-thread time spent in GC. */
+    threads = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_array_type);
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "threads"), threads);
+    thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    while (thread) {
+        MVMThreadContext *ttc = thread->body.tc;
+        if (ttc) {
+            MVMObject *entry = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+            MVM_repr_push_o(tc, threads, entry);
+            bind_i(tc, entry, "thread_id", ttc->thread_id);
+            bind_i(tc, entry, "collections", ttc->gc_stats_runs);
+            bind_i(tc, entry, "gc_time", ttc->gc_stats_time);
+            bind_i(tc, entry, "gen2_bytes", ttc->gc_gen2_bytes);
+        }
+        thread = thread->body.next;
+    }
+    MVM_gc_allocate_gen2_default_clear(tc);
+    return result;
+}
+
+/* Cleans up GC telemetry at instance shutdown. */
+void MVM_gc_stats_destroy(MVMInstance *instance) {
+    MVMGCStats *stats = instance->gc_stats;
+    if (stats->log_fh) {
+        uv_mutex_lock(&stats->mutex);
+        write_log(stats, uv_hrtime());
+        uv_mutex_unlock(&stats->mutex);
+        fclose(stats->log_fh);
+    }
+    uv_mutex_destroy(&stats->mutex);
+    MVM_free(stats);
+    instance->gc_stats = NULL;
+}
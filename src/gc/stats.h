@@ -0,0 +1,59 @@
+/* GC telemetry. Counters and a histogram of pause times are kept for every
+ * GC run, always; the coordinator records each run once it's over, so the
+ * cost is a couple of clock reads and an uncontended lock per run. They can
+ * be queried with the gcstats op, and if MVM_GC_STATS_LOG is set to a file
+ * name they are appended to it as a line every MVM_GC_STATS_INTERVAL
+ * seconds (10 by default), checked at the end of each run. */
+
+/* Pause times go in a log-linear histogram: each power of two from 2^MIN
+ * to 2^MAX nanoseconds is split into 2^SUB_BITS buckets, with one more below
+ * and one more above that range. */
+#define MVM_GC_STATS_HIST_SUB_BITS  2
+#define MVM_GC_STATS_HIST_MIN_BITS  10
+#define MVM_GC_STATS_HIST_MAX_BITS  40
+#define MVM_GC_STATS_HIST_BUCKETS \
+    (2 + ((MVM_GC_STATS_HIST_MAX_BITS - MVM_GC_STATS_HIST_MIN_BITS) << MVM_GC_STATS_HIST_SUB_BITS))
+
+/* Default interval between dumps to the log, in seconds. */
+#define MVM_GC_STATS_DEFAULT_INTERVAL 10
+
+struct MVMGCStats {
+    /* Protects the run counts, pause times and log; the byte counts are
+     * added to atomically by each thread as it finishes its work. */
+    uv_mutex_t mutex;
+
+    /* When the instance started, and when the last full collection was. */
+    MVMuint64 start_time;
+    MVMuint64 last_full_time;
+
+    /* Number of nursery-only and full collections. */
+    MVMuint64 nursery_runs;
+    MVMuint64 full_runs;
+
+    /* Pause times, in nanoseconds, as seen by the coordinator. */
+    MVMuint64 pause_total;
+    MVMuint64 pause_max;
+    MVMuint64 pause_last;
+    MVMuint64 pause_hist[MVM_GC_STATS_HIST_BUCKETS];
+
+    /* Bytes promoted to gen2, and bytes that survived a collection while
+     * staying in the nursery. */
+    AO_t promoted_bytes;
+    AO_t survivor_bytes;
+
+    /* Space taken by gen2 across all threads, as of each thread's last
+     * collection. */
+    AO_t gen2_bytes;
+
+    /* The log to dump to, the interval in nanoseconds, and when we last
+     * dumped. */
+    FILE *log_fh;
+    MVMuint64 log_interval;
+    MVMuint64 log_last;
+};
+
+void MVM_gc_stats_init(MVMInstance *instance, FILE *log_fh, const char *interval);
+void MVM_gc_stats_thread_done(MVMThreadContext *tc, MVMThreadContext *other);
+void MVM_gc_stats_run_done(MVMThreadContext *tc, MVMuint64 start, MVMuint8 full);
+MVMObject * MVM_gc_stats_query(MVMThreadContext *tc);
+void MVM_gc_stats_destroy(MVMInstance *instance);
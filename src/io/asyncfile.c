@@ -0,0 +1,659 @@
+#include "moar.h"
+#include "platform/io.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+/* Asynchronous reading and writing of files. These are done with libuv's
+ * file system requests, which run on its thread pool, so the thread that
+ * asked for the I/O never waits for the disk. Reads are done from explicit
+ * offsets, with a number of chunks in flight at once (the read-ahead), and
+ * the chunks are delivered to the queue in order, just like socket reads.
+ * Writes have their place in the file reserved at the point they are asked
+ * for, so concurrent writes land in the order they were made; on handles
+ * opened for appending, where the kernel picks the place, they are instead
+ * done one at a time. */
+
+/* Default read-ahead: the size of each chunk, and how many may be read at
+ * once. Can be changed per handle with set_read_ahead. */
+#define DEFAULT_CHUNK_SIZE      65536
+#define DEFAULT_MAX_IN_FLIGHT   4
+
+/* Limits on read-ahead settings. */
+#define MAX_CHUNK_SIZE          16777216
+#define MAX_IN_FLIGHT           64
+
+/* States of a slot used for an in-flight read. */
+#define SLOT_FREE       0
+#define SLOT_READING    1
+#define SLOT_DONE       2
+
+/* A single chunk read. */
+typedef struct {
+    uv_fs_t  req;
+    char    *buf;
+    ssize_t  result;
+    MVMint32 state;
+    void    *ri;
+} ReadSlot;
+
+/* Info we convey about a read task. */
+typedef struct {
+    MVMOSHandle      *handle;
+    MVMDecodeStream  *ds;
+    MVMObject        *buf_type;
+    uv_file           fd;
+    MVMint64          offset;
+    MVMint32          chunk_size;
+    MVMint32          num_slots;
+    ReadSlot         *slots;
+    MVMint64          next_issue;
+    MVMint64          next_deliver;
+    MVMint32          saw_eof;
+    MVMint32          finished;
+    MVMThreadContext *tc;
+    int               work_idx;
+} ReadInfo;
+
+static void issue_reads(MVMThreadContext *tc, ReadInfo *ri, MVMAsyncTask *t, uv_loop_t *loop);
+
+/* Sends an error to the queue, and stops delivering anything else. */
+static void read_error(MVMThreadContext *tc, ReadInfo *ri, MVMAsyncTask *t, int status) {
+    MVMObject *arr;
+    MVMROOT(tc, t, {
+        arr = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTArray);
+        MVM_repr_push_o(tc, arr, t->body.schedulee);
+        MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTInt);
+        MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTStr);
+        MVMROOT(tc, arr, {
+            MVMString *msg_str = MVM_string_ascii_decode_nt(tc,
+                tc->instance->VMString, uv_strerror(status));
+            MVMObject *msg_box = MVM_repr_box_str(tc,
+                tc->instance->boot_types.BOOTStr, msg_str);
+            MVM_repr_push_o(tc, arr, msg_box);
+        });
+        MVM_repr_push_o(tc, t->body.queue, arr);
+    });
+    ri->finished = 1;
+}
+
+/* Sends a chunk that was read to the queue; takes ownership of the buffer. */
+static void read_deliver(MVMThreadContext *tc, ReadInfo *ri, MVMAsyncTask *t, char *buf, ssize_t nread) {
+    MVMObject *arr;
+    MVMROOT(tc, t, {
+        arr = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTArray);
+        MVM_repr_push_o(tc, arr, t->body.schedulee);
+        MVMROOT(tc, arr, {
+            /* Push the sequence number. */
+            MVMObject *seq_boxed = MVM_repr_box_int(tc,
+                tc->instance->boot_types.BOOTInt, ri->next_deliver);
+            MVM_repr_push_o(tc, arr, seq_boxed);
+
+            /* Either need to produce a buffer or decode characters. */
+            if (ri->ds) {
+                MVMString *str;
+                MVMObject *boxed_str;
+                MVM_string_decodestream_add_bytes(tc, ri->ds, buf, nread);
+                str = MVM_string_decodestream_get_all(tc, ri->ds);
+                boxed_str = MVM_repr_box_str(tc, tc->instance->boot_types.BOOTStr, str);
+                MVM_repr_push_o(tc, arr, boxed_str);
+            }
+            else {
+                MVMArray *res_buf      = (MVMArray *)MVM_repr_alloc_init(tc, ri->buf_type);
+                res_buf->body.slots.i8 = (MVMint8 *)buf;
+                res_buf->body.start    = 0;
+                res_buf->body.ssize    = nread;
+                res_buf->body.elems    = nread;
+                MVM_repr_push_o(tc, arr, (MVMObject *)res_buf);
+            }
+
+            /* Finally, no error. */
+            MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTStr);
+        });
+        MVM_repr_push_o(tc, t->body.queue, arr);
+    });
+}
+
+/* Sends the end of file notification to the queue. */
+static void read_eof(MVMThreadContext *tc, ReadInfo *ri, MVMAsyncTask *t) {
+    MVMObject *arr;
+    MVMROOT(tc, t, {
+        arr = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTArray);
+        MVM_repr_push_o(tc, arr, t->body.schedulee);
+        MVMROOT(tc, arr, {
+            MVMObject *final = MVM_repr_box_int(tc,
+                tc->instance->boot_types.BOOTInt, ri->next_deliver);
+            MVM_repr_push_o(tc, arr, final);
+            MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTStr);
+            MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTStr);
+        });
+        MVM_repr_push_o(tc, t->body.queue, arr);
+    });
+    ri->finished = 1;
+}
+
+/* Delivers all chunks that have completed and are next in sequence. Chunks
+ * may complete in any order, but must reach the queue in file order. */
+static void deliver_ready(MVMThreadContext *tc, ReadInfo *ri, MVMAsyncTask *t) {
+    while (!ri->finished) {
+        ReadSlot *next = &(ri->slots[ri->next_deliver % ri->num_slots]);
+        if (next->state != SLOT_DONE) {
+            /* If nothing more will be read, we're at the end. */
+            if (ri->saw_eof && ri->next_deliver == ri->next_issue)
+                read_eof(tc, ri, t);
+            break;
+        }
+        next->state = SLOT_FREE;
+        if (next->result > 0) {
+            read_deliver(tc, ri, t, next->buf, next->result);
+            next->buf = NULL;
+            ri->next_deliver++;
+        }
+        else if (next->result == 0) {
+            read_eof(tc, ri, t);
+        }
+        else {
+            read_error(tc, ri, t, (int)next->result);
+        }
+    }
+}
+
+/* Read completion handler. Delivers what it can, then issues more reads into
+ * the slots that frees up. */
+static void on_read(uv_fs_t *req) {
+    ReadSlot         *slot = (ReadSlot *)req->data;
+    ReadInfo         *ri   = (ReadInfo *)slot->ri;
+    MVMThreadContext *tc   = ri->tc;
+    MVMAsyncTask     *t    = (MVMAsyncTask *)MVM_repr_at_pos_o(tc,
+        tc->instance->event_loop_active, ri->work_idx);
+    slot->result = req->result;
+    slot->state  = SLOT_DONE;
+    uv_fs_req_cleanup(req);
+
+    /* A short read means we reached the end of the file; reads already in
+     * flight beyond it will just come back empty. */
+    if (slot->result < ri->chunk_size)
+        ri->saw_eof = 1;
+
+    deliver_ready(tc, ri, t);
+
+    /* Once we're finished, reads still in flight just free their buffers. */
+    if (ri->finished) {
+        MVM_free(slot->buf);
+        slot->buf   = NULL;
+        slot->state = SLOT_FREE;
+    }
+    else {
+        issue_reads(tc, ri, t, req->loop);
+    }
+}
+
+/* Issues reads into all free slots, unless we already know we hit the end of
+ * the file. */
+static void issue_reads(MVMThreadContext *tc, ReadInfo *ri, MVMAsyncTask *t, uv_loop_t *loop) {
+    while (!ri->finished && !ri->saw_eof) {
+        ReadSlot *slot = &(ri->slots[ri->next_issue % ri->num_slots]);
+        uv_buf_t  read_buf;
+        int       r;
+        if (slot->state != SLOT_FREE)
+            break;
+        if (!slot->buf)
+            slot->buf  = MVM_malloc(ri->chunk_size);
+        slot->ri       = ri;
+        slot->req.data = slot;
+        slot->state    = SLOT_READING;
+        read_buf       = uv_buf_init(slot->buf, ri->chunk_size);
+        ri->next_issue++;
+        /* The handle may have been closed since the read was set up, in
+         * which case the descriptor may by now belong to another file. */
+        if (((MVMIOFileData *)ri->handle->body.data)->fd != ri->fd)
+            r = UV_EBADF;
+        else
+            r = uv_fs_read(loop, &(slot->req), ri->fd, &read_buf, 1, ri->offset, on_read);
+        if (r < 0) {
+            /* Report the error in sequence, as if the read had failed. */
+            slot->result = r;
+            slot->state  = SLOT_DONE;
+            ri->saw_eof  = 1;
+            deliver_ready(tc, ri, t);
+            break;
+        }
+        ri->offset += ri->chunk_size;
+    }
+}
+
+/* Does setup work for setting up asynchronous reads. */
+static void read_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_task, void *data) {
+    ReadInfo *ri  = (ReadInfo *)data;
+    ri->tc        = tc;
+    ri->work_idx  = MVM_repr_elems(tc, tc->instance->event_loop_active);
+    MVM_repr_push_o(tc, tc->instance->event_loop_active, async_task);
+    issue_reads(tc, ri, (MVMAsyncTask *)async_task, loop);
+}
+
+/* Cancels the reads that have not yet started. */
+static void read_cancel(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_task, void *data) {
+    ReadInfo *ri = (ReadInfo *)data;
+    MVMint32  i;
+    ri->finished = 1;
+    for (i = 0; i < ri->num_slots; i++)
+        if (ri->slots[i].state == SLOT_READING)
+            uv_cancel((uv_req_t *)&(ri->slots[i].req));
+}
+
+/* Marks objects for a read task. */
+static void read_gc_mark(MVMThreadContext *tc, void *data, MVMGCWorklist *worklist) {
+    ReadInfo *ri = (ReadInfo *)data;
+    MVM_gc_worklist_add(tc, worklist, &ri->buf_type);
+    MVM_gc_worklist_add(tc, worklist, &ri->handle);
+}
+
+/* Frees info for a read task. */
+static void read_gc_free(MVMThreadContext *tc, MVMObject *t, void *data) {
+    if (data) {
+        ReadInfo *ri = (ReadInfo *)data;
+        MVMint32  i;
+        if (ri->ds)
+            MVM_string_decodestream_destory(tc, ri->ds);
+        for (i = 0; i < ri->num_slots; i++)
+            MVM_free(ri->slots[i].buf);
+        MVM_free(ri->slots);
+        MVM_free(data);
+    }
+}
+
+/* Operations table for async read task. */
+static const MVMAsyncTaskOps read_op_table = {
+    read_setup,
+    read_cancel,
+    read_gc_mark,
+    read_gc_free
+};
+
+/* Sets up the read info for a file handle, starting from the handle's
+ * current position. The handle's own position is not changed by the read. */
+static ReadInfo * make_read_info(MVMThreadContext *tc, MVMOSHandle *h) {
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    ReadInfo      *ri;
+    if (data->fd == -1)
+        MVM_exception_throw_adhoc(tc, "Cannot read from a closed filehandle");
+    ri = MVM_calloc(1, sizeof(ReadInfo));
+    if (data->ds) {
+        ri->offset = MVM_string_decodestream_tell_bytes(tc, data->ds);
+    }
+    else if ((ri->offset = MVM_platform_lseek(data->fd, 0, SEEK_CUR)) == -1) {
+        MVM_free(ri);
+        MVM_exception_throw_adhoc(tc, "Failed to seek in filehandle: %d", errno);
+    }
+    ri->fd         = data->fd;
+    ri->chunk_size = data->async_chunk_size ? data->async_chunk_size : DEFAULT_CHUNK_SIZE;
+    ri->num_slots  = data->async_max_in_flight ? data->async_max_in_flight : DEFAULT_MAX_IN_FLIGHT;
+    ri->slots      = MVM_calloc(ri->num_slots, sizeof(ReadSlot));
+    return ri;
+}
+
+MVMAsyncTask * MVM_io_file_read_chars_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+                                            MVMObject *schedulee, MVMObject *async_type) {
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    MVMAsyncTask  *task;
+    ReadInfo      *ri;
+
+    /* Validate REPRs. */
+    if (REPR(queue)->ID != MVM_REPR_ID_ConcBlockingQueue)
+        MVM_exception_throw_adhoc(tc,
+            "asyncreadchars target queue must have ConcBlockingQueue REPR");
+    if (REPR(async_type)->ID != MVM_REPR_ID_MVMAsyncTask)
+        MVM_exception_throw_adhoc(tc,
+            "asyncreadchars result type must have REPR AsyncTask");
+
+    /* Create async task handle. */
+    MVMROOT(tc, queue, {
+    MVMROOT(tc, schedulee, {
+    MVMROOT(tc, h, {
+        task = (MVMAsyncTask *)MVM_repr_alloc_init(tc, async_type);
+    });
+    });
+    });
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.queue, queue);
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.schedulee, schedulee);
+    task->body.ops  = &read_op_table;
+    ri              = make_read_info(tc, h);
+    ri->ds          = MVM_string_decodestream_create(tc, data->encoding, 0, 1);
+    MVM_ASSIGN_REF(tc, &(task->common.header), ri->handle, h);
+    task->body.data = ri;
+
+    /* Hand the task off to the event loop. */
+    MVM_io_eventloop_queue_work(tc, (MVMObject *)task);
+
+    return task;
+}
+
+MVMAsyncTask * MVM_io_file_read_bytes_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+                                            MVMObject *schedulee, MVMObject *buf_type, MVMObject *async_type) {
+    MVMAsyncTask *task;
+    ReadInfo     *ri;
+
+    /* Validate REPRs. */
+    if (REPR(queue)->ID != MVM_REPR_ID_ConcBlockingQueue)
+        MVM_exception_throw_adhoc(tc,
+            "asyncreadbytes target queue must have ConcBlockingQueue REPR");
+    if (REPR(async_type)->ID != MVM_REPR_ID_MVMAsyncTask)
+        MVM_exception_throw_adhoc(tc,
+            "asyncreadbytes result type must have REPR AsyncTask");
+    if (REPR(buf_type)->ID == MVM_REPR_ID_MVMArray) {
+        MVMint32 slot_type = ((MVMArrayREPRData *)STABLE(buf_type)->REPR_data)->slot_type;
+        if (slot_type != MVM_ARRAY_U8 && slot_type != MVM_ARRAY_I8)
+            MVM_exception_throw_adhoc(tc, "asyncreadbytes buffer type must be an array of uint8 or int8");
+    }
+    else {
+        MVM_exception_throw_adhoc(tc, "asyncreadbytes buffer type must be an array");
+    }
+
+    /* Create async task handle. */
+    MVMROOT(tc, queue, {
+    MVMROOT(tc, schedulee, {
+    MVMROOT(tc, h, {
+    MVMROOT(tc, buf_type, {
+        task = (MVMAsyncTask *)MVM_repr_alloc_init(tc, async_type);
+    });
+    });
+    });
+    });
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.queue, queue);
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.schedulee, schedulee);
+    task->body.ops  = &read_op_table;
+    ri              = make_read_info(tc, h);
+    MVM_ASSIGN_REF(tc, &(task->common.header), ri->buf_type, buf_type);
+    MVM_ASSIGN_REF(tc, &(task->common.header), ri->handle, h);
+    task->body.data = ri;
+
+    /* Hand the task off to the event loop. */
+    MVM_io_eventloop_queue_work(tc, (MVMObject *)task);
+
+    return task;
+}
+
+/* Configures read-ahead for asynchronous reads on the handle. */
+void MVM_io_file_set_read_ahead(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 chunk_size,
+                                MVMint64 max_in_flight) {
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    if (chunk_size < 1 || chunk_size > MAX_CHUNK_SIZE)
+        MVM_exception_throw_adhoc(tc, "Read-ahead chunk size must be between 1 and %d bytes",
+            MAX_CHUNK_SIZE);
+    if (max_in_flight < 1 || max_in_flight > MAX_IN_FLIGHT)
+        MVM_exception_throw_adhoc(tc, "Read-ahead must have between 1 and %d chunks in flight",
+            MAX_IN_FLIGHT);
+    data->async_chunk_size    = (MVMint32)chunk_size;
+    data->async_max_in_flight = (MVMint32)max_in_flight;
+}
+
+/* Info we convey about a write task. */
+typedef struct WriteInfo {
+    MVMOSHandle      *handle;
+    MVMObject        *buf_data;
+    char             *output;
+    MVMint64          output_size;
+    MVMint64          written;
+    MVMint64          offset;
+    uv_file           fd;
+    MVMint32          append;
+    struct WriteInfo *next_append;
+    uv_fs_t           req;
+    MVMThreadContext *tc;
+    int               work_idx;
+} WriteInfo;
+
+static void on_write(uv_fs_t *req);
+
+/* Issues a write of whatever of the output has not yet been written. Appends
+ * go wherever the kernel puts them; other writes go at the position that was
+ * reserved for them. */
+static int issue_write(uv_loop_t *loop, WriteInfo *wi) {
+    uv_buf_t write_buf = uv_buf_init(wi->output + wi->written,
+        (unsigned int)(wi->output_size - wi->written));
+    /* The handle may have been closed since the write was asked for, in
+     * which case the descriptor may by now belong to another file. */
+    if (((MVMIOFileData *)wi->handle->body.data)->fd != wi->fd)
+        return UV_EBADF;
+    wi->req.data = wi;
+    return uv_fs_write(loop, &(wi->req), wi->fd, &write_buf, 1,
+        wi->append ? -1 : wi->offset + wi->written, on_write);
+}
+
+/* Sends the outcome of a write to the queue: the number of bytes written, or
+ * an error. */
+static void write_done(MVMThreadContext *tc, WriteInfo *wi, ssize_t result) {
+    MVMObject    *arr = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTArray);
+    MVMAsyncTask *t   = (MVMAsyncTask *)MVM_repr_at_pos_o(tc,
+        tc->instance->event_loop_active, wi->work_idx);
+    MVM_repr_push_o(tc, arr, t->body.schedulee);
+    if (result >= 0) {
+        MVMROOT(tc, arr, {
+        MVMROOT(tc, t, {
+            MVMObject *bytes_box = MVM_repr_box_int(tc,
+                tc->instance->boot_types.BOOTInt, result);
+            MVM_repr_push_o(tc, arr, bytes_box);
+        });
+        });
+        MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTStr);
+    }
+    else {
+        MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTInt);
+        MVMROOT(tc, arr, {
+        MVMROOT(tc, t, {
+            MVMString *msg_str = MVM_string_ascii_decode_nt(tc,
+                tc->instance->VMString, uv_strerror((int)result));
+            MVMObject *msg_box = MVM_repr_box_str(tc,
+                tc->instance->boot_types.BOOTStr, msg_str);
+            MVM_repr_push_o(tc, arr, msg_box);
+        });
+        });
+    }
+    MVM_repr_push_o(tc, t->body.queue, arr);
+    if (!wi->buf_data) {
+        MVM_free(wi->output);
+        wi->output = NULL;
+    }
+}
+
+/* Once an append is done, starts the next one waiting on the handle, if any.
+ * Only the event loop thread touches the wait list. */
+static void next_append(MVMThreadContext *tc, uv_loop_t *loop, WriteInfo *wi) {
+    MVMIOFileData *data = (MVMIOFileData *)wi->handle->body.data;
+    WriteInfo     *next = wi->next_append;
+    int            r;
+    wi->next_append = NULL;
+    while (next) {
+        data->async_appends_head = next;
+        if ((r = issue_write(loop, next)) >= 0)
+            return;
+        write_done(tc, next, r);
+        wi              = next;
+        next            = wi->next_append;
+        wi->next_append = NULL;
+    }
+    data->async_appends_head = NULL;
+    data->async_appends_tail = NULL;
+}
+
+/* Completion handler for an asynchronous write. */
+static void on_write(uv_fs_t *req) {
+    WriteInfo        *wi     = (WriteInfo *)req->data;
+    MVMThreadContext *tc     = wi->tc;
+    ssize_t           result = req->result;
+    uv_fs_req_cleanup(req);
+
+    /* A short write is not the end of it; write the rest. */
+    if (result > 0) {
+        wi->written += result;
+        if (wi->written < wi->output_size) {
+            int r;
+            if ((r = issue_write(req->loop, wi)) >= 0)
+                return;
+            result = r;
+        }
+    }
+    write_done(tc, wi, result >= 0 ? wi->written : result);
+    if (wi->append)
+        next_append(tc, req->loop, wi);
+}
+
+/* Does setup work for an asynchronous write. */
+static void write_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_task, void *data) {
+    WriteInfo *wi = (WriteInfo *)data;
+    int        r;
+
+    /* Add to work in progress. */
+    wi->tc        = tc;
+    wi->work_idx  = MVM_repr_elems(tc, tc->instance->event_loop_active);
+    MVM_repr_push_o(tc, tc->instance->event_loop_active, async_task);
+
+    /* Extract buf data now, if we're writing a buffer. */
+    if (wi->buf_data) {
+        MVMArray *buffer = (MVMArray *)wi->buf_data;
+        wi->output = (char *)(buffer->body.slots.i8 + buffer->body.start);
+    }
+
+    /* With no reserved position, appends must go one at a time to land in
+     * the order they were made; wait behind any already under way. */
+    if (wi->append) {
+        MVMIOFileData *fdata = (MVMIOFileData *)wi->handle->body.data;
+        if (fdata->async_appends_tail) {
+            ((WriteInfo *)fdata->async_appends_tail)->next_append = wi;
+            fdata->async_appends_tail = wi;
+            return;
+        }
+        fdata->async_appends_head = wi;
+        fdata->async_appends_tail = wi;
+    }
+
+    /* Write at the position we reserved. */
+    if ((r = issue_write(loop, wi)) < 0) {
+        /* Error; need to notify. */
+        write_done(tc, wi, r);
+        if (wi->append)
+            next_append(tc, loop, wi);
+    }
+}
+
+/* Marks objects for a write task. */
+static void write_gc_mark(MVMThreadContext *tc, void *data, MVMGCWorklist *worklist) {
+    WriteInfo *wi = (WriteInfo *)data;
+    MVM_gc_worklist_add(tc, worklist, &wi->handle);
+    MVM_gc_worklist_add(tc, worklist, &wi->buf_data);
+}
+
+/* Frees info for a write task. */
+static void write_gc_free(MVMThreadContext *tc, MVMObject *t, void *data) {
+    if (data) {
+        WriteInfo *wi = (WriteInfo *)data;
+        if (!wi->buf_data)
+            MVM_free(wi->output);
+        MVM_free(data);
+    }
+}
+
+/* Operations table for async write task. */
+static const MVMAsyncTaskOps write_op_table = {
+    write_setup,
+    NULL,
+    write_gc_mark,
+    write_gc_free
+};
+
+/* Checks if the handle was opened for appending; the kernel puts such writes
+ * at the end of the file, whatever position we ask for. */
+static MVMint32 is_append(MVMIOFileData *data) {
+#ifdef _WIN32
+    return data->append;
+#else
+    int flags;
+    if (data->append)
+        return 1;
+    flags = fcntl(data->fd, F_GETFL);
+    return flags != -1 && (flags & O_APPEND);
+#endif
+}
+
+/* Reserves space for a write of the specified size at the handle's current
+ * position, and moves the position past it, so that later writes (whether
+ * synchronous or not) go after it. The handle is locked by our caller. */
+static MVMint64 reserve_write(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 size) {
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    MVMint64       offset;
+    if ((offset = MVM_platform_lseek(data->fd, 0, SEEK_CUR)) == -1 ||
+            MVM_platform_lseek(data->fd, size, SEEK_CUR) == -1)
+        MVM_exception_throw_adhoc(tc, "Failed to seek in filehandle: %d", errno);
+    return offset;
+}
+
+static MVMAsyncTask * write_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+                                  MVMObject *schedulee, char *output, MVMint64 output_size,
+                                  MVMObject *buffer, MVMObject *async_type, const char *op) {
+    MVMAsyncTask *task;
+    WriteInfo    *wi;
+
+    /* Validate REPRs. */
+    if (REPR(queue)->ID != MVM_REPR_ID_ConcBlockingQueue) {
+        MVM_free(output);
+        MVM_exception_throw_adhoc(tc,
+            "%s target queue must have ConcBlockingQueue REPR", op);
+    }
+    if (REPR(async_type)->ID != MVM_REPR_ID_MVMAsyncTask) {
+        MVM_free(output);
+        MVM_exception_throw_adhoc(tc,
+            "%s result type must have REPR AsyncTask", op);
+    }
+
+    /* Create async task handle. */
+    MVMROOT(tc, queue, {
+    MVMROOT(tc, schedulee, {
+    MVMROOT(tc, h, {
+    MVMROOT(tc, buffer, {
+        task = (MVMAsyncTask *)MVM_repr_alloc_init(tc, async_type);
+    });
+    });
+    });
+    });
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.queue, queue);
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.schedulee, schedulee);
+    task->body.ops  = &write_op_table;
+    wi              = MVM_calloc(1, sizeof(WriteInfo));
+    MVM_ASSIGN_REF(tc, &(task->common.header), wi->handle, h);
+    if (buffer)
+        MVM_ASSIGN_REF(tc, &(task->common.header), wi->buf_data, buffer);
+    wi->output      = output;
+    wi->output_size = output_size;
+    task->body.data = wi;
+    wi->fd          = ((MVMIOFileData *)h->body.data)->fd;
+    wi->append      = is_append((MVMIOFileData *)h->body.data);
+    if (!wi->append)
+        wi->offset  = reserve_write(tc, h, output_size);
+
+    /* Hand the task off to the event loop. */
+    MVM_io_eventloop_queue_work(tc, (MVMObject *)task);
+
+    return task;
+}
+
+MVMAsyncTask * MVM_io_file_write_str_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+                                           MVMObject *schedulee, MVMString *s, MVMObject *async_type) {
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    MVMuint64      output_size;
+    char          *output = MVM_string_encode(tc, s, 0, -1, &output_size, data->encoding, NULL,
+        MVM_TRANSLATE_NEWLINE_OUTPUT);
+    return write_async(tc, h, queue, schedulee, output, output_size, NULL, async_type,
+        "asyncwritestr");
+}
+
+MVMAsyncTask * MVM_io_file_write_bytes_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+                                             MVMObject *schedulee, MVMObject *buffer, MVMObject *async_type) {
+    if (REPR(buffer)->ID != MVM_REPR_ID_MVMArray)
+        MVM_exception_throw_adhoc(tc, "asyncwritebytes requires a native array to read from");
+    if (((MVMArrayREPRData *)STABLE(buffer)->REPR_data)->slot_type != MVM_ARRAY_U8
+        && ((MVMArrayREPRData *)STABLE(buffer)->REPR_data)->slot_type != MVM_ARRAY_I8)
+        MVM_exception_throw_adhoc(tc, "asyncwritebytes requires a native array of uint8 or int8");
+    return write_async(tc, h, queue, schedulee, NULL, ((MVMArray *)buffer)->body.elems,
+        buffer, async_type, "asyncwritebytes");
+}
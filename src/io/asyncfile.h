@@ -0,0 +1,10 @@
+MVMAsyncTask * MVM_io_file_read_chars_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+    MVMObject *schedulee, MVMObject *async_type);
+MVMAsyncTask * MVM_io_file_read_bytes_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+    MVMObject *schedulee, MVMObject *buf_type, MVMObject *async_type);
+void MVM_io_file_set_read_ahead(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 chunk_size,
+    MVMint64 max_in_flight);
+MVMAsyncTask * MVM_io_file_write_str_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+    MVMObject *schedulee, MVMString *s, MVMObject *async_type);
+MVMAsyncTask * MVM_io_file_write_bytes_async(MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
+    MVMObject *schedulee, MVMObject *buffer, MVMObject *async_type);
@@ -491,7 +491,7 @@ static void gc_free(MVMThreadContext *tc, MVMObject *h, void *d) {
 
 /* IO ops table, populated with functions. */
 static const MVMIOClosable      closable       = { close_socket };
-static const MVMIOAsyncReadable async_readable = { read_chars, read_bytes };
+static const MVMIOAsyncReadable async_readable = { read_chars, read_bytes, NULL };
 static const MVMIOAsyncWritable async_writable = { write_str, write_bytes };
 static const MVMIOOps op_table = {
     &closable,
@@ -507,6 +507,7 @@ static const MVMIOOps op_table = {
     NULL,
     NULL,
     NULL,
+    NULL,
     gc_free
 };
 
@@ -508,7 +508,7 @@ static void gc_free(MVMThreadContext *tc, MVMObject *h, void *d) {
 
 /* IO ops table, populated with functions. */
 static const MVMIOClosable        closable          = { close_socket };
-static const MVMIOAsyncReadable   async_readable    = { read_chars, read_bytes };
+static const MVMIOAsyncReadable   async_readable    = { read_chars, read_bytes, NULL };
 static const MVMIOAsyncWritableTo async_writable_to = { write_str_to, write_bytes_to };
 static const MVMIOOps op_table = {
     &closable,
@@ -524,6 +524,7 @@ static const MVMIOOps op_table = {
     NULL,
     NULL,
     NULL,
+    NULL,
     gc_free
 };
 
@@ -0,0 +1,487 @@
+#include "moar.h"
+#include "platform/io.h"
+
+/* Copying of data between two handles. Where both handles can hand us a
+ * native descriptor, we have the kernel move the data (copy_file_range for
+ * file to file, splice when a pipe is involved, and sendfile otherwise, all
+ * on Linux), so it never has to pass through user space. Failing that, we
+ * shuffle it through a single buffer that is allocated once per copy, and if
+ * either handle has no descriptor at all we copy through the handles' own
+ * read and write operations. */
+
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+/* Size of the buffer used when copying with read and write. */
+#define COPY_BUFFER_SIZE 65536
+
+/* The most we ask the kernel to copy in a single system call. */
+#define COPY_CHUNK_SIZE 0x40000000
+
+/* Ways we might move data between descriptors. */
+#define COPY_READ_WRITE      0
+#define COPY_SENDFILE        1
+#define COPY_SPLICE          2
+#define COPY_FILE_RANGE      3
+
+static MVMOSHandle * verify_is_handle(MVMThreadContext *tc, MVMObject *oshandle, const char *op) {
+    if (REPR(oshandle)->ID != MVM_REPR_ID_MVMOSHandle)
+        MVM_exception_throw_adhoc(tc, "%s requires an object with REPR MVMOSHandle", op);
+    return (MVMOSHandle *)oshandle;
+}
+
+static uv_mutex_t * acquire_mutex(MVMThreadContext *tc, MVMOSHandle *handle) {
+    uv_mutex_t *mutex = handle->body.mutex;
+    uv_mutex_lock(mutex);
+    MVM_tc_set_ex_release_mutex(tc, mutex);
+    return mutex;
+}
+
+static void release_mutex(MVMThreadContext *tc, uv_mutex_t *mutex) {
+    uv_mutex_unlock(mutex);
+    MVM_tc_clear_ex_release_mutex(tc);
+}
+
+/* Gets the descriptors for a copy from src to dest, along with any bytes the
+ * source already buffered. Each handle is locked only while we talk to it;
+ * the destination goes first, as it hands nothing back that could leak. */
+static void start_copy(MVMThreadContext *tc, MVMOSHandle *src, MVMOSHandle *dest,
+                       MVMint64 bytes, MVMint64 *in_fd, MVMint64 *out_fd,
+                       char **buffered, MVMint64 *num_buffered) {
+    uv_mutex_t *mutex;
+    char       *dest_buffered;
+    MVMint64    dest_num_buffered;
+
+    mutex   = acquire_mutex(tc, dest);
+    *out_fd = dest->body.ops->copyable->start_copy(tc, dest, &dest_buffered, &dest_num_buffered, 0);
+    release_mutex(tc, mutex);
+
+    mutex   = acquire_mutex(tc, src);
+    *in_fd  = src->body.ops->copyable->start_copy(tc, src, buffered, num_buffered, bytes);
+    release_mutex(tc, mutex);
+
+    if (*in_fd < 0 || *out_fd < 0) {
+        MVM_free(*buffered);
+        MVM_exception_throw_adhoc(tc, "Cannot copy between closed handles");
+    }
+}
+
+/* Lets both handles know how much was moved through their descriptors. */
+static void end_copy(MVMThreadContext *tc, MVMOSHandle *src, MVMOSHandle *dest,
+                     MVMint64 bytes_read, MVMint64 bytes_written) {
+    uv_mutex_t *mutex;
+    mutex = acquire_mutex(tc, src);
+    src->body.ops->copyable->end_copy(tc, src, bytes_read, 0);
+    release_mutex(tc, mutex);
+    mutex = acquire_mutex(tc, dest);
+    dest->body.ops->copyable->end_copy(tc, dest, 0, bytes_written);
+    release_mutex(tc, mutex);
+}
+
+#ifndef _WIN32
+/* Writes all of the bytes in the buffer to a descriptor. Returns 0 on
+ * success and -1 on failure, with errno set. */
+static int write_all(int fd, const char *buf, MVMint64 bytes) {
+    while (bytes > 0) {
+        ssize_t r = write(fd, buf, bytes);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf   += r;
+        bytes -= r;
+    }
+    return 0;
+}
+
+/* Picks the cheapest way to move data between two descriptors. */
+static int pick_copy_method(int in_fd, int out_fd) {
+#ifdef __linux__
+    struct stat in_stat, out_stat;
+    if (fstat(in_fd, &in_stat) < 0 || fstat(out_fd, &out_stat) < 0)
+        return COPY_READ_WRITE;
+#ifdef __NR_copy_file_range
+    if (S_ISREG(in_stat.st_mode) && S_ISREG(out_stat.st_mode))
+        return COPY_FILE_RANGE;
+#endif
+    if (S_ISFIFO(in_stat.st_mode) || S_ISFIFO(out_stat.st_mode))
+        return COPY_SPLICE;
+    if (S_ISREG(in_stat.st_mode) || S_ISBLK(in_stat.st_mode))
+        return COPY_SENDFILE;
+#endif
+    return COPY_READ_WRITE;
+}
+
+/* Copies up to the specified number of bytes (or until end of file, if it is
+ * negative) between two descriptors, starting at their current positions.
+ * Returns the number of bytes copied; if an error occurs, *error is set to
+ * the errno value. Touches no VM data, so may be called while the thread is
+ * marked blocked. */
+static MVMint64 copy_descriptors(int in_fd, int out_fd, MVMint64 bytes, int *error) {
+    MVMint64  copied = 0;
+    char     *buffer = NULL;
+    int       method = pick_copy_method(in_fd, out_fd);
+    *error = 0;
+    while (bytes < 0 || copied < bytes) {
+        size_t  want = bytes < 0 || bytes - copied > COPY_CHUNK_SIZE
+            ? COPY_CHUNK_SIZE
+            : (size_t)(bytes - copied);
+        ssize_t r;
+        switch (method) {
+#ifdef __linux__
+#ifdef __NR_copy_file_range
+            case COPY_FILE_RANGE:
+                r = syscall(__NR_copy_file_range, in_fd, NULL, out_fd, NULL, want, 0);
+                if (r < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL
+                        || errno == EBADF || errno == EOPNOTSUPP)) {
+                    /* Old kernel, files on different file systems, a file
+                     * system that can't, or a destination opened to append. */
+                    method = COPY_SENDFILE;
+                    continue;
+                }
+                break;
+#endif
+            case COPY_SPLICE:
+                r = splice(in_fd, NULL, out_fd, NULL, want, SPLICE_F_MOVE | SPLICE_F_MORE);
+                if (r < 0 && errno == EINVAL) {
+                    method = COPY_READ_WRITE;
+                    continue;
+                }
+                break;
+            case COPY_SENDFILE:
+                r = sendfile(out_fd, in_fd, NULL, want);
+                if (r < 0 && (errno == EINVAL || errno == ENOSYS
+                        || errno == EBADF || errno == EOPNOTSUPP)) {
+                    method = COPY_READ_WRITE;
+                    continue;
+                }
+                break;
+#endif
+            default:
+                if (!buffer)
+                    buffer = MVM_malloc(COPY_BUFFER_SIZE);
+                r = read(in_fd, buffer, want > COPY_BUFFER_SIZE ? COPY_BUFFER_SIZE : want);
+                if (r > 0 && write_all(out_fd, buffer, r) < 0)
+                    r = -1;
+                break;
+        }
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            *error = errno;
+            break;
+        }
+        if (r == 0)
+            break;
+        copied += r;
+    }
+    MVM_free(buffer);
+    return copied;
+}
+
+/* Does a copy between two handles that both have native descriptors. */
+static MVMint64 copy_natively(MVMThreadContext *tc, MVMOSHandle *src, MVMOSHandle *dest,
+                              MVMint64 bytes) {
+    MVMint64  in_fd, out_fd, num_buffered;
+    MVMint64  copied  = 0;
+    MVMint64  written = 0;
+    char     *buffered;
+    int       error   = 0;
+
+    start_copy(tc, src, dest, bytes, &in_fd, &out_fd, &buffered, &num_buffered);
+
+    MVM_gc_mark_thread_blocked(tc);
+    if (num_buffered) {
+        if (write_all((int)out_fd, buffered, num_buffered) < 0)
+            error = errno;
+        else
+            written = num_buffered;
+        MVM_free(buffered);
+    }
+    if (!error && (bytes < 0 || num_buffered < bytes)) {
+        copied   = copy_descriptors((int)in_fd, (int)out_fd,
+            bytes < 0 ? -1 : bytes - num_buffered, &error);
+        written += copied;
+    }
+    MVM_gc_mark_thread_unblocked(tc);
+
+    end_copy(tc, src, dest, copied, written);
+    if (error)
+        MVM_exception_throw_adhoc(tc, "Failed to copy between handles: %s", strerror(error));
+    return written;
+}
+#endif
+
+/* Copies through the handles' own read and write operations, for handles
+ * that have no descriptor to copy with. */
+static MVMint64 copy_through_handles(MVMThreadContext *tc, MVMOSHandle *src, MVMOSHandle *dest,
+                                     MVMint64 bytes) {
+    MVMint64 copied = 0;
+    if (!src->body.ops->sync_readable)
+        MVM_exception_throw_adhoc(tc, "Cannot copy from this kind of handle");
+    if (!dest->body.ops->sync_writable)
+        MVM_exception_throw_adhoc(tc, "Cannot copy to this kind of handle");
+    while (bytes < 0 || copied < bytes) {
+        uv_mutex_t *mutex;
+        char       *buf;
+        MVMint64    want = bytes < 0 || bytes - copied > COPY_BUFFER_SIZE
+            ? COPY_BUFFER_SIZE
+            : bytes - copied;
+        MVMint64    got;
+
+        mutex = acquire_mutex(tc, src);
+        got   = src->body.ops->sync_readable->read_bytes(tc, src, &buf, want);
+        release_mutex(tc, mutex);
+        if (got <= 0) {
+            MVM_free(buf);
+            break;
+        }
+
+        mutex = acquire_mutex(tc, dest);
+        dest->body.ops->sync_writable->write_bytes(tc, dest, buf, got);
+        release_mutex(tc, mutex);
+        MVM_free(buf);
+        copied += got;
+    }
+    return copied;
+}
+
+/* Copies up to the specified number of bytes from one handle to another, or
+ * until the end of the source if bytes is negative. Returns the number of
+ * bytes copied. */
+MVMint64 MVM_io_copy(MVMThreadContext *tc, MVMObject *src_obj, MVMObject *dest_obj, MVMint64 bytes) {
+    MVMOSHandle *src  = verify_is_handle(tc, src_obj, "copy from handle");
+    MVMOSHandle *dest = verify_is_handle(tc, dest_obj, "copy to handle");
+#ifndef _WIN32
+    if (src->body.ops->copyable && dest->body.ops->copyable)
+        return copy_natively(tc, src, dest, bytes);
+#endif
+    return copy_through_handles(tc, src, dest, bytes);
+}
+
+/* Info we convey about an asynchronous copy. The source must be a file, so
+ * that we can copy from an explicit offset without the file position being
+ * shared with the thread that made the request. */
+typedef struct {
+    MVMObject        *src;
+    MVMObject        *dest;
+    uv_fs_t           req;
+    uv_file           in_fd;
+    uv_file           out_fd;
+    char             *buffered;
+    MVMint64          num_buffered;
+    MVMint64          offset;
+    MVMint64          remaining;
+    MVMint64          copied;
+    MVMint64          copied_from_fd;
+    MVMThreadContext *tc;
+    int               work_idx;
+} CopyInfo;
+
+static void copy_step(MVMThreadContext *tc, uv_loop_t *loop, CopyInfo *ci);
+
+/* Sends the outcome of an asynchronous copy to the queue. */
+static void copy_done(MVMThreadContext *tc, CopyInfo *ci, int status) {
+    MVMObject    *arr = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTArray);
+    MVMAsyncTask *t   = (MVMAsyncTask *)MVM_repr_at_pos_o(tc,
+        tc->instance->event_loop_active, ci->work_idx);
+
+    /* Leave the source positioned after what we copied, and let both
+     * handles know what was moved, as a synchronous copy does. */
+    MVM_platform_lseek(ci->in_fd, ci->offset, SEEK_SET);
+    end_copy(tc, (MVMOSHandle *)ci->src, (MVMOSHandle *)ci->dest, ci->copied_from_fd, ci->copied);
+
+    MVM_repr_push_o(tc, arr, t->body.schedulee);
+    if (status >= 0) {
+        MVMROOT(tc, arr, {
+        MVMROOT(tc, t, {
+            MVMObject *bytes_box = MVM_repr_box_int(tc,
+                tc->instance->boot_types.BOOTInt, ci->copied);
+            MVM_repr_push_o(tc, arr, bytes_box);
+        });
+        });
+        MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTStr);
+    }
+    else {
+        MVM_repr_push_o(tc, arr, tc->instance->boot_types.BOOTInt);
+        MVMROOT(tc, arr, {
+        MVMROOT(tc, t, {
+            MVMString *msg_str = MVM_string_ascii_decode_nt(tc,
+                tc->instance->VMString, uv_strerror(status));
+            MVMObject *msg_box = MVM_repr_box_str(tc,
+                tc->instance->boot_types.BOOTStr, msg_str);
+            MVM_repr_push_o(tc, arr, msg_box);
+        });
+        });
+    }
+    MVM_repr_push_o(tc, t->body.queue, arr);
+}
+
+/* Completion handler for each step of an asynchronous copy. */
+static void on_copied(uv_fs_t *req) {
+    CopyInfo         *ci     = (CopyInfo *)req->data;
+    MVMThreadContext *tc     = ci->tc;
+    ssize_t           result = req->result;
+    uv_fs_req_cleanup(req);
+    if (result < 0) {
+        copy_done(tc, ci, (int)result);
+        return;
+    }
+    if (ci->buffered) {
+        /* Wrote out (some of) the bytes the source had already buffered. */
+        ci->copied       += result;
+        ci->num_buffered -= result;
+        if (ci->num_buffered > 0) {
+            memmove(ci->buffered, ci->buffered + result, ci->num_buffered);
+        }
+        else {
+            MVM_free(ci->buffered);
+            ci->buffered = NULL;
+        }
+    }
+    else if (result == 0) {
+        /* Reached end of file. */
+        copy_done(tc, ci, 0);
+        return;
+    }
+    else {
+        ci->offset         += result;
+        ci->copied         += result;
+        ci->copied_from_fd += result;
+        if (ci->remaining > 0)
+            ci->remaining -= result;
+    }
+    if (!ci->buffered && ci->remaining == 0)
+        copy_done(tc, ci, 0);
+    else
+        copy_step(tc, req->loop, ci);
+}
+
+/* Issues the next request of an asynchronous copy. */
+static void copy_step(MVMThreadContext *tc, uv_loop_t *loop, CopyInfo *ci) {
+    int r;
+    ci->req.data = ci;
+    if (ci->buffered) {
+        uv_buf_t buf = uv_buf_init(ci->buffered, (unsigned int)ci->num_buffered);
+        r = uv_fs_write(loop, &ci->req, ci->out_fd, &buf, 1, -1, on_copied);
+    }
+    else {
+        size_t want = ci->remaining < 0 || ci->remaining > COPY_CHUNK_SIZE
+            ? COPY_CHUNK_SIZE
+            : (size_t)ci->remaining;
+        r = uv_fs_sendfile(loop, &ci->req, ci->out_fd, ci->in_fd, ci->offset, want, on_copied);
+    }
+    if (r < 0)
+        copy_done(tc, ci, r);
+}
+
+/* Does setup work for an asynchronous copy. */
+static void copy_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_task, void *data) {
+    CopyInfo *ci = (CopyInfo *)data;
+    ci->tc       = tc;
+    ci->work_idx = MVM_repr_elems(tc, tc->instance->event_loop_active);
+    MVM_repr_push_o(tc, tc->instance->event_loop_active, async_task);
+    if (!ci->buffered && ci->remaining == 0)
+        copy_done(tc, ci, 0);
+    else
+        copy_step(tc, loop, ci);
+}
+
+/* Cancels an asynchronous copy, if its current request didn't start yet. */
+static void copy_cancel(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_task, void *data) {
+    CopyInfo *ci = (CopyInfo *)data;
+    uv_cancel((uv_req_t *)&ci->req);
+}
+
+/* Marks objects for an asynchronous copy task. */
+static void copy_gc_mark(MVMThreadContext *tc, void *data, MVMGCWorklist *worklist) {
+    CopyInfo *ci = (CopyInfo *)data;
+    MVM_gc_worklist_add(tc, worklist, &ci->src);
+    MVM_gc_worklist_add(tc, worklist, &ci->dest);
+}
+
+/* Frees info for an asynchronous copy task. */
+static void copy_gc_free(MVMThreadContext *tc, MVMObject *t, void *data) {
+    if (data) {
+        CopyInfo *ci = (CopyInfo *)data;
+        MVM_free(ci->buffered);
+        MVM_free(data);
+    }
+}
+
+/* Operations table for async copy task. */
+static const MVMAsyncTaskOps copy_op_table = {
+    copy_setup,
+    copy_cancel,
+    copy_gc_mark,
+    copy_gc_free
+};
+
+/* Copies from a file handle to another handle on the event loop, sending
+ * the number of bytes copied to the queue when done. */
+MVMObject * MVM_io_copy_async(MVMThreadContext *tc, MVMObject *src_obj, MVMObject *dest_obj,
+                              MVMObject *queue, MVMObject *schedulee, MVMint64 bytes,
+                              MVMObject *async_type) {
+    MVMOSHandle  *src  = verify_is_handle(tc, src_obj, "copy asynchronously from handle");
+    MVMOSHandle  *dest = verify_is_handle(tc, dest_obj, "copy asynchronously to handle");
+    MVMAsyncTask *task;
+    CopyInfo     *ci;
+    MVMint64      in_fd, out_fd, num_buffered, offset;
+    char         *buffered;
+
+    /* Validate REPRs. */
+    if (REPR(queue)->ID != MVM_REPR_ID_ConcBlockingQueue)
+        MVM_exception_throw_adhoc(tc,
+            "asynccopy target queue must have ConcBlockingQueue REPR");
+    if (REPR(async_type)->ID != MVM_REPR_ID_MVMAsyncTask)
+        MVM_exception_throw_adhoc(tc,
+            "asynccopy result type must have REPR AsyncTask");
+    if (!src->body.ops->copyable || !dest->body.ops->copyable)
+        MVM_exception_throw_adhoc(tc, "Cannot copy asynchronously between these kinds of handle");
+
+    /* Get the descriptors, and the offset to copy from. */
+    start_copy(tc, src, dest, bytes, &in_fd, &out_fd, &buffered, &num_buffered);
+    if (uv_guess_handle((uv_file)in_fd) != UV_FILE ||
+            (offset = MVM_platform_lseek((int)in_fd, 0, SEEK_CUR)) == -1) {
+        MVM_free(buffered);
+        MVM_exception_throw_adhoc(tc, "asynccopy can only copy from a file");
+    }
+
+    /* Create async task handle. */
+    MVMROOT(tc, queue, {
+    MVMROOT(tc, schedulee, {
+    MVMROOT(tc, src, {
+    MVMROOT(tc, dest, {
+        task = (MVMAsyncTask *)MVM_repr_alloc_init(tc, async_type);
+    });
+    });
+    });
+    });
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.queue, queue);
+    MVM_ASSIGN_REF(tc, &(task->common.header), task->body.schedulee, schedulee);
+    task->body.ops   = &copy_op_table;
+    ci               = MVM_calloc(1, sizeof(CopyInfo));
+    ci->in_fd        = (uv_file)in_fd;
+    ci->out_fd       = (uv_file)out_fd;
+    ci->buffered     = buffered;
+    ci->num_buffered = num_buffered;
+    ci->offset       = offset;
+    ci->remaining    = bytes < 0 ? -1 : bytes - num_buffered;
+    MVM_ASSIGN_REF(tc, &(task->common.header), ci->src, (MVMObject *)src);
+    MVM_ASSIGN_REF(tc, &(task->common.header), ci->dest, (MVMObject *)dest);
+    task->body.data  = ci;
+
+    /* Hand the task off to the event loop. */
+    MVM_io_eventloop_queue_work(tc, (MVMObject *)task);
+
+    return (MVMObject *)task;
+}
@@ -0,0 +1,3 @@
+MVMint64 MVM_io_copy(MVMThreadContext *tc, MVMObject *src, MVMObject *dest, MVMint64 bytes);
+MVMObject * MVM_io_copy_async(MVMThreadContext *tc, MVMObject *src, MVMObject *dest,
+    MVMObject *queue, MVMObject *schedulee, MVMint64 bytes, MVMObject *async_type);
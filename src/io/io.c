@@ -427,3 +427,25 @@ MVMObject * MVM_io_accept(MVMThreadContext *tc, MVMObject *oshandle) {
     else
         MVM_exception_throw_adhoc(tc, "Cannot accept this kind of handle");
 }
+
+void MVM_io_set_timeouts(MVMThreadContext *tc, MVMObject *oshandle, MVMint64 read_ms, MVMint64 write_ms) {
+    MVMOSHandle *handle = verify_is_handle(tc, oshandle, "set timeouts");
+    if (handle->body.ops->sockety && handle->body.ops->sockety->set_timeouts) {
+        uv_mutex_t *mutex = acquire_mutex(tc, handle);
+        handle->body.ops->sockety->set_timeouts(tc, handle, read_ms, write_ms);
+        release_mutex(tc, mutex);
+    }
+    else
+        MVM_exception_throw_adhoc(tc, "Cannot set timeouts on this kind of handle");
+}
+
+void MVM_io_set_read_ahead(MVMThreadContext *tc, MVMObject *oshandle, MVMint64 chunk_size, MVMint64 max_in_flight) {
+    MVMOSHandle *handle = verify_is_handle(tc, oshandle, "set read-ahead");
+    if (handle->body.ops->async_readable && handle->body.ops->async_readable->set_read_ahead) {
+        uv_mutex_t *mutex = acquire_mutex(tc, handle);
+        handle->body.ops->async_readable->set_read_ahead(tc, handle, chunk_size, max_in_flight);
+        release_mutex(tc, mutex);
+    }
+    else
+        MVM_exception_throw_adhoc(tc, "Cannot set read-ahead on this kind of handle");
+}
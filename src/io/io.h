@@ -14,6 +14,7 @@ struct MVMIOOps {
     const MVMIOPipeable        *pipeable;
     const MVMIOLockable        *lockable;
     const MVMIOIntrospection   *introspection;
+    const MVMIOCopyable        *copyable;
 
     /* How to mark the handle's data, if needed. */
     void (*gc_mark) (MVMThreadContext *tc, void *data, MVMGCWorklist *worklist);
@@ -56,6 +57,8 @@ struct MVMIOAsyncReadable {
         MVMObject *schedulee, MVMObject *async_type);
     MVMAsyncTask * (*read_bytes) (MVMThreadContext *tc, MVMOSHandle *h, MVMObject *queue,
         MVMObject *schedulee, MVMObject *buf_type, MVMObject *async_type);
+    void (*set_read_ahead) (MVMThreadContext *tc, MVMOSHandle *h, MVMint64 chunk_size,
+        MVMint64 max_in_flight);
 };
 
 /* I/O operations on handles that can do asynchronous writing. */
@@ -81,11 +84,13 @@ struct MVMIOSeekable {
     MVMint64 (*tell) (MVMThreadContext *tc, MVMOSHandle *h);
 };
 
-/* I/O operations on handles that do socket-y things (connect, bind, accept). */
+/* I/O operations on handles that do socket-y things (connect, bind, accept,
+ * and setting read/write timeouts in milliseconds). */
 struct MVMIOSockety {
     void (*connect) (MVMThreadContext *tc, MVMOSHandle *h, MVMString *host, MVMint64 port);
     void (*bind) (MVMThreadContext *tc, MVMOSHandle *h, MVMString *host, MVMint64 port, MVMint32 backlog);
     MVMObject * (*accept) (MVMThreadContext *tc, MVMOSHandle *h);
+    void (*set_timeouts) (MVMThreadContext *tc, MVMOSHandle *h, MVMint64 read_ms, MVMint64 write_ms);
 };
 
 /* I/O operations on handles that can lock/unlock. */
@@ -100,6 +105,22 @@ struct MVMIOIntrospection {
     MVMint64 (*native_descriptor) (MVMThreadContext *tc, MVMOSHandle *h);
 };
 
+/* I/O operations on handles that can have data copied to or from them at the
+ * level of native descriptors, bypassing the VM (see copy.c). */
+struct MVMIOCopyable {
+    /* Gets the native descriptor to copy with. Any bytes that were read
+     * ahead into the handle's buffer but not yet consumed are handed back
+     * in buf (up to limit of them, or all if limit is negative), so they can
+     * be written out before copying from the descriptor. */
+    MVMint64 (*start_copy) (MVMThreadContext *tc, MVMOSHandle *h, char **buf,
+        MVMint64 *buffered, MVMint64 limit);
+
+    /* Called after bytes were read from or written to the descriptor
+     * directly, so the handle can bring its own position up to date. */
+    void (*end_copy) (MVMThreadContext *tc, MVMOSHandle *h, MVMint64 bytes_read,
+        MVMint64 bytes_written);
+};
+
 /* Operations aiding process spawning and I/O handling.  */
 struct MVMIOPipeable {
     void (*bind_stdio_handle) (MVMThreadContext *tc, MVMOSHandle *h, uv_stdio_container_t *stdio,
@@ -140,3 +161,5 @@ void MVM_io_truncate(MVMThreadContext *tc, MVMObject *oshandle, MVMint64 offset)
 void MVM_io_connect(MVMThreadContext *tc, MVMObject *oshandle, MVMString *host, MVMint64 port);
 void MVM_io_bind(MVMThreadContext *tc, MVMObject *oshandle, MVMString *host, MVMint64 port, MVMint32 backlog);
 MVMObject * MVM_io_accept(MVMThreadContext *tc, MVMObject *oshandle);
+void MVM_io_set_timeouts(MVMThreadContext *tc, MVMObject *oshandle, MVMint64 read_ms, MVMint64 write_ms);
+void MVM_io_set_read_ahead(MVMThreadContext *tc, MVMObject *oshandle, MVMint64 chunk_size, MVMint64 max_in_flight);
@@ -17,6 +17,8 @@ extern char **environ;
 #  endif
 #else
 #  include <process.h>
+#  include <io.h>
+#  include <fcntl.h>
 #endif
 
 #ifdef _WIN32
@@ -317,6 +319,10 @@ typedef struct {
 
     /* The exit signal to send, if any. */
     MVMint64 signal;
+
+    /* If the process' stdout goes to a pipe that another process may read
+     * from directly, our descriptor for the read end of it; -1 otherwise. */
+    int stdout_fd;
 } MVMIOAsyncProcessData;
 
 typedef enum {
@@ -341,8 +347,49 @@ typedef struct {
     MVMuint32          seq_stderr;
     uv_stream_t       *stdin_handle;
     ProcessState      state;
+    int                stdin_fd;
+    int                stdout_fd;
+    int                stderr_fd;
+    MVMObject         *stdin_source;
 } SpawnInfo;
 
+/* Closes a native descriptor used to connect a child's stdio directly. */
+static void close_descriptor(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+/* Takes a copy of a descriptor to connect a child's stdio to, which is not
+ * inherited by children by default, or returns -1 on failure. */
+static int dup_descriptor(int fd) {
+#ifdef _WIN32
+    return _dup(fd);
+#else
+    int copy = dup(fd);
+    if (copy >= 0)
+        fcntl(copy, F_SETFD, FD_CLOEXEC);
+    return copy;
+#endif
+}
+
+/* Creates a pipe for connecting a child's stdout straight to another child's
+ * stdin. Neither end is inherited by children by default; libuv duplicates
+ * the end a child should have into place when spawning it. */
+static int make_pipe(int fds[2]) {
+#ifdef _WIN32
+    return _pipe(fds, 65536, _O_BINARY | _O_NOINHERIT);
+#else
+    if (pipe(fds) != 0)
+        return -1;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
+
 /* Info we convey about a write task. */
 typedef struct {
     MVMOSHandle      *handle;
@@ -557,6 +604,28 @@ static void proc_async_gc_mark(MVMThreadContext *tc, void *data, MVMGCWorklist *
         MVM_gc_worklist_add(tc, worklist, &(apd->async_task));
 }
 
+/* Frees an async process handle's data, closing the read end of its stdout
+ * pipe if no other process took it. */
+static void proc_async_gc_free(MVMThreadContext *tc, MVMObject *h, void *data) {
+    MVMIOAsyncProcessData *apd = (MVMIOAsyncProcessData *)data;
+    if (apd) {
+        if (apd->stdout_fd >= 0)
+            close_descriptor(apd->stdout_fd);
+        MVM_free(apd);
+    }
+}
+
+/* The native descriptor of an async process handle is the read end of its
+ * stdout pipe, which is what lets another process be spawned to read from
+ * it directly. */
+static MVMint64 proc_is_tty(MVMThreadContext *tc, MVMOSHandle *h) {
+    return 0;
+}
+static MVMint64 proc_native_descriptor(MVMThreadContext *tc, MVMOSHandle *h) {
+    MVMIOAsyncProcessData *apd = (MVMIOAsyncProcessData *)h->body.data;
+    return apd->stdout_fd;
+}
+
 /* Does an asynchronous close (since it must run on the event loop). */
 static void close_cb(uv_handle_t *handle) {
     MVM_free(handle);
@@ -634,6 +703,7 @@ static void deferred_close_perform(MVMThreadContext *tc, uv_loop_t *loop, MVMObj
 /* IO ops table, for async process, populated with functions. */
 static const MVMIOAsyncWritable proc_async_writable = { write_str, write_bytes };
 static const MVMIOClosable      closable            = { close_stdin };
+static const MVMIOIntrospection introspection       = { proc_is_tty, proc_native_descriptor };
 static const MVMIOOps proc_op_table = {
     &closable,
     NULL,
@@ -646,9 +716,10 @@ static const MVMIOOps proc_op_table = {
     NULL,
     NULL,
     NULL,
+    &introspection,
     NULL,
     proc_async_gc_mark,
-    NULL
+    proc_async_gc_free
 };
 
 static void spawn_async_close(uv_handle_t *handle) {
@@ -820,8 +891,14 @@ static void spawn_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_
     si->work_idx  = MVM_repr_elems(tc, tc->instance->event_loop_active);
     MVM_repr_push_o(tc, tc->instance->event_loop_active, async_task);
 
-    /* Create input/output handles as needed. */
-    if (MVM_repr_exists_key(tc, si->callbacks, tc->instance->str_consts.write)) {
+    /* Create input/output handles as needed. Descriptors we were asked to
+     * connect directly are inherited by the child, and the data never passes
+     * through the VM. */
+    if (si->stdin_fd >= 0) {
+        process_stdio[0].flags   = UV_INHERIT_FD;
+        process_stdio[0].data.fd = si->stdin_fd;
+    }
+    else if (MVM_repr_exists_key(tc, si->callbacks, tc->instance->str_consts.write)) {
         uv_pipe_t *pipe = MVM_malloc(sizeof(uv_pipe_t));
         uv_pipe_init(tc->loop, pipe, 0);
         pipe->data = si;
@@ -833,7 +910,11 @@ static void spawn_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_
         process_stdio[0].flags   = UV_INHERIT_FD;
         process_stdio[0].data.fd = 0;
     }
-    if (MVM_repr_exists_key(tc, si->callbacks, tc->instance->str_consts.stdout_chars)) {
+    if (si->stdout_fd >= 0) {
+        process_stdio[1].flags   = UV_INHERIT_FD;
+        process_stdio[1].data.fd = si->stdout_fd;
+    }
+    else if (MVM_repr_exists_key(tc, si->callbacks, tc->instance->str_consts.stdout_chars)) {
         uv_pipe_t *pipe = MVM_malloc(sizeof(uv_pipe_t));
         uv_pipe_init(tc->loop, pipe, 0);
         pipe->data = si;
@@ -856,7 +937,11 @@ static void spawn_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_
         process_stdio[1].flags   = UV_INHERIT_FD;
         process_stdio[1].data.fd = 1;
     }
-    if (MVM_repr_exists_key(tc, si->callbacks, tc->instance->str_consts.stderr_chars)) {
+    if (si->stderr_fd >= 0) {
+        process_stdio[2].flags   = UV_INHERIT_FD;
+        process_stdio[2].data.fd = si->stderr_fd;
+    }
+    else if (MVM_repr_exists_key(tc, si->callbacks, tc->instance->str_consts.stderr_chars)) {
         uv_pipe_t *pipe = MVM_malloc(sizeof(uv_pipe_t));
         uv_pipe_init(tc->loop, pipe, 0);
         pipe->data = si;
@@ -893,6 +978,22 @@ static void spawn_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_
     /* Attach data, spawn, report any error. */
     process->data = si;
     spawn_result  = uv_spawn(tc->loop, process, &process_options);
+
+    /* The child has its own copies of the descriptors we connected its stdio
+     * to now, so close ours. For the write end of its stdout pipe this also
+     * means whoever reads from it will see end of file. */
+    if (si->stdin_fd >= 0) {
+        close_descriptor(si->stdin_fd);
+        si->stdin_fd = -1;
+    }
+    if (si->stdout_fd >= 0) {
+        close_descriptor(si->stdout_fd);
+        si->stdout_fd = -1;
+    }
+    if (si->stderr_fd >= 0) {
+        close_descriptor(si->stderr_fd);
+        si->stderr_fd = -1;
+    }
     if (spawn_result) {
         MVMObject *error_cb = MVM_repr_at_key_o(tc, si->callbacks,
             tc->instance->str_consts.error);
@@ -924,6 +1025,20 @@ static void spawn_setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_
             tc->instance->str_consts.ready);
         si->state = STATE_STARTED;
 
+        /* If we're reading from another process' stdout pipe, the child now
+         * holds the read end; release it, so that the writer gets SIGPIPE
+         * rather than blocking forever should our child go away. */
+        if (si->stdin_source) {
+            MVMOSHandle           *source     = (MVMOSHandle *)si->stdin_source;
+            MVMIOAsyncProcessData *source_apd = (MVMIOAsyncProcessData *)source->body.data;
+            uv_mutex_lock(source->body.mutex);
+            if (source_apd->stdout_fd >= 0) {
+                close_descriptor(source_apd->stdout_fd);
+                source_apd->stdout_fd = -1;
+            }
+            uv_mutex_unlock(source->body.mutex);
+        }
+
         if (!MVM_is_null(tc, ready_cb)) {
             MVMROOT(tc, ready_cb, {
             MVMROOT(tc, async_task, {
@@ -967,6 +1082,7 @@ static void spawn_gc_mark(MVMThreadContext *tc, void *data, MVMGCWorklist *workl
     SpawnInfo *si = (SpawnInfo *)data;
     MVM_gc_worklist_add(tc, worklist, &si->handle);
     MVM_gc_worklist_add(tc, worklist, &si->callbacks);
+    MVM_gc_worklist_add(tc, worklist, &si->stdin_source);
 }
 
 /* Frees info for a spawn task. */
@@ -998,6 +1114,12 @@ static void spawn_gc_free(MVMThreadContext *tc, MVMObject *t, void *data) {
             MVM_string_decodestream_destory(tc, si->ds_stderr);
             si->ds_stderr = NULL;
         }
+        if (si->stdin_fd >= 0)
+            close_descriptor(si->stdin_fd);
+        if (si->stdout_fd >= 0)
+            close_descriptor(si->stdout_fd);
+        if (si->stderr_fd >= 0)
+            close_descriptor(si->stderr_fd);
         MVM_free(si);
     }
 }
@@ -1010,6 +1132,39 @@ static const MVMAsyncTaskOps spawn_op_table = {
     spawn_gc_free
 };
 
+/* Checks if a child's stdio should be connected directly to the native
+ * descriptor of a handle, and that it can be. */
+static MVMint32 connects_to_handle(MVMThreadContext *tc, MVMObject *callbacks, MVMString *key,
+                                   MVMString *conflict1, MVMString *conflict2, const char *what) {
+    if (!MVM_repr_exists_key(tc, callbacks, key))
+        return 0;
+    if (MVM_repr_exists_key(tc, callbacks, conflict1) || MVM_repr_exists_key(tc, callbacks, conflict2))
+        MVM_exception_throw_adhoc(tc,
+            "spawnprocasync cannot both connect %s to a handle and handle it in the VM", what);
+    if (MVM_io_fileno(tc, MVM_repr_at_key_o(tc, callbacks, key)) < 0)
+        MVM_exception_throw_adhoc(tc,
+            "spawnprocasync cannot connect %s to a handle without a native descriptor", what);
+    return 1;
+}
+
+/* Takes our own copy of the native descriptor of a handle that was checked
+ * by connects_to_handle, under the handle's mutex, so that the copy stays
+ * valid however the handle is used before the child is spawned. Returns -1
+ * if the handle no longer has a descriptor, or it could not be copied. */
+static int copy_descriptor_for(MVMThreadContext *tc, MVMObject *callbacks, MVMString *key) {
+    MVMOSHandle *handle = (MVMOSHandle *)MVM_repr_at_key_o(tc, callbacks, key);
+    uv_mutex_t  *mutex  = handle->body.mutex;
+    MVMint64     fd;
+    uv_mutex_lock(mutex);
+    MVM_tc_set_ex_release_mutex(tc, mutex);
+    fd = handle->body.ops->introspection->native_descriptor(tc, handle);
+    if (fd >= 0)
+        fd = dup_descriptor((int)fd);
+    uv_mutex_unlock(mutex);
+    MVM_tc_clear_ex_release_mutex(tc);
+    return (int)fd;
+}
+
 /* Spawn a process asynchronously. */
 MVMObject * MVM_proc_spawn_async(MVMThreadContext *tc, MVMObject *queue, MVMObject *argv,
                                  MVMString *cwd, MVMObject *env, MVMObject *callbacks) {
@@ -1020,12 +1175,39 @@ MVMObject * MVM_proc_spawn_async(MVMThreadContext *tc, MVMObject *queue, MVMObje
     MVMuint64      size, arg_size, i;
     MVMIter       *iter;
     MVMRegister    reg;
+    MVMint32       stdin_from_process = 0;
+    MVMint32       stdin_connected, stdout_connected, stderr_connected;
+    MVMint32       want_stdout_pipe   = 0;
+    int            stdin_fd, stdout_fd, stderr_fd;
+    int            stdout_pipe[2] = { -1, -1 };
 
     /* Validate queue REPR. */
     if (REPR(queue)->ID != MVM_REPR_ID_ConcBlockingQueue)
         MVM_exception_throw_adhoc(tc,
             "spawnprocasync target queue must have ConcBlockingQueue REPR");
 
+    /* Work out any stdio that should be connected to handles at the level of
+     * native descriptors. The stdin may come from the stdout pipe of another
+     * process that was spawned earlier, which gives a pipeline. */
+    stdin_connected = connects_to_handle(tc, callbacks, tc->instance->str_consts.stdin_from,
+        tc->instance->str_consts.write, tc->instance->str_consts.write, "stdin");
+    if (stdin_connected) {
+        MVMObject *from = MVM_repr_at_key_o(tc, callbacks, tc->instance->str_consts.stdin_from);
+        stdin_from_process = ((MVMOSHandle *)from)->body.ops == &proc_op_table;
+    }
+    stdout_connected = connects_to_handle(tc, callbacks, tc->instance->str_consts.stdout_to,
+        tc->instance->str_consts.stdout_chars, tc->instance->str_consts.stdout_bytes, "stdout");
+    stderr_connected = connects_to_handle(tc, callbacks, tc->instance->str_consts.stderr_to,
+        tc->instance->str_consts.stderr_chars, tc->instance->str_consts.stderr_bytes, "stderr");
+    if (MVM_repr_exists_key(tc, callbacks, tc->instance->str_consts.stdout_pipe)) {
+        if (stdout_connected
+                || MVM_repr_exists_key(tc, callbacks, tc->instance->str_consts.stdout_chars)
+                || MVM_repr_exists_key(tc, callbacks, tc->instance->str_consts.stdout_bytes))
+            MVM_exception_throw_adhoc(tc,
+                "spawnprocasync cannot both pipe stdout and send it elsewhere");
+        want_stdout_pipe = 1;
+    }
+
     /* Encode arguments, taking first as program name. */
     arg_size = MVM_repr_elems(tc, argv);
     if (arg_size < 1)
@@ -1041,19 +1223,58 @@ MVMObject * MVM_proc_spawn_async(MVMThreadContext *tc, MVMObject *queue, MVMObje
     /* Encode CWD. */
     _cwd = MVM_string_utf8_c8_encode_C_string(tc, cwd);
 
+    /* Encode environment. */
     MVMROOT(tc, queue, {
     MVMROOT(tc, env, {
     MVMROOT(tc, callbacks, {
-        MVMIOAsyncProcessData *data;
-
-        /* Encode environment. */
         size = MVM_repr_elems(tc, env);
         iter = (MVMIter *)MVM_iter(tc, env);
         _env = MVM_malloc((size + 1) * sizeof(char *));
         INIT_ENV();
+    });
+    });
+    });
+
+    /* Only now that nothing else can fail do we take our own copies of the
+     * descriptors to connect to, and create the pipe, so no error path
+     * leaves descriptors open. The copies are closed once the child is
+     * spawned; owning them means it doesn't matter if the handles they came
+     * from are closed, or another spawn takes them, before that happens. */
+    stdin_fd  = stdin_connected
+        ? copy_descriptor_for(tc, callbacks, tc->instance->str_consts.stdin_from) : -1;
+    stdout_fd = stdout_connected
+        ? copy_descriptor_for(tc, callbacks, tc->instance->str_consts.stdout_to) : -1;
+    stderr_fd = stderr_connected
+        ? copy_descriptor_for(tc, callbacks, tc->instance->str_consts.stderr_to) : -1;
+    if (want_stdout_pipe && make_pipe(stdout_pipe) == 0)
+        stdout_fd = stdout_pipe[1];
+    if ((stdin_connected && stdin_fd < 0) || (stdout_connected && stdout_fd < 0)
+            || (stderr_connected && stderr_fd < 0) || (want_stdout_pipe && stdout_pipe[0] < 0)) {
+        int err = errno;
+        if (stdin_fd >= 0)
+            close_descriptor(stdin_fd);
+        if (stdout_fd >= 0)
+            close_descriptor(stdout_fd);
+        if (stderr_fd >= 0)
+            close_descriptor(stderr_fd);
+        if (stdout_pipe[0] >= 0)
+            close_descriptor(stdout_pipe[0]);
+        for (i = 0; i < arg_size; i++)
+            MVM_free(args[i]);
+        MVM_free(args);
+        MVM_free(_cwd);
+        FREE_ENV();
+        MVM_exception_throw_adhoc(tc,
+            "spawnprocasync failed to set up a descriptor for the child's stdio: %d", err);
+    }
+
+    MVMROOT(tc, queue, {
+    MVMROOT(tc, callbacks, {
+        MVMIOAsyncProcessData *data;
 
         /* Create handle. */
         data              = MVM_calloc(1, sizeof(MVMIOAsyncProcessData));
+        data->stdout_fd   = stdout_pipe[0];
         handle            = (MVMOSHandle *)MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTIO);
         handle->body.ops  = &proc_op_table;
         handle->body.data = data;
@@ -1063,20 +1284,25 @@ MVMObject * MVM_proc_spawn_async(MVMThreadContext *tc, MVMObject *queue, MVMObje
             task = (MVMAsyncTask *)MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTAsync);
         });
         MVM_ASSIGN_REF(tc, &(task->common.header), task->body.queue, queue);
-        task->body.ops  = &spawn_op_table;
-        si              = MVM_calloc(1, sizeof(SpawnInfo));
-        si->prog        = prog;
-        si->cwd         = _cwd;
-        si->env         = _env;
-        si->args        = args;
-        si->state       = STATE_UNSTARTED;
+        task->body.ops     = &spawn_op_table;
+        si                 = MVM_calloc(1, sizeof(SpawnInfo));
+        si->prog           = prog;
+        si->cwd            = _cwd;
+        si->env            = _env;
+        si->args           = args;
+        si->state          = STATE_UNSTARTED;
+        si->stdin_fd       = stdin_fd;
+        si->stdout_fd      = stdout_fd;
+        si->stderr_fd      = stderr_fd;
+        if (stdin_from_process)
+            MVM_ASSIGN_REF(tc, &(task->common.header), si->stdin_source,
+                MVM_repr_at_key_o(tc, callbacks, tc->instance->str_consts.stdin_from));
         MVM_ASSIGN_REF(tc, &(task->common.header), si->handle, handle);
         MVM_ASSIGN_REF(tc, &(task->common.header), si->callbacks, callbacks);
         task->body.data = si;
         MVM_ASSIGN_REF(tc, &(handle->common.header), data->async_task, task);
     });
     });
-    });
 
     /* Hand the task off to the event loop. */
     MVM_io_eventloop_queue_work(tc, (MVMObject *)task);
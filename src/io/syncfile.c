@@ -23,24 +23,6 @@
 /* Number of bytes we pull in at a time to the buffer. */
 #define CHUNK_SIZE 32768
 
-/* Data that we keep for a file-based handle. */
-typedef struct {
-    /* libuv file descriptor. */
-    uv_file fd;
-
-    /* The filename we opened, as a C string. */
-    char *filename;
-
-    /* The encoding we're using. */
-    MVMint64 encoding;
-
-    /* Decode stream, for turning bytes from disk into strings. */
-    MVMDecodeStream *ds;
-
-    /* Current separator specification for line-by-line reading. */
-    MVMDecodeStreamSeparators sep_spec;
-} MVMIOFileData;
-
 /* Closes the file. */
 static MVMint64 closefh(MVMThreadContext *tc, MVMOSHandle *h) {
     MVMIOFileData *data = (MVMIOFileData *)h->body.data;
@@ -387,6 +369,43 @@ static void unlock(MVMThreadContext *tc, MVMOSHandle *h) {
 #endif
 }
 
+/* Prepares to copy from or to the file descriptor directly, handing back any
+ * bytes we already read ahead. */
+static MVMint64 start_copy(MVMThreadContext *tc, MVMOSHandle *h, char **buf,
+                           MVMint64 *buffered, MVMint64 limit) {
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    *buf      = NULL;
+    *buffered = 0;
+    if (data->ds && limit != 0) {
+        MVMint64 available;
+        if (data->ds->chars_head)
+            MVM_exception_throw_adhoc(tc, "Cannot copy from a filehandle with decoded characters pending");
+        available = MVM_string_decodestream_bytes_available(tc, data->ds);
+        if (limit > 0 && available > limit)
+            available = limit;
+        if (available > 0)
+            *buffered = MVM_string_decodestream_bytes_to_buf(tc, data->ds, buf, available);
+    }
+    return (MVMint64)data->fd;
+}
+
+/* After reading from the descriptor directly, start decoding afresh from
+ * wherever it now is, as seek does. */
+static void end_copy(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 bytes_read,
+                     MVMint64 bytes_written) {
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    if (bytes_read && (!data->ds || MVM_string_decodestream_is_empty(tc, data->ds))) {
+        MVMint64 r;
+        if (data->ds) {
+            MVM_string_decodestream_destory(tc, data->ds);
+            data->ds = NULL;
+        }
+        if ((r = MVM_platform_lseek(data->fd, 0, SEEK_CUR)) == -1)
+            MVM_exception_throw_adhoc(tc, "Failed to seek in filehandle: %d", errno);
+        data->ds = MVM_string_decodestream_create(tc, data->encoding, r, 1);
+    }
+}
+
 /* Frees data associated with the handle. */
 static void gc_free(MVMThreadContext *tc, MVMObject *h, void *d) {
     MVMIOFileData *data = (MVMIOFileData *)d;
@@ -401,28 +420,35 @@ static void gc_free(MVMThreadContext *tc, MVMObject *h, void *d) {
 }
 
 /* IO ops table, populated with functions. */
-static const MVMIOClosable      closable      = { closefh };
-static const MVMIOEncodable     encodable     = { set_encoding };
-static const MVMIOSyncReadable  sync_readable = { set_separator, read_line, slurp, read_chars, read_bytes, mvm_eof };
-static const MVMIOSyncWritable  sync_writable = { write_str, write_bytes, flush, truncatefh };
-static const MVMIOSeekable      seekable      = { seek, mvm_tell };
-static const MVMIOPipeable      pipeable      = { bind_stdio_handle };
-static const MVMIOLockable      lockable      = { lock, unlock };
-static const MVMIOIntrospection introspection = { is_tty, mvm_fileno };
+static const MVMIOClosable      closable       = { closefh };
+static const MVMIOEncodable     encodable      = { set_encoding };
+static const MVMIOSyncReadable  sync_readable  = { set_separator, read_line, slurp, read_chars, read_bytes, mvm_eof };
+static const MVMIOSyncWritable  sync_writable  = { write_str, write_bytes, flush, truncatefh };
+static const MVMIOAsyncReadable async_readable = { MVM_io_file_read_chars_async,
+                                                   MVM_io_file_read_bytes_async,
+                                                   MVM_io_file_set_read_ahead };
+static const MVMIOAsyncWritable async_writable = { MVM_io_file_write_str_async,
+                                                   MVM_io_file_write_bytes_async };
+static const MVMIOSeekable      seekable       = { seek, mvm_tell };
+static const MVMIOPipeable      pipeable       = { bind_stdio_handle };
+static const MVMIOLockable      lockable       = { lock, unlock };
+static const MVMIOIntrospection introspection  = { is_tty, mvm_fileno };
+static const MVMIOCopyable      copyable       = { start_copy, end_copy };
 
 static const MVMIOOps op_table = {
     &closable,
     &encodable,
     &sync_readable,
     &sync_writable,
-    NULL,
-    NULL,
+    &async_readable,
+    &async_writable,
     NULL,
     &seekable,
     NULL,
     &pipeable,
     &lockable,
     &introspection,
+    &copyable,
     NULL,
     gc_free
 };
@@ -484,6 +510,7 @@ MVMObject * MVM_file_open_fh(MVMThreadContext *tc, MVMString *filename, MVMStrin
     /* Set up handle. */
     data->fd          = fd;
     data->filename    = fname;
+    data->append      = (flag & O_APPEND) != 0;
     data->encoding    = MVM_encoding_type_utf8;
     MVM_string_decode_stream_sep_default(tc, &(data->sep_spec));
     result->body.ops  = &op_table;
@@ -1,2 +1,31 @@
+/* Data that we keep for a file-based handle. */
+struct MVMIOFileData {
+    /* libuv file descriptor. */
+    uv_file fd;
+
+    /* The filename we opened, as a C string. */
+    char *filename;
+
+    /* The encoding we're using. */
+    MVMint64 encoding;
+
+    /* Decode stream, for turning bytes from disk into strings. */
+    MVMDecodeStream *ds;
+
+    /* Current separator specification for line-by-line reading. */
+    MVMDecodeStreamSeparators sep_spec;
+
+    /* Read-ahead for asynchronous reads: the size of each chunk we read, and
+     * how many chunks we may have in flight at once (see asyncfile.c). */
+    MVMint32 async_chunk_size;
+    MVMint32 async_max_in_flight;
+
+    /* Whether the file was opened for appending, and the asynchronous
+     * appends waiting their turn (see asyncfile.c). */
+    MVMint32  append;
+    void     *async_appends_head;
+    void     *async_appends_tail;
+};
+
 MVMObject * MVM_file_open_fh(MVMThreadContext *tc, MVMString *filename, MVMString *mode);
 MVMObject * MVM_file_handle_from_fd(MVMThreadContext *tc, uv_file fd);
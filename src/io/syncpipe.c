@@ -107,6 +107,7 @@ static const MVMIOOps op_table = {
     NULL,
     &introspection,
     NULL,
+    NULL,
     gc_free
 };
 
@@ -1,32 +1,117 @@
 #include "moar.h"
 
-#ifndef _WIN32
-    #include "unistd.h"
+/* Synchronous sockets are implemented directly on top of the BSD sockets
+ * API rather than by running a libuv event loop until an operation has
+ * completed. Sockets are left in blocking mode, so an operation with no
+ * timeout set is a single system call; when a read or write timeout has
+ * been set, we poll for readiness first so the wait can be bounded. */
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    typedef SOCKET Socket;
+    #define MVM_poll WSAPoll
+    #define MVM_SOCKET_INVALID INVALID_SOCKET
+    #define MVM_SOCKET_FAILED(r) ((r) == SOCKET_ERROR)
+    #define MVM_SEND_FLAGS 0
+#else
+    #include <unistd.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    typedef int Socket;
+    #define MVM_poll poll
+    #define closesocket close
+    #define MVM_SOCKET_INVALID -1
+    #define MVM_SOCKET_FAILED(r) ((r) < 0)
+    #ifdef MSG_NOSIGNAL
+        #define MVM_SEND_FLAGS MSG_NOSIGNAL
+    #else
+        #define MVM_SEND_FLAGS 0
+    #endif
 #endif
 
 #if defined(_MSC_VER)
 #define snprintf _snprintf
 #endif
 
+/* Number of bytes we pull in at a time to the buffer. */
+#define CHUNK_SIZE 65536
+
  /* Data that we keep for a socket-based handle. */
 typedef struct {
-    /* Start with same fields as a sync stream, since we will re-use most
-     * of its logic. */
-    MVMIOSyncStreamData ss;
+    /* The socket handle (file descriptor on POSIX). */
+    Socket handle;
+
+    /* Decode stream, for turning bytes into strings; also serves as the
+     * read buffer. */
+    MVMDecodeStream *ds;
+
+    /* The encoding we're using. */
+    MVMint64 encoding;
 
-    /* Details of next connection to accept; NULL if none. */
-    uv_stream_t *accept_server;
-    int          accept_status;
+    /* Current separator specification for line-by-line reading. */
+    MVMDecodeStreamSeparators sep_spec;
+
+    /* Did we reach EOF yet? */
+    MVMint32 eof;
+
+    /* Read and write timeouts, in milliseconds; 0 means wait forever. */
+    MVMint32 read_timeout;
+    MVMint32 write_timeout;
+
+    /* Total bytes we've written. */
+    MVMint64 total_bytes_written;
 } MVMIOSyncSocketData;
 
+/* Throws an exception describing the last socket error that occurred. */
+MVM_NO_RETURN static void throw_error(MVMThreadContext *tc, const char *operation) MVM_NO_RETURN_GCC;
+static void throw_error(MVMThreadContext *tc, const char *operation) {
+#ifdef _WIN32
+    MVM_exception_throw_adhoc(tc, "Failed to %s: error code %d", operation,
+        WSAGetLastError());
+#else
+    MVM_exception_throw_adhoc(tc, "Failed to %s: %s", operation, strerror(errno));
+#endif
+}
+
+/* Waits for the socket to become ready for the specified events (POLLIN or
+ * POLLOUT), for at most timeout milliseconds. Returns straight away when no
+ * timeout is set, since the following blocking call will do the waiting for
+ * us. Returns 0 if the socket is ready, MVM_SOCKET_TIMED_OUT if the timeout
+ * expired, and a negative value on error. */
+#define MVM_SOCKET_TIMED_OUT 1
+static int wait_ready(Socket s, short events, MVMint32 timeout) {
+    struct pollfd pfd;
+    int r;
+    if (timeout <= 0)
+        return 0;
+    pfd.fd      = s;
+    pfd.events  = events;
+    pfd.revents = 0;
+    do {
+        r = MVM_poll(&pfd, 1, timeout);
+#ifdef _WIN32
+    } while (0);
+#else
+    } while (r < 0 && errno == EINTR);
+#endif
+    if (r == 0)
+        return MVM_SOCKET_TIMED_OUT;
+    return MVM_SOCKET_FAILED(r) ? -1 : 0;
+}
+
 static MVMint64 do_close(MVMThreadContext *tc, MVMIOSyncSocketData *data) {
-    if (data->ss.handle) {
-         uv_close((uv_handle_t *)data->ss.handle, NULL);
-         data->ss.handle = NULL;
+    if (data->handle != MVM_SOCKET_INVALID) {
+        closesocket(data->handle);
+        data->handle = MVM_SOCKET_INVALID;
     }
-    if (data->ss.ds) {
-        MVM_string_decodestream_destory(tc, data->ss.ds);
-        data->ss.ds = NULL;
+    if (data->ds) {
+        MVM_string_decodestream_destory(tc, data->ds);
+        data->ds = NULL;
     }
     return 0;
 }
@@ -38,11 +123,242 @@ static MVMint64 close_socket(MVMThreadContext *tc, MVMOSHandle *h) {
 static void gc_free(MVMThreadContext *tc, MVMObject *h, void *d) {
     MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)d;
     do_close(tc, data);
+    MVM_string_decode_stream_sep_destroy(tc, &(data->sep_spec));
+    MVM_free(data);
+}
+
+/* Ensures the socket is open, throwing if it isn't. */
+static void ensure_open(MVMThreadContext *tc, MVMIOSyncSocketData *data, const char *operation) {
+    if (data->handle == MVM_SOCKET_INVALID)
+        MVM_exception_throw_adhoc(tc, "Cannot %s a socket that is not connected", operation);
+}
+
+/* Sets the encoding used for string-based I/O. */
+static void set_encoding(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 encoding) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    if (data->ds) {
+        if (data->ds->chars_head)
+            MVM_exception_throw_adhoc(tc, "Too late to change handle encoding");
+        data->ds->encoding = encoding;
+    }
+    data->encoding = encoding;
+}
+
+/* Set the line separator. */
+static void set_separator(MVMThreadContext *tc, MVMOSHandle *h, MVMString **seps, MVMint32 num_seps) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    MVM_string_decode_stream_sep_from_strings(tc, &(data->sep_spec), seps, num_seps);
+}
+
+/* Ensures we have a decode stream, creating it if we're missing one. */
+static void ensure_decode_stream(MVMThreadContext *tc, MVMIOSyncSocketData *data) {
+    if (!data->ds)
+        data->ds = MVM_string_decodestream_create(tc, data->encoding, 0, 0);
+}
+
+/* Does a single recv into the decode stream, waiting at most the read
+ * timeout for data to arrive. Returns true if we read some data, and false
+ * if we hit EOF. */
+static MVMint32 read_to_buffer(MVMThreadContext *tc, MVMIOSyncSocketData *data, MVMint64 bytes) {
+    char *buf;
+    int r;
+
+    /* Don't try and read again if we already saw EOF. */
+    if (data->eof)
+        return 0;
+    ensure_open(tc, data, "read from");
+
+    buf = MVM_malloc(bytes);
+    MVM_gc_mark_thread_blocked(tc);
+    r = wait_ready(data->handle, POLLIN, data->read_timeout);
+    if (r == 0) {
+        do {
+            r = recv(data->handle, buf, (int)bytes, 0);
+#ifdef _WIN32
+        } while (0);
+#else
+        } while (r < 0 && errno == EINTR);
+#endif
+    }
+    else if (r == MVM_SOCKET_TIMED_OUT) {
+        MVM_gc_mark_thread_unblocked(tc);
+        MVM_free(buf);
+        MVM_exception_throw_adhoc(tc, "Timed out while trying to read from socket");
+    }
+    MVM_gc_mark_thread_unblocked(tc);
+
+    if (MVM_SOCKET_FAILED(r)) {
+        MVM_free(buf);
+        throw_error(tc, "read from socket");
+    }
+    if (r == 0) {
+        MVM_free(buf);
+        data->eof = 1;
+        return 0;
+    }
+    MVM_string_decodestream_add_bytes(tc, data->ds, buf, r);
+    return 1;
+}
+
+/* Reads a single line from the socket. May serve it from a buffer, if we
+ * already read enough data. */
+static MVMString * read_line(MVMThreadContext *tc, MVMOSHandle *h, MVMint32 chomp) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    ensure_decode_stream(tc, data);
+
+    /* Pull data until we can read a line. */
+    do {
+        MVMString *line = MVM_string_decodestream_get_until_sep(tc,
+            data->ds, &(data->sep_spec), chomp);
+        if (line != NULL)
+            return line;
+    } while (read_to_buffer(tc, data, CHUNK_SIZE) > 0);
+
+    /* Reached end of stream, or last (non-termianted) line. */
+    return MVM_string_decodestream_get_until_sep_eof(tc, data->ds,
+        &(data->sep_spec), chomp);
+}
+
+/* Reads everything until the peer closes the connection into a string. */
+static MVMString * slurp(MVMThreadContext *tc, MVMOSHandle *h) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    ensure_decode_stream(tc, data);
+    while (read_to_buffer(tc, data, CHUNK_SIZE))
+        ;
+    return MVM_string_decodestream_get_all(tc, data->ds);
+}
+
+/* Gets the specified number of characters from the socket. */
+static MVMString * read_chars(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 chars) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    MVMString *result;
+    ensure_decode_stream(tc, data);
+
+    /* Do we already have the chars available? */
+    result = MVM_string_decodestream_get_chars(tc, data->ds, chars);
+    if (result) {
+        return result;
+    }
+    else {
+        /* No; read and try again. */
+        read_to_buffer(tc, data, CHUNK_SIZE);
+        result = MVM_string_decodestream_get_chars(tc, data->ds, chars);
+        if (result != NULL)
+            return result;
+    }
+
+    /* Fetched all we immediately can, so just take what we have. */
+    return MVM_string_decodestream_get_all(tc, data->ds);
+}
+
+/* Reads up to the specified number of bytes into a the supplied buffer,
+ * returing the number actually read. */
+static MVMint64 read_bytes(MVMThreadContext *tc, MVMOSHandle *h, char **buf, MVMint64 bytes) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    ensure_decode_stream(tc, data);
+
+    /* See if we've already enough; if not, try and grab more. */
+    if (!MVM_string_decodestream_have_bytes(tc, data->ds, bytes))
+        read_to_buffer(tc, data, bytes > CHUNK_SIZE ? bytes : CHUNK_SIZE);
+
+    /* Read as many as we can, up to the limit. */
+    return MVM_string_decodestream_bytes_to_buf(tc, data->ds, buf, bytes);
+}
+
+/* Checks if the end of stream has been reached. */
+static MVMint64 eof(MVMThreadContext *tc, MVMOSHandle *h) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    if (data->ds && !MVM_string_decodestream_is_empty(tc, data->ds))
+        return 0;
+    return data->eof;
+}
+
+/* Sends all of the specified bytes, looping over partial writes. If the
+ * send fails, the buffer is freed before throwing when free_on_error is set,
+ * so callers that own an encoded buffer don't leak it. */
+static void send_all(MVMThreadContext *tc, MVMIOSyncSocketData *data, char *buf, MVMint64 bytes,
+                     MVMint32 free_on_error) {
+    MVMint64 sent = 0;
+    if (data->handle == MVM_SOCKET_INVALID) {
+        if (free_on_error)
+            MVM_free(buf);
+        ensure_open(tc, data, "write to");
+    }
+    MVM_gc_mark_thread_blocked(tc);
+    while (sent < bytes) {
+        int r = wait_ready(data->handle, POLLOUT, data->write_timeout);
+        if (r == MVM_SOCKET_TIMED_OUT) {
+            MVM_gc_mark_thread_unblocked(tc);
+            if (free_on_error)
+                MVM_free(buf);
+            MVM_exception_throw_adhoc(tc, "Timed out while trying to write to socket");
+        }
+        if (r == 0)
+            r = send(data->handle, buf + sent, (int)(bytes - sent), MVM_SEND_FLAGS);
+        if (MVM_SOCKET_FAILED(r)) {
+#ifndef _WIN32
+            if (errno == EINTR)
+                continue;
+#endif
+            MVM_gc_mark_thread_unblocked(tc);
+            if (free_on_error)
+                MVM_free(buf);
+            throw_error(tc, "write to socket");
+        }
+        sent += r;
+    }
+    MVM_gc_mark_thread_unblocked(tc);
+    data->total_bytes_written += bytes;
+}
+
+/* Writes the specified string to the socket, maybe with a newline. */
+static MVMint64 write_str(MVMThreadContext *tc, MVMOSHandle *h, MVMString *str, MVMint64 newline) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    MVMuint64 output_size;
+    char *output = MVM_string_encode(tc, str, 0, -1, &output_size, data->encoding, NULL, 0);
+    if (newline) {
+        output = (char *)MVM_realloc(output, ++output_size);
+        output[output_size - 1] = '\n';
+    }
+    send_all(tc, data, output, output_size, 1);
+    MVM_free(output);
+    return output_size;
+}
+
+/* Writes the specified bytes to the socket. */
+static MVMint64 write_bytes(MVMThreadContext *tc, MVMOSHandle *h, char *buf, MVMint64 bytes) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    send_all(tc, data, buf, bytes, 0);
+    return bytes;
+}
+
+/* Data is sent as soon as we write it, so nothing to flush. */
+static void flush(MVMThreadContext *tc, MVMOSHandle *h) {
+}
+
+/* Cannot truncate a socket. */
+static void truncatefh(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 bytes) {
+    MVM_exception_throw_adhoc(tc, "Cannot truncate this kind of handle");
+}
+
+/* Cannot seek a socket. */
+static void seek(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 offset, MVMint64 whence) {
+    MVM_exception_throw_adhoc(tc, "Cannot seek this kind of handle");
+}
+
+/* If we've been reading, the total number of bytes read. Otherwise, the total
+ * number of bytes we've written. */
+static MVMint64 tell(MVMThreadContext *tc, MVMOSHandle *h) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    return data->ds
+        ? MVM_string_decodestream_tell_bytes(tc, data->ds)
+        : data->total_bytes_written;
 }
 
 /* Actually, it may return sockaddr_in6 as well; it's not a problem for us, because we just
- * pass is straight to uv, and the first thing it does is it looks at the address family,
- * but it's a thing to remember if someone feels like peeking inside the returned struct. */
+ * pass it straight on to connect/bind (see address_length) or to uv, which look at the
+ * address family first, but it's a thing to remember if someone feels like peeking inside
+ * the returned struct. */
 struct sockaddr * MVM_io_resolve_host_name(MVMThreadContext *tc, MVMString *host, MVMint64 port) {
     char *host_cstr = MVM_string_utf8_encode_C_string(tc, host);
     struct sockaddr *dest;
@@ -70,103 +386,197 @@ struct sockaddr * MVM_io_resolve_host_name(MVMThreadContext *tc, MVMString *host
     return dest;
 }
 
-static void on_connect(uv_connect_t* req, int status) {
-    uv_unref((uv_handle_t *)req->handle);
-    if (status < 0) {
-        MVMThreadContext *tc = ((MVMIOSyncSocketData *)req->data)->ss.cur_tc;
-        MVM_free(req);
-        MVM_exception_throw_adhoc(tc, "Failed to connect: %s", uv_strerror(status));
+/* Gets the length of an address that MVM_io_resolve_host_name handed back. */
+static socklen_t address_length(struct sockaddr *addr) {
+    return addr->sa_family == AF_INET6
+        ? sizeof(struct sockaddr_in6)
+        : sizeof(struct sockaddr_in);
+}
+
+/* Creates a socket suitable for talking to the specified address. */
+static Socket create_socket(MVMThreadContext *tc, struct sockaddr *addr) {
+    Socket s = socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    if (s == MVM_SOCKET_INVALID) {
+        MVM_free(addr);
+        throw_error(tc, "create socket");
+    }
+    return s;
+}
+
+/* Switches a socket between blocking and non-blocking mode. */
+static int set_blocking(Socket s, int blocking) {
+#ifdef _WIN32
+    u_long mode = blocking ? 0 : 1;
+    return ioctlsocket(s, FIONBIO, &mode);
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    if (flags < 0)
+        return flags;
+    return fcntl(s, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+#endif
+}
+
+/* Connects a socket. With a write timeout set, we connect in non-blocking
+ * mode and poll for completion, so the connection attempt is bounded. */
+static int connect_with_timeout(MVMThreadContext *tc, Socket s, struct sockaddr *dest,
+                                MVMint32 timeout) {
+    int r;
+    if (timeout <= 0)
+        return connect(s, dest, address_length(dest));
+
+    if (MVM_SOCKET_FAILED(set_blocking(s, 0)))
+        return -1;
+    r = connect(s, dest, address_length(dest));
+#ifdef _WIN32
+    if (MVM_SOCKET_FAILED(r) && WSAGetLastError() == WSAEWOULDBLOCK) {
+#else
+    if (MVM_SOCKET_FAILED(r) && errno == EINPROGRESS) {
+#endif
+        r = wait_ready(s, POLLOUT, timeout);
+        if (r == MVM_SOCKET_TIMED_OUT)
+            return -2;
+        if (r == 0) {
+            int       error = 0;
+            socklen_t len   = sizeof(error);
+            r = getsockopt(s, SOL_SOCKET, SO_ERROR, (char *)&error, &len);
+            if (!MVM_SOCKET_FAILED(r) && error) {
+#ifndef _WIN32
+                errno = error;
+#endif
+                r = -1;
+            }
+        }
     }
+    if (!MVM_SOCKET_FAILED(r) && MVM_SOCKET_FAILED(set_blocking(s, 1)))
+        return -1;
+    return r;
 }
+
 static void socket_connect(MVMThreadContext *tc, MVMOSHandle *h, MVMString *host, MVMint64 port) {
     MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
-    if (!data->ss.handle) {
-        struct sockaddr *dest    = MVM_io_resolve_host_name(tc, host, port);
-        uv_tcp_t        *socket  = MVM_malloc(sizeof(uv_tcp_t));
-        uv_connect_t    *connect = MVM_malloc(sizeof(uv_connect_t));
+    if (data->handle == MVM_SOCKET_INVALID) {
+        struct sockaddr *dest = MVM_io_resolve_host_name(tc, host, port);
+        Socket           s    = create_socket(tc, dest);
         int r;
 
-        data->ss.cur_tc = tc;
-        connect->data   = data;
-        if ((r = uv_tcp_init(tc->loop, socket)) < 0 ||
-                (r = uv_tcp_connect(connect, socket, dest, on_connect)) < 0) {
-            MVM_free(socket);
-            MVM_free(connect);
-            MVM_free(dest);
-            MVM_exception_throw_adhoc(tc, "Failed to connect: %s", uv_strerror(r));
-        }
-        uv_ref((uv_handle_t *)socket);
-        uv_run(tc->loop, UV_RUN_DEFAULT);
+        MVM_gc_mark_thread_blocked(tc);
+        r = connect_with_timeout(tc, s, dest, data->write_timeout);
+        MVM_gc_mark_thread_unblocked(tc);
+        MVM_free(dest);
 
-        data->ss.handle = (uv_stream_t *)socket;
+        if (MVM_SOCKET_FAILED(r)) {
+            closesocket(s);
+            if (r == -2)
+                MVM_exception_throw_adhoc(tc, "Timed out while trying to connect");
+            throw_error(tc, "connect");
+        }
 
-        MVM_free(connect);
-        MVM_free(dest);
+        data->handle = s;
     }
     else {
         MVM_exception_throw_adhoc(tc, "Socket is already bound or connected");
     }
 }
 
-static void on_connection(uv_stream_t *server, int status) {
-    /* Stash data for a later accept call (safe as we specify a queue of just
-     * one connection). Decrement reference count also. */
-    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)server->data;
-    data->accept_server = server;
-    data->accept_status = status;
-    uv_unref((uv_handle_t *)server);
-}
 static void socket_bind(MVMThreadContext *tc, MVMOSHandle *h, MVMString *host, MVMint64 port, MVMint32 backlog) {
     MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
-    if (!data->ss.handle) {
-        struct sockaddr *dest    = MVM_io_resolve_host_name(tc, host, port);
-        uv_tcp_t        *socket  = MVM_malloc(sizeof(uv_tcp_t));
-        int r;
+    if (data->handle == MVM_SOCKET_INVALID) {
+        struct sockaddr *dest = MVM_io_resolve_host_name(tc, host, port);
+        Socket           s    = create_socket(tc, dest);
+        int on = 1;
 
-        if ((r = uv_tcp_init(tc->loop, socket)) != 0 ||
-                (r = uv_tcp_bind(socket, dest, 0)) != 0) {
-            MVM_free(socket);
+        /* Match libuv, which set SO_REUSEADDR on listening sockets. */
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(on));
+        if (MVM_SOCKET_FAILED(bind(s, dest, address_length(dest)))) {
             MVM_free(dest);
-            MVM_exception_throw_adhoc(tc, "Failed to bind: %s", uv_strerror(r));
+            closesocket(s);
+            throw_error(tc, "bind");
         }
         MVM_free(dest);
 
-        /* Start listening, but unref the socket so it won't get in the way of
-         * other things we want to do on this event loop. */
-        socket->data = data;
-        if ((r = uv_listen((uv_stream_t *)socket, backlog, on_connection)) != 0) {
-            MVM_free(socket);
-            MVM_exception_throw_adhoc(tc, "Failed to listen: %s", uv_strerror(r));
+        if (MVM_SOCKET_FAILED(listen(s, backlog))) {
+            closesocket(s);
+            throw_error(tc, "listen");
         }
-        uv_unref((uv_handle_t *)socket);
 
-        data->ss.handle = (uv_stream_t *)socket;
+        data->handle = s;
     }
     else {
         MVM_exception_throw_adhoc(tc, "Socket is already bound or connected");
     }
 }
 
+static void socket_set_timeouts(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 read_ms, MVMint64 write_ms) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    if (read_ms < 0 || write_ms < 0)
+        MVM_exception_throw_adhoc(tc, "Socket timeouts must not be negative");
+    data->read_timeout  = read_ms  > 0x7FFFFFFF ? 0x7FFFFFFF : (MVMint32)read_ms;
+    data->write_timeout = write_ms > 0x7FFFFFFF ? 0x7FFFFFFF : (MVMint32)write_ms;
+}
+
 static MVMObject * socket_accept(MVMThreadContext *tc, MVMOSHandle *h);
 
+static MVMint64 is_tty(MVMThreadContext *tc, MVMOSHandle *h) {
+    return 0;
+}
+
+/* Get native socket descriptor. */
+static MVMint64 mvm_fileno(MVMThreadContext *tc, MVMOSHandle *h) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    return data->handle == MVM_SOCKET_INVALID ? -1 : (MVMint64)data->handle;
+}
+
+/* Prepares to copy from or to the socket directly, handing back any bytes we
+ * already received but that were not yet consumed. */
+static MVMint64 start_copy(MVMThreadContext *tc, MVMOSHandle *h, char **buf,
+                           MVMint64 *buffered, MVMint64 limit) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    ensure_open(tc, data, "copy with");
+    *buf      = NULL;
+    *buffered = 0;
+    if (data->ds && limit != 0) {
+        MVMint64 available;
+        if (data->ds->chars_head)
+            MVM_exception_throw_adhoc(tc, "Cannot copy from a socket with decoded characters pending");
+        available = MVM_string_decodestream_bytes_available(tc, data->ds);
+        if (limit > 0 && available > limit)
+            available = limit;
+        if (available > 0)
+            *buffered = MVM_string_decodestream_bytes_to_buf(tc, data->ds, buf, available);
+    }
+    return (MVMint64)data->handle;
+}
+
+/* Accounts for bytes that were moved through the socket directly. */
+static void end_copy(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 bytes_read,
+                     MVMint64 bytes_written) {
+    MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    if (data->ds)
+        data->ds->abs_byte_pos += bytes_read;
+    data->total_bytes_written += bytes_written;
+}
+
 /* IO ops table, populated with functions. */
 static const MVMIOClosable     closable      = { close_socket };
-static const MVMIOEncodable    encodable     = { MVM_io_syncstream_set_encoding };
-static const MVMIOSyncReadable sync_readable = { MVM_io_syncstream_set_separator,
-                                                 MVM_io_syncstream_read_line,
-                                                 MVM_io_syncstream_slurp,
-                                                 MVM_io_syncstream_read_chars,
-                                                 MVM_io_syncstream_read_bytes,
-                                                 MVM_io_syncstream_eof };
-static const MVMIOSyncWritable sync_writable = { MVM_io_syncstream_write_str,
-                                                 MVM_io_syncstream_write_bytes,
-                                                 MVM_io_syncstream_flush,
-                                                 MVM_io_syncstream_truncate };
-static const MVMIOSeekable          seekable = { MVM_io_syncstream_seek,
-                                                 MVM_io_syncstream_tell };
+static const MVMIOEncodable    encodable     = { set_encoding };
+static const MVMIOSyncReadable sync_readable = { set_separator,
+                                                 read_line,
+                                                 slurp,
+                                                 read_chars,
+                                                 read_bytes,
+                                                 eof };
+static const MVMIOSyncWritable sync_writable = { write_str,
+                                                 write_bytes,
+                                                 flush,
+                                                 truncatefh };
+static const MVMIOSeekable          seekable = { seek,
+                                                 tell };
 static const MVMIOSockety            sockety = { socket_connect,
                                                  socket_bind,
-                                                 socket_accept };
+                                                 socket_accept,
+                                                 socket_set_timeouts };
+static const MVMIOIntrospection introspection = { is_tty, mvm_fileno };
+static const MVMIOCopyable          copyable = { start_copy, end_copy };
 static const MVMIOOps op_table = {
     &closable,
     &encodable,
@@ -179,60 +589,60 @@ static const MVMIOOps op_table = {
     &sockety,
     NULL,
     NULL,
-    NULL,
+    &introspection,
+    &copyable,
     NULL,
     gc_free
 };
 
+/* Wraps a socket up in a handle. */
+static MVMObject * wrap_socket(MVMThreadContext *tc, Socket s) {
+    MVMOSHandle         * const result = (MVMOSHandle *)MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTIO);
+    MVMIOSyncSocketData * const data   = MVM_calloc(1, sizeof(MVMIOSyncSocketData));
+    data->handle   = s;
+    data->encoding = MVM_encoding_type_utf8;
+    MVM_string_decode_stream_sep_default(tc, &(data->sep_spec));
+    result->body.ops  = &op_table;
+    result->body.data = data;
+    return (MVMObject *)result;
+}
+
 static MVMObject * socket_accept(MVMThreadContext *tc, MVMOSHandle *h) {
     MVMIOSyncSocketData *data = (MVMIOSyncSocketData *)h->body.data;
+    MVMObject *result;
+    Socket s;
+    int r;
 
-    while (!data->accept_server) {
-        if (tc->loop != data->ss.handle->loop) {
-            MVM_exception_throw_adhoc(tc, "Tried to accept() on a socket from outside its originating thread");
-        }
-        uv_ref((uv_handle_t *)data->ss.handle);
-        uv_run(tc->loop, UV_RUN_DEFAULT);
+    ensure_open(tc, data, "accept on");
+    MVM_gc_mark_thread_blocked(tc);
+    r = wait_ready(data->handle, POLLIN, data->read_timeout);
+    if (r == MVM_SOCKET_TIMED_OUT) {
+        MVM_gc_mark_thread_unblocked(tc);
+        MVM_exception_throw_adhoc(tc, "Timed out while trying to accept");
     }
-
-    /* Check the accept worked out. */
-    if (data->accept_status < 0) {
-        MVM_exception_throw_adhoc(tc, "Failed to listen: unknown error");
-    }
-    else {
-        uv_tcp_t *client    = MVM_malloc(sizeof(uv_tcp_t));
-        uv_stream_t *server = data->accept_server;
-        int r;
-        uv_tcp_init(tc->loop, client);
-        data->accept_server = NULL;
-        if ((r = uv_accept(server, (uv_stream_t *)client)) == 0) {
-            MVMOSHandle         * const result = (MVMOSHandle *)MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTIO);
-            MVMIOSyncSocketData * const data   = MVM_calloc(1, sizeof(MVMIOSyncSocketData));
-            data->ss.handle   = (uv_stream_t *)client;
-            data->ss.encoding = MVM_encoding_type_utf8;
-            MVM_string_decode_stream_sep_default(tc, &(data->ss.sep_spec));
-            result->body.ops  = &op_table;
-            result->body.data = data;
-            return (MVMObject *)result;
-        }
-        else {
-            uv_close((uv_handle_t*)client, NULL);
-            MVM_free(client);
-            MVM_exception_throw_adhoc(tc, "Failed to accept: %s", uv_strerror(r));
-        }
+    s = MVM_SOCKET_INVALID;
+    if (r == 0) {
+        do {
+            s = accept(data->handle, NULL, NULL);
+#ifdef _WIN32
+        } while (0);
+#else
+        } while (s < 0 && errno == EINTR);
+#endif
     }
+    MVM_gc_mark_thread_unblocked(tc);
+    if (s == MVM_SOCKET_INVALID)
+        throw_error(tc, "accept");
+
+    /* Accepted sockets inherit the timeouts of the listening socket. */
+    result = wrap_socket(tc, s);
+    ((MVMIOSyncSocketData *)((MVMOSHandle *)result)->body.data)->read_timeout  = data->read_timeout;
+    ((MVMIOSyncSocketData *)((MVMOSHandle *)result)->body.data)->write_timeout = data->write_timeout;
+    return result;
 }
 
 MVMObject * MVM_io_socket_create(MVMThreadContext *tc, MVMint64 listen) {
-    MVMOSHandle         * const result = (MVMOSHandle *)MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTIO);
-    MVMIOSyncSocketData * const data   = MVM_calloc(1, sizeof(MVMIOSyncSocketData));
-    data->ss.handle   = NULL;
-    data->ss.encoding = MVM_encoding_type_utf8;
-    data->ss.translate_newlines = 0;
-    MVM_string_decode_stream_sep_default(tc, &(data->ss.sep_spec));
-    result->body.ops  = &op_table;
-    result->body.data = data;
-    return (MVMObject *)result;
+    return wrap_socket(tc, MVM_SOCKET_INVALID);
 }
 
 MVMString * MVM_io_get_hostname(MVMThreadContext *tc) {
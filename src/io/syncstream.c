@@ -333,6 +333,7 @@ static const MVMIOOps op_table = {
     NULL,
     &introspection,
     NULL,
+    NULL,
     gc_free
 };
 
@@ -1,38 +1,273 @@
 #include "moar.h"
 
+/* Timers are kept in a hierarchical timing wheel, which is driven by a
+ * single libuv timer, rather than each of them getting a libuv timer of its
+ * own. Inserting and cancelling a timer are O(1), which matters when there
+ * are many of them that mostly get cancelled before they fire (such as per
+ * request deadlines), and all timers that expire on the same tick are
+ * delivered in one go.
+ *
+ * A tick is a millisecond. The wheel has WHEEL_LEVELS levels, each of which
+ * has WHEEL_SLOTS slots. A timer due within WHEEL_SLOTS ticks goes in the
+ * level 0 slot for the tick it expires on; one due further away goes in a
+ * higher level, whose slots each cover WHEEL_SLOTS times as many ticks as a
+ * slot in the level below. When the wheel's time reaches the start of such
+ * a slot, its timers are cascaded down into lower levels. Timers due beyond
+ * the range of the wheel (about 49 days) are put in its furthest slot and
+ * placed again when it is reached.
+ *
+ * The wheel is only touched from the event loop thread. It is also what
+ * keeps the tasks of active timers alive, through being a GC root. */
+
+#define WHEEL_LEVELS    4
+#define WHEEL_SLOT_BITS 8
+#define WHEEL_SLOTS     (1 << WHEEL_SLOT_BITS)
+#define WHEEL_SLOT_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_RANGE     ((MVMuint64)1 << (WHEEL_SLOT_BITS * WHEEL_LEVELS))
+#define NO_WAKEUP       ((MVMuint64)-1)
+
+/* Mask for the ticks covered by a single slot of the given level. */
+#define LEVEL_MASK(level) (((MVMuint64)1 << (WHEEL_SLOT_BITS * (level))) - 1)
+
 /* Info we convey about a timer. */
-typedef struct {
-    int timeout;
-    int repeat;
+typedef struct TimerInfo TimerInfo;
+struct TimerInfo {
+    MVMint64 timeout;
+    MVMint64 repeat;
+
+    /* The async task, while the timer is in the wheel. */
+    MVMObject *task;
+
+    /* The tick the timer expires on, and the level of the wheel it is in
+     * (-1 if it is in the due list). */
+    MVMuint64 expiry;
+    MVMint32  level;
+
+    /* Links in the list of the slot we're in; prev_next is NULL if we're
+     * not in the wheel. */
+    TimerInfo  *next;
+    TimerInfo **prev_next;
+};
+
+/* The timer wheel. */
+struct MVMTimerWheel {
+    /* The libuv timer that drives the wheel. */
     uv_timer_t handle;
+
+    /* The loop time of tick 0, and the current tick, which all timers up to
+     * and including have been fired. */
+    MVMuint64 base;
+    MVMuint64 now;
+
+    /* The tick the libuv timer is set to fire at, or NO_WAKEUP. */
+    MVMuint64 wakeup;
+
+    /* Timers in each slot of each level, and the number in each level. */
+    TimerInfo *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    MVMuint32  counts[WHEEL_LEVELS];
+
+    /* Timers that are already due, and should be fired right away. */
+    TimerInfo *due;
+
+    /* The event loop thread. */
     MVMThreadContext *tc;
-    int work_idx;
-} TimerInfo;
-
-/* Timer callback; dispatches schedulee to the queue. */
-static void timer_cb(uv_timer_t *handle) {
-    TimerInfo        *ti = (TimerInfo *)handle->data;
-    MVMThreadContext *tc = ti->tc;
-    MVMAsyncTask     *t  = (MVMAsyncTask *)MVM_repr_at_pos_o(tc,
-        tc->instance->event_loop_active, ti->work_idx);
+};
+
+/* Links a timer into a list. */
+static void link_timer(TimerInfo **head, TimerInfo *ti) {
+    ti->next      = *head;
+    ti->prev_next = head;
+    if (ti->next)
+        ti->next->prev_next = &(ti->next);
+    *head = ti;
+}
+
+/* Unlinks a timer from the wheel. */
+static void unlink_timer(MVMTimerWheel *w, TimerInfo *ti) {
+    *(ti->prev_next) = ti->next;
+    if (ti->next)
+        ti->next->prev_next = ti->prev_next;
+    if (ti->level >= 0)
+        w->counts[ti->level]--;
+    ti->next      = NULL;
+    ti->prev_next = NULL;
+}
+
+/* Places a timer into the wheel according to its expiry, and returns the
+ * tick at which the wheel next needs to do something about it. */
+static MVMuint64 place_timer(MVMTimerWheel *w, TimerInfo *ti) {
+    MVMuint64 delta = ti->expiry > w->now ? ti->expiry - w->now : 0;
+    MVMuint64 slot_tick;
+    MVMint32  level;
+    if (delta == 0) {
+        ti->level = -1;
+        link_timer(&(w->due), ti);
+        return w->now;
+    }
+    slot_tick = delta < WHEEL_RANGE ? ti->expiry : w->now + WHEEL_RANGE - 1;
+    level     = 0;
+    while (level < WHEEL_LEVELS - 1 && delta > LEVEL_MASK(level + 1))
+        level++;
+    ti->level = level;
+    w->counts[level]++;
+    link_timer(&(w->slots[level][(slot_tick >> (WHEEL_SLOT_BITS * level)) & WHEEL_SLOT_MASK]), ti);
+    return slot_tick & ~LEVEL_MASK(level);
+}
+
+/* Fires a timer that has been unlinked from the wheel, putting it back in
+ * if it repeats. */
+static void fire_timer(MVMThreadContext *tc, MVMTimerWheel *w, TimerInfo *ti) {
+    MVMAsyncTask *t = (MVMAsyncTask *)ti->task;
+    if (ti->repeat > 0) {
+        ti->expiry = w->now + ti->repeat;
+        place_timer(w, ti);
+    }
+    else {
+        ti->task = NULL;
+    }
     MVM_repr_push_o(tc, t->body.queue, t->body.schedulee);
 }
 
-/* Sets the timer up on the event loop. */
+/* Fires all timers in a list. */
+static void fire_list(MVMThreadContext *tc, MVMTimerWheel *w, TimerInfo **head) {
+    TimerInfo *ti;
+    while ((ti = *head)) {
+        unlink_timer(w, ti);
+        fire_timer(tc, w, ti);
+    }
+}
+
+/* Moves all timers in a slot of a higher level down into lower ones. */
+static void cascade(MVMTimerWheel *w, MVMint32 level) {
+    TimerInfo **head = &(w->slots[level][(w->now >> (WHEEL_SLOT_BITS * level)) & WHEEL_SLOT_MASK]);
+    TimerInfo  *ti;
+    while ((ti = *head)) {
+        unlink_timer(w, ti);
+        place_timer(w, ti);
+    }
+}
+
+/* Advances the wheel up to the specified tick, firing all timers that are
+ * due by then. Stretches of ticks in which nothing can happen are skipped
+ * over. */
+static void advance(MVMThreadContext *tc, MVMTimerWheel *w, MVMuint64 target) {
+    fire_list(tc, w, &(w->due));
+    while (w->now < target) {
+        MVMint32  level = 0;
+        MVMuint64 next;
+        MVMint32  i;
+
+        /* Find the next tick on which something might happen. */
+        while (level < WHEEL_LEVELS && w->counts[level] == 0)
+            level++;
+        next = level == WHEEL_LEVELS
+            ? target
+            : (w->now | LEVEL_MASK(level)) + 1;
+        w->now = next < target ? next : target;
+
+        /* Cascade any higher level slots we just reached, then fire all
+         * that is due. */
+        for (i = 1; i < WHEEL_LEVELS && (w->now & LEVEL_MASK(i)) == 0; i++)
+            cascade(w, i);
+        fire_list(tc, w, &(w->slots[0][w->now & WHEEL_SLOT_MASK]));
+        fire_list(tc, w, &(w->due));
+    }
+}
+
+/* Gets the current tick according to the event loop. */
+static MVMuint64 current_tick(MVMTimerWheel *w) {
+    return uv_now(w->handle.loop) - w->base;
+}
+
+/* Sets the libuv timer to go off at the specified tick. */
+static void wheel_cb(uv_timer_t *handle);
+static void set_wakeup(MVMTimerWheel *w, MVMuint64 tick) {
+    MVMuint64 current = current_tick(w);
+    w->wakeup = tick;
+    uv_timer_start(&(w->handle), wheel_cb, tick > current ? tick - current : 0, 0);
+}
+
+/* Works out when the wheel next needs to do something, and sets the libuv
+ * timer accordingly, or stops it if there are no timers left. */
+static void schedule(MVMTimerWheel *w) {
+    MVMuint64 wakeup = NO_WAKEUP;
+    MVMint32  level  = 1;
+    if (w->due) {
+        set_wakeup(w, w->now);
+        return;
+    }
+
+    /* The next slot in level 0 that has timers in it, if any... */
+    if (w->counts[0]) {
+        MVMuint64 i;
+        for (i = 1; i < WHEEL_SLOTS; i++) {
+            if (w->slots[0][(w->now + i) & WHEEL_SLOT_MASK]) {
+                wakeup = w->now + i;
+                break;
+            }
+        }
+    }
+
+    /* ...unless we need to cascade timers from a higher level before then. */
+    while (level < WHEEL_LEVELS && w->counts[level] == 0)
+        level++;
+    if (level < WHEEL_LEVELS && (w->now | LEVEL_MASK(level)) + 1 < wakeup)
+        wakeup = (w->now | LEVEL_MASK(level)) + 1;
+
+    if (wakeup != NO_WAKEUP) {
+        set_wakeup(w, wakeup);
+    }
+    else {
+        uv_timer_stop(&(w->handle));
+        w->wakeup = NO_WAKEUP;
+    }
+}
+
+/* Callback of the libuv timer that drives the wheel. */
+static void wheel_cb(uv_timer_t *handle) {
+    MVMTimerWheel *w = (MVMTimerWheel *)handle->data;
+    w->wakeup = NO_WAKEUP;
+    advance(w->tc, w, current_tick(w));
+    schedule(w);
+}
+
+/* Gets the timer wheel, creating it if needed. */
+static MVMTimerWheel * get_wheel(MVMThreadContext *tc, uv_loop_t *loop) {
+    MVMTimerWheel *w = tc->instance->timer_wheel;
+    if (!w) {
+        w              = MVM_calloc(1, sizeof(MVMTimerWheel));
+        uv_timer_init(loop, &(w->handle));
+        w->handle.data = w;
+        w->base        = uv_now(loop);
+        w->wakeup      = NO_WAKEUP;
+        w->tc          = tc;
+        tc->instance->timer_wheel = w;
+    }
+    return w;
+}
+
+/* Puts the timer into the wheel. */
 static void setup(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_task, void *data) {
-    TimerInfo *ti = (TimerInfo *)data;
-    uv_timer_init(loop, &ti->handle);
-    ti->work_idx    = MVM_repr_elems(tc, tc->instance->event_loop_active);
-    ti->tc          = tc;
-    ti->handle.data = ti;
-    MVM_repr_push_o(tc, tc->instance->event_loop_active, async_task);
-    uv_timer_start(&ti->handle, timer_cb, ti->timeout, ti->repeat);
+    TimerInfo     *ti = (TimerInfo *)data;
+    MVMTimerWheel *w  = get_wheel(tc, loop);
+    MVMuint64      wakeup;
+    advance(tc, w, current_tick(w));
+    ti->task   = async_task;
+    ti->expiry = w->now + (ti->timeout > 0 ? ti->timeout : 0);
+    wakeup     = place_timer(w, ti);
+    if (wakeup < w->wakeup)
+        set_wakeup(w, wakeup);
 }
 
-/* Stops the timer. */
+/* Takes the timer out of the wheel. There's no need to adjust when the wheel
+ * wakes up; if it finds nothing to do, it just works out when to wake up
+ * next. */
 static void cancel(MVMThreadContext *tc, uv_loop_t *loop, MVMObject *async_task, void *data) {
     TimerInfo *ti = (TimerInfo *)data;
-    uv_timer_stop(&ti->handle);
+    if (ti->prev_next) {
+        unlink_timer(tc->instance->timer_wheel, ti);
+        ti->task = NULL;
+    }
 }
 
 /* Frees data associated with a timer async task. */
@@ -73,14 +308,39 @@ MVMObject * MVM_io_timer_create(MVMThreadContext *tc, MVMObject *queue,
     MVM_ASSIGN_REF(tc, &(task->common.header), task->body.queue, queue);
     MVM_ASSIGN_REF(tc, &(task->common.header), task->body.schedulee, schedulee);
     task->body.ops      = &op_table;
-    timer_info          = MVM_malloc(sizeof(TimerInfo));
+    timer_info          = MVM_calloc(1, sizeof(TimerInfo));
     timer_info->timeout = timeout;
     timer_info->repeat  = repeat;
     task->body.data     = timer_info;
 
-    /* Hand the task off to the event loop, which will set up the timer on the
-     * event loop. */
+    /* Hand the task off to the event loop, which will put the timer into the
+     * timer wheel. */
     MVM_io_eventloop_queue_work(tc, (MVMObject *)task);
 
     return (MVMObject *)task;
 }
+
+/* Adds the tasks of all timers in the wheel to the GC worklist or heap
+ * snapshot, since nothing else keeps them alive. */
+static void mark_list(MVMThreadContext *tc, TimerInfo *ti, MVMGCWorklist *worklist,
+                      MVMHeapSnapshotState *snapshot) {
+    for (; ti; ti = ti->next) {
+        if (worklist)
+            MVM_gc_worklist_add(tc, worklist, &(ti->task));
+        else
+            MVM_profile_heap_add_collectable_rel_const_cstr(tc, snapshot,
+                (MVMCollectable *)ti->task, "Active timer");
+    }
+}
+void MVM_io_timer_wheel_mark(MVMThreadContext *tc, MVMGCWorklist *worklist,
+                             MVMHeapSnapshotState *snapshot) {
+    MVMTimerWheel *w = tc->instance->timer_wheel;
+    if (w) {
+        MVMint32 level, slot;
+        mark_list(tc, w->due, worklist, snapshot);
+        for (level = 0; level < WHEEL_LEVELS; level++)
+            if (w->counts[level])
+                for (slot = 0; slot < WHEEL_SLOTS; slot++)
+                    mark_list(tc, w->slots[level][slot], worklist, snapshot);
+    }
+}
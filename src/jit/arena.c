@@ -0,0 +1,159 @@
+#include "moar.h"
+#include "platform/mmap.h"
+
+void MVM_jit_arena_init(MVMInstance *instance) {
+    MVMJitArena *arena = MVM_calloc(1, sizeof(MVMJitArena));
+    int init_stat;
+    if ((init_stat = uv_mutex_init(&arena->mutex)) < 0) {
+        fprintf(stderr, "MoarVM: Initialization of JIT arena mutex failed\n    %s\n",
+            uv_strerror(init_stat));
+        exit(1);
+    }
+    arena->dual_mapping = -1;
+    instance->jit_arena = arena;
+}
+
+/* Maps a new chunk and makes it the current one. Returns NULL if dual
+ * mapping failed. */
+static MVMJitArenaChunk * new_chunk(MVMJitArena *arena, size_t min_size) {
+    MVMJitArenaChunk *chunk;
+    void *writable, *executable;
+    size_t size = MVM_JIT_ARENA_CHUNK_SIZE;
+    while (size < min_size)
+        size *= 2;
+    if (!MVM_platform_alloc_dual_pages(size, &writable, &executable))
+        return NULL;
+    chunk             = MVM_calloc(1, sizeof(MVMJitArenaChunk));
+    chunk->writable   = writable;
+    chunk->executable = executable;
+    chunk->size       = size;
+    chunk->next       = arena->chunks;
+    arena->chunks     = chunk;
+    arena->mapped_bytes += size;
+    return chunk;
+}
+
+static void free_chunk(MVMJitArena *arena, MVMJitArenaChunk *chunk) {
+    MVM_platform_free_dual_pages(chunk->writable, chunk->executable, chunk->size);
+    arena->mapped_bytes -= chunk->size;
+    MVM_free(chunk);
+}
+
+/* Allocates space for size bytes of code. Returns the address the code will
+ * run at, and sets writable to the address it should be written at. Once
+ * written, MVM_jit_arena_commit must be called before running it. */
+void * MVM_jit_arena_alloc(MVMThreadContext *tc, size_t size, void **writable) {
+    MVMJitArena      *arena   = tc->instance->jit_arena;
+    size_t            aligned = (size + MVM_JIT_ARENA_ALIGN - 1) & ~(size_t)(MVM_JIT_ARENA_ALIGN - 1);
+    MVMJitArenaChunk *chunk;
+    void             *code;
+
+    uv_mutex_lock(&arena->mutex);
+    if (arena->dual_mapping == -1)
+        arena->dual_mapping = new_chunk(arena, aligned) != NULL;
+    if (!arena->dual_mapping) {
+        /* No dual mapping; fall back to pages of our own. */
+        code = MVM_platform_alloc_pages(size, MVM_PAGE_READ|MVM_PAGE_WRITE);
+        arena->code_bytes   += size;
+        arena->mapped_bytes += size;
+        arena->num_code++;
+        uv_mutex_unlock(&arena->mutex);
+        *writable = code;
+        return code;
+    }
+
+    /* Find room in the current chunk, or start a new one. We don't go back
+     * to older chunks; their free space is lost until they are empty. */
+    chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < aligned) {
+        MVMJitArenaChunk *old = chunk;
+        chunk = new_chunk(arena, aligned);
+        if (!chunk) {
+            uv_mutex_unlock(&arena->mutex);
+            MVM_panic(1, "JIT: Could not map %"MVM_PRSz" bytes for code", aligned);
+        }
+        if (old && old->live == 0) {
+            chunk->next = old->next;
+            free_chunk(arena, old);
+        }
+    }
+    *writable = chunk->writable + chunk->used;
+    code      = chunk->executable + chunk->used;
+    chunk->used += aligned;
+    chunk->live++;
+    arena->code_bytes += size;
+    arena->num_code++;
+    uv_mutex_unlock(&arena->mutex);
+    return code;
+}
+
+/* Makes code that has been written ready to run. */
+void MVM_jit_arena_commit(MVMThreadContext *tc, void *code, size_t size) {
+    if (tc->instance->jit_arena->dual_mapping != 1)
+        MVM_platform_set_page_mode(code, size, MVM_PAGE_READ|MVM_PAGE_EXEC);
+}
+
+/* Releases the space of a piece of code. A chunk is unmapped once all the
+ * code in it is gone; the current chunk is just reused from the start. */
+void MVM_jit_arena_free(MVMThreadContext *tc, void *code, size_t size) {
+    MVMJitArena       *arena = tc->instance->jit_arena;
+    MVMJitArenaChunk **prev;
+    MVMJitArenaChunk  *chunk;
+
+    uv_mutex_lock(&arena->mutex);
+    arena->code_bytes -= size;
+    arena->num_code--;
+    if (arena->dual_mapping != 1) {
+        MVM_platform_free_pages(code, size);
+        arena->mapped_bytes -= size;
+        uv_mutex_unlock(&arena->mutex);
+        return;
+    }
+    prev  = &arena->chunks;
+    chunk = arena->chunks;
+    while (chunk) {
+        if ((char *)code >= chunk->executable && (char *)code < chunk->executable + chunk->size) {
+            if (--chunk->live == 0) {
+                if (chunk == arena->chunks) {
+                    chunk->used = 0;
+                }
+                else {
+                    *prev = chunk->next;
+                    free_chunk(arena, chunk);
+                }
+            }
+            break;
+        }
+        prev  = &chunk->next;
+        chunk = chunk->next;
+    }
+    uv_mutex_unlock(&arena->mutex);
+}
+
+/* Writes arena statistics to the JIT log. */
+void MVM_jit_arena_log_stats(MVMThreadContext *tc) {
+    MVMJitArena *arena = tc->instance->jit_arena;
+    MVMuint64    unused, wasted;
+    uv_mutex_lock(&arena->mutex);
+    unused = arena->dual_mapping == 1 && arena->chunks
+        ? arena->chunks->size - arena->chunks->used
+        : 0;
+    wasted = arena->mapped_bytes - arena->code_bytes - unused;
+    MVM_jit_log(tc, "Code arena: %"PRIu64" bytes of code in %"PRIu64" frames, "
+                "%"PRIu64" bytes mapped, %"PRIu64" bytes wasted\n",
+                arena->code_bytes, arena->num_code, arena->mapped_bytes, wasted);
+    uv_mutex_unlock(&arena->mutex);
+}
+
+void MVM_jit_arena_destroy(MVMInstance *instance) {
+    MVMJitArena      *arena = instance->jit_arena;
+    MVMJitArenaChunk *chunk = arena->chunks;
+    while (chunk) {
+        MVMJitArenaChunk *next = chunk->next;
+        free_chunk(arena, chunk);
+        chunk = next;
+    }
+    uv_mutex_destroy(&arena->mutex);
+    MVM_free(arena);
+    instance->jit_arena = NULL;
+}
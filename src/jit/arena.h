@@ -0,0 +1,50 @@
+/* The JIT code arena hands out executable memory for compiled frames by
+ * bump allocation from large chunks. Each chunk is mapped twice, once
+ * writable and once executable, so code is written through one mapping and
+ * run through the other. Where that isn't supported, each piece of code gets
+ * its own pages, which are flipped to executable once written. */
+
+/* Size of a code chunk; bigger pieces of code get a chunk to themselves. */
+#define MVM_JIT_ARENA_CHUNK_SIZE (1024 * 1024)
+
+/* Alignment of the start of each piece of code. */
+#define MVM_JIT_ARENA_ALIGN 16
+
+struct MVMJitArenaChunk {
+    /* The writable and executable mappings of the chunk. */
+    char *writable;
+    char *executable;
+
+    /* Size of the chunk, and how much of it has been handed out. */
+    size_t size;
+    size_t used;
+
+    /* Number of pieces of code in the chunk that are still alive. */
+    MVMuint32 live;
+
+    MVMJitArenaChunk *next;
+};
+
+struct MVMJitArena {
+    /* Protects everything below. */
+    uv_mutex_t mutex;
+
+    /* Chunks we're allocating from; the first is the current one. */
+    MVMJitArenaChunk *chunks;
+
+    /* Whether dual mapping works here; -1 until we've tried. */
+    MVMint32 dual_mapping;
+
+    /* Statistics: live code bytes, total bytes mapped, and number of live
+     * pieces of code. */
+    MVMuint64 code_bytes;
+    MVMuint64 mapped_bytes;
+    MVMuint64 num_code;
+};
+
+void MVM_jit_arena_init(MVMInstance *instance);
+void * MVM_jit_arena_alloc(MVMThreadContext *tc, size_t size, void **writable);
+void MVM_jit_arena_commit(MVMThreadContext *tc, void *code, size_t size);
+void MVM_jit_arena_free(MVMThreadContext *tc, void *code, size_t size);
+void MVM_jit_arena_log_stats(MVMThreadContext *tc);
+void MVM_jit_arena_destroy(MVMInstance *instance);
@@ -11,6 +11,7 @@ static const MVMuint16 MAGIC_BYTECODE[] = { MVM_OP_sp_jit_enter, 0 };
 MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMJitGraph *jg) {
     dasm_State *state;
     char * memory;
+    void * writable;
     size_t codesize;
     /* Space for globals */
     MVMint32  num_globals = MVM_jit_num_globals();
@@ -62,10 +63,10 @@ MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMJitGraph *jg) {
 
     /* compile the function */
     dasm_link(&state, &codesize);
-    memory = MVM_platform_alloc_pages(codesize, MVM_PAGE_READ|MVM_PAGE_WRITE);
-    dasm_encode(&state, memory);
-    /* set memory readable + executable */
-    MVM_platform_set_page_mode(memory, codesize, MVM_PAGE_READ|MVM_PAGE_EXEC);
+    memory = MVM_jit_arena_alloc(tc, codesize, &writable);
+    dasm_encode(&state, writable);
+    /* make the code runnable */
+    MVM_jit_arena_commit(tc, memory, codesize);
 
 
     MVM_jit_log(tc, "Bytecode size: %"MVM_PRSz"\n", codesize);
@@ -107,13 +108,18 @@ MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMJitGraph *jg) {
     if (tc->instance->jit_bytecode_dir) {
         MVM_jit_log_bytecode(tc, code);
     }
-    if (tc->instance->jit_log_fh)
+    if (tc->instance->jit_perf_map || tc->instance->jit_perf_dump) {
+        MVM_jit_log_perf(tc, code);
+    }
+    if (tc->instance->jit_log_fh) {
+        MVM_jit_arena_log_stats(tc);
         fflush(tc->instance->jit_log_fh);
+    }
     return code;
 }
 
 void MVM_jit_destroy_code(MVMThreadContext *tc, MVMJitCode *code) {
-    MVM_platform_free_pages(code->func_ptr, code->size);
+    MVM_jit_arena_free(tc, code->func_ptr, code->size);
     MVM_free(code->labels);
     MVM_free(code->bb_labels);
     MVM_free(code->deopts);
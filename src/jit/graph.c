@@ -176,7 +176,7 @@ static void jgb_append_label(MVMThreadContext *tc, JitGraphBuilder *jgb, MVMint3
     MVM_jit_log(tc, "append label: %d\n", node->u.label.name);
 }
 
-static void * op_to_func(MVMThreadContext *tc, MVMint16 opcode) {
+static void * op_to_func_or_null(MVMint16 opcode) {
     switch(opcode) {
     case MVM_OP_checkarity: return MVM_args_checkarity;
     case MVM_OP_say: return MVM_string_say;
@@ -390,11 +390,82 @@ static void * op_to_func(MVMThreadContext *tc, MVMint16 opcode) {
     case MVM_OP_sp_boolify_iter: return MVM_iter_istrue;
     case MVM_OP_prof_allocated: return MVM_profile_log_allocated;
     case MVM_OP_prof_exit: return MVM_profile_log_exit;
-    default:
-        MVM_oops(tc, "JIT: No function for op %d in op_to_func (%s)", opcode, MVM_op_get_op(opcode)->name);
+
+    /* Ops from here on are not handled anywhere else, and are compiled as a
+     * generic call: the function takes the thread context followed by each
+     * of the op's read operands in order, and returns the value for the
+     * op's result register, if it has one. */
+    case MVM_OP_pow_I: return MVM_bigint_pow;
+    case MVM_OP_isprime_I: return MVM_bigint_is_prime;
+    case MVM_OP_backtracestrings: return MVM_exception_backtrace_strings;
+    case MVM_OP_istrue_s: return MVM_coerce_istrue_s;
+    case MVM_OP_open_dir: return MVM_dir_open;
+    case MVM_OP_read_dir: return MVM_dir_read;
+    case MVM_OP_open_fh: return MVM_file_open_fh;
+    case MVM_OP_socket: return MVM_io_socket_create;
+    case MVM_OP_accept_sk: return MVM_io_accept;
+    case MVM_OP_readall_fh: return MVM_io_slurp;
+    case MVM_OP_tell_fh: return MVM_io_tell;
+    case MVM_OP_rand_i: return MVM_proc_rand_i;
+    case MVM_OP_rand_n: return MVM_proc_rand_n;
+    case MVM_OP_time_i: return MVM_proc_time_i;
+    case MVM_OP_cwd: return MVM_dir_cwd;
+    case MVM_OP_clargs: return MVM_proc_clargs;
+    case MVM_OP_getenvhash: return MVM_proc_getenvhash;
+    case MVM_OP_backendconfig: return MVM_backend_config;
+    case MVM_OP_getpid: return MVM_proc_getpid;
+    case MVM_OP_backtrace: return MVM_exception_backtrace;
+    case MVM_OP_gethostname: return MVM_io_get_hostname;
+    case MVM_OP_threadid: return MVM_thread_id;
+    case MVM_OP_currentthread: return MVM_thread_current;
+    case MVM_OP_execname: return MVM_executable_name;
+    case MVM_OP_close_fhi: return MVM_io_close;
+    case MVM_OP_readlink: return MVM_file_readlink;
+    case MVM_OP_nativecallsizeof: return MVM_nativecall_sizeof;
+    case MVM_OP_getcodelocation: return MVM_code_location;
+    case MVM_OP_ordbaseat: return MVM_string_ord_basechar_at;
+    case MVM_OP_dimensions: return MVM_repr_dimensions;
+    case MVM_OP_numdimensions: return MVM_repr_num_dimensions;
+    case MVM_OP_fc: return MVM_string_fc;
+    case MVM_OP_istty_fh: return MVM_io_is_tty;
+    case MVM_OP_fileno_fh: return MVM_io_fileno;
+    case MVM_OP_sethllconfig: return MVM_hll_set_config;
+    case MVM_OP_copy_f: return MVM_file_copy;
+    case MVM_OP_rename_f: return MVM_file_rename;
+    case MVM_OP_delete_f: return MVM_file_delete;
+    case MVM_OP_chmod_f: return MVM_file_chmod;
+    case MVM_OP_mkdir: return MVM_dir_mkdir;
+    case MVM_OP_rmdir: return MVM_dir_rmdir;
+    case MVM_OP_close_dir: return MVM_dir_close;
+    case MVM_OP_close_fh: return MVM_io_close;
+    case MVM_OP_spew: return MVM_file_spew;
+    case MVM_OP_unlock_fh: return MVM_io_unlock;
+    case MVM_OP_sync_fh: return MVM_io_flush;
+    case MVM_OP_trunc_fh: return MVM_io_truncate;
+    case MVM_OP_setinputlinesep_fh: return MVM_io_set_separator;
+    case MVM_OP_chdir: return MVM_dir_chdir;
+    case MVM_OP_srand: return MVM_proc_seed;
+    case MVM_OP_write_fhb: return MVM_io_write_bytes;
+    case MVM_OP_symlink: return MVM_file_symlink;
+    case MVM_OP_link: return MVM_file_link;
+    case MVM_OP_cancel: return MVM_io_eventloop_cancel_work;
+    case MVM_OP_killprocasync: return MVM_proc_kill_async;
+    case MVM_OP_settypefinalize: return MVM_gc_finalize_set;
+    case MVM_OP_setparameterizer: return MVM_6model_parametric_setup;
+    case MVM_OP_neverrepossess: return MVM_6model_never_repossess;
+    case MVM_OP_setdimensions: return MVM_repr_set_dimensions;
+    case MVM_OP_setinputlineseps_fh: return MVM_io_set_separators;
+    default: return NULL;
     }
 }
 
+static void * op_to_func(MVMThreadContext *tc, MVMint16 opcode) {
+    void *func = op_to_func_or_null(opcode);
+    if (!func)
+        MVM_oops(tc, "JIT: No function for op %d in op_to_func (%s)", opcode, MVM_op_get_op(opcode)->name);
+    return func;
+}
+
 static void jgb_append_guard(MVMThreadContext *tc, JitGraphBuilder *jgb,
                              MVMSpeshIns *ins) {
     MVMSpeshAnn   *ann = ins->annotations;
@@ -519,6 +590,7 @@ static MVMint32 jgb_consume_invoke(MVMThreadContext *tc, JitGraphBuilder *jgb,
         default:
             MVM_jit_log(tc, "Unexpected opcode in invoke sequence: <%s>\n",
                         ins->info->name);
+            MVM_jit_count_bail(tc, ins->info->opcode);
             return 0;
         }
     }
@@ -527,6 +599,8 @@ static MVMint32 jgb_consume_invoke(MVMThreadContext *tc, JitGraphBuilder *jgb,
         MVM_jit_log(tc, "Could not find invoke opcode or enough arguments\n"
                     "BAIL: op <%s>, expected args: %d, num of args: %d\n",
                     ins? ins->info->name : "NULL", i, cs->arg_count);
+        /* With no invoke op found, blame the prepargs that began it. */
+        MVM_jit_count_bail(tc, ins ? ins->info->opcode : MVM_OP_prepargs);
         return 0;
     }
     MVM_jit_log(tc, "Invoke instruction: <%s>\n", ins->info->name);
@@ -723,6 +797,44 @@ static void jgb_after_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
     }
 }
 
+/* Compiles an op as a generic call to the function op_to_func gives for it,
+ * deriving the arguments and return mode from the op's operands. */
+static MVMint32 jgb_consume_generic(MVMThreadContext *tc, JitGraphBuilder *jgb,
+                                    MVMSpeshIns *ins, void *func) {
+    const MVMOpInfo *info    = ins->info;
+    MVMJitCallArg    args[MVM_MAX_OPERANDS + 1];
+    MVMJitRVMode     rv_mode = MVM_JIT_RV_VOID;
+    MVMint16         rv_idx  = -1;
+    MVMint16         num_args = 1;
+    MVMint16         i;
+    args[0].type   = MVM_JIT_INTERP_VAR;
+    args[0].v.ivar = MVM_JIT_INTERP_TC;
+    for (i = 0; i < info->num_operands; i++) {
+        MVMuint8 rw   = info->operands[i] & MVM_operand_rw_mask;
+        MVMuint8 type = info->operands[i] & MVM_operand_type_mask;
+        if (type != MVM_operand_int64 && type != MVM_operand_num64 &&
+            type != MVM_operand_str && type != MVM_operand_obj)
+            return 0;
+        if (rw == MVM_operand_write_reg && i == 0) {
+            rv_idx  = ins->operands[0].reg.orig;
+            rv_mode = type == MVM_operand_int64 ? MVM_JIT_RV_INT
+                    : type == MVM_operand_num64 ? MVM_JIT_RV_NUM
+                    : MVM_JIT_RV_PTR;
+        }
+        else if (rw == MVM_operand_read_reg) {
+            args[num_args].type  = type == MVM_operand_num64 ? MVM_JIT_REG_VAL_F : MVM_JIT_REG_VAL;
+            args[num_args].v.reg = ins->operands[i].reg.orig;
+            num_args++;
+        }
+        else {
+            return 0;
+        }
+    }
+    MVM_jit_log(tc, "append generic call for <%s>\n", info->name);
+    jgb_append_call_c(tc, jgb, func, num_args, args, rv_mode, rv_idx);
+    return 1;
+}
+
 static MVMint32 jgb_consume_reprop(MVMThreadContext *tc, JitGraphBuilder *jgb,
                                    MVMSpeshBB *bb, MVMSpeshIns *ins) {
     MVMint16 op = ins->info->opcode;
@@ -1968,6 +2080,7 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
     case MVM_OP_elems:
         if (!jgb_consume_reprop(tc, jgb, bb, ins)) {
             MVM_jit_log(tc, "BAIL: op <%s> (devirt attempted)\n", ins->info->name);
+            MVM_jit_count_bail(tc, ins->info->opcode);
             return 0;
         }
         break;
@@ -2713,6 +2826,9 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
     default: {
         /* Check if it's an extop. */
         MVMint32 emitted_extop = 0;
+        void *generic_func = op_to_func_or_null(op);
+        if (generic_func && jgb_consume_generic(tc, jgb, ins, generic_func))
+            break;
         if (ins->info->opcode == (MVMuint16)-1) {
             MVMExtOpRecord *extops     = jgb->sg->sf->body.cu->body.extops;
             MVMuint16       num_extops = jgb->sg->sf->body.cu->body.num_extops;
@@ -2735,6 +2851,7 @@ static MVMint32 jgb_consume_ins(MVMThreadContext *tc, JitGraphBuilder *jgb,
         }
         if (!emitted_extop) {
             MVM_jit_log(tc, "BAIL: op <%s>\n", ins->info->name);
+            MVM_jit_count_bail(tc, ins->info->opcode);
             return 0;
         }
     }
@@ -1,4 +1,9 @@
 #include "moar.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 /* inline this? maybe */
 void MVM_jit_log(MVMThreadContext *tc, const char * fmt, ...) {
@@ -35,3 +40,174 @@ void MVM_jit_log_bytecode(MVMThreadContext *tc, MVMJitCode *code) {
     }
     MVM_free(filename);
 }
+
+/* Counts a frame that could not be compiled because of the given op, for
+ * the bail census. Extops are all counted together. */
+void MVM_jit_count_bail(MVMThreadContext *tc, MVMuint16 opcode) {
+    MVMuint16 idx = opcode < MVM_OP_EXT_BASE ? opcode : MVM_OP_EXT_BASE;
+    MVM_incr(&tc->instance->jit_bail_counts[idx]);
+}
+
+/* Writes the ops that caused frames not to be compiled to the JIT log, most
+ * frequent first. */
+void MVM_jit_log_bail_census(MVMThreadContext *tc) {
+    AO_t      *counts = tc->instance->jit_bail_counts;
+    MVMuint16 *order;
+    MVMuint32  num    = 0;
+    MVMuint32  i, j;
+    if (!tc->instance->jit_log_fh)
+        return;
+    order = MVM_malloc(sizeof(MVMuint16) * (MVM_OP_EXT_BASE + 1));
+    for (i = 0; i <= MVM_OP_EXT_BASE; i++)
+        if (counts[i])
+            order[num++] = (MVMuint16)i;
+    /* Insertion sort by count; there are few distinct bail ops. */
+    for (i = 1; i < num; i++) {
+        MVMuint16 cur = order[i];
+        for (j = i; j > 0 && counts[order[j - 1]] < counts[cur]; j--)
+            order[j] = order[j - 1];
+        order[j] = cur;
+    }
+    MVM_jit_log(tc, "JIT bail census (frames not compiled, by op):\n");
+    for (i = 0; i < num; i++)
+        MVM_jit_log(tc, "%10"PRIu64" %s\n", (MVMuint64)counts[order[i]],
+            order[i] == MVM_OP_EXT_BASE ? "(extops)" : MVM_op_get_op(order[i])->name);
+    MVM_free(order);
+}
+
+#ifdef __linux__
+/* Records of the jitdump format understood by perf inject --jit; see
+ * tools/perf/Documentation/jitdump-specification.txt in the Linux tree. */
+#define JITDUMP_MAGIC         0x4A695444
+#define JITDUMP_VERSION       1
+#define JITDUMP_EM_X86_64     62
+#define JITDUMP_JIT_CODE_LOAD 0
+
+typedef struct {
+    MVMuint32 magic;
+    MVMuint32 version;
+    MVMuint32 total_size;
+    MVMuint32 elf_mach;
+    MVMuint32 pad1;
+    MVMuint32 pid;
+    MVMuint64 timestamp;
+    MVMuint64 flags;
+} JitDumpHeader;
+
+typedef struct {
+    MVMuint32 id;
+    MVMuint32 total_size;
+    MVMuint64 timestamp;
+    MVMuint32 pid;
+    MVMuint32 tid;
+    MVMuint64 vma;
+    MVMuint64 code_addr;
+    MVMuint64 code_size;
+    MVMuint64 code_index;
+} JitDumpCodeLoad;
+#endif
+
+/* Opens the perf map (/tmp/perf-<pid>.map) and/or a jitdump file in the
+ * given directory, as requested by the environment. */
+void MVM_jit_perf_setup(MVMInstance *instance, const char *perf_map, const char *perf_dump_dir) {
+#ifdef __linux__
+    if (perf_map && strlen(perf_map)) {
+        char filename[64];
+        snprintf(filename, sizeof(filename), "/tmp/perf-%d.map", (int)getpid());
+        instance->jit_perf_map = fopen(filename, "a");
+    }
+    if (perf_dump_dir && strlen(perf_dump_dir)) {
+        char *filename = MVM_malloc(strlen(perf_dump_dir) + 32);
+        FILE *fh;
+        sprintf(filename, "%s/jit-%d.dump", perf_dump_dir, (int)getpid());
+        fh = fopen(filename, "w+");
+        if (fh) {
+            /* perf finds the dump by seeing it mapped executable. */
+            long  page_size = sysconf(_SC_PAGESIZE);
+            void *marker    = mmap(NULL, page_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(fh), 0);
+            JitDumpHeader header;
+            if (marker == MAP_FAILED) {
+                fclose(fh);
+            }
+            else {
+                header.magic      = JITDUMP_MAGIC;
+                header.version    = JITDUMP_VERSION;
+                header.total_size = sizeof(JitDumpHeader);
+                header.elf_mach   = JITDUMP_EM_X86_64;
+                header.pad1       = 0;
+                header.pid        = (MVMuint32)getpid();
+                header.timestamp  = uv_hrtime();
+                header.flags      = 0;
+                fwrite(&header, sizeof(JitDumpHeader), 1, fh);
+                instance->jit_perf_dump        = fh;
+                instance->jit_perf_dump_marker = marker;
+            }
+        }
+        MVM_free(filename);
+    }
+#endif
+}
+
+/* Writes a compiled frame to the perf map and/or jitdump, named after the
+ * static frame and where its code starts. */
+void MVM_jit_log_perf(MVMThreadContext *tc, MVMJitCode *code) {
+#ifdef __linux__
+    MVMStaticFrame        *sf    = code->sf;
+    MVMCompUnit           *cu    = sf->body.cu;
+    MVMBytecodeAnnotation  ann_buf;
+    MVMBytecodeAnnotation *ann   = MVM_bytecode_resolve_annotation(tc, &(sf->body), 0, &ann_buf);
+    MVMString             *file  = ann && ann->filename_string_heap_index < cu->body.num_strings
+        ? MVM_cu_string(tc, cu, ann->filename_string_heap_index)
+        : cu->body.filename;
+    MVMuint32              line  = ann ? ann->line_number : 1;
+    char                  *cname = MVM_string_utf8_encode_C_string(tc, sf->body.name);
+    char                  *cfile = file ? MVM_string_utf8_encode_C_string(tc, file) : NULL;
+    char                  *name  = MVM_malloc(strlen(cname) + (cfile ? strlen(cfile) : 1) + 32);
+    sprintf(name, "%s %s:%u", strlen(cname) ? cname : "<anon>", cfile ? cfile : "?", line);
+    MVM_free(cname);
+    MVM_free(cfile);
+
+    if (tc->instance->jit_perf_map) {
+        fprintf(tc->instance->jit_perf_map, "%"PRIx64" %"PRIx64" %s\n",
+            (MVMuint64)(uintptr_t)code->func_ptr, (MVMuint64)code->size, name);
+        fflush(tc->instance->jit_perf_map);
+    }
+    if (tc->instance->jit_perf_dump) {
+        FILE           *fh       = tc->instance->jit_perf_dump;
+        size_t          name_len = strlen(name) + 1;
+        JitDumpCodeLoad rec;
+        rec.id         = JITDUMP_JIT_CODE_LOAD;
+        rec.total_size = (MVMuint32)(sizeof(JitDumpCodeLoad) + name_len + code->size);
+        rec.timestamp  = uv_hrtime();
+        rec.pid        = (MVMuint32)getpid();
+        rec.tid        = (MVMuint32)syscall(SYS_gettid);
+        rec.vma        = (MVMuint64)(uintptr_t)code->func_ptr;
+        rec.code_addr  = rec.vma;
+        rec.code_size  = code->size;
+        rec.code_index = code->seq_nr;
+        /* Records must not interleave between threads. */
+        flockfile(fh);
+        fwrite(&rec, sizeof(JitDumpCodeLoad), 1, fh);
+        fwrite(name, 1, name_len, fh);
+        fwrite((void *)code->func_ptr, 1, code->size, fh);
+        fflush(fh);
+        funlockfile(fh);
+    }
+    MVM_free(name);
+#endif
+}
+
+/* Closes the perf map and jitdump, if open. */
+void MVM_jit_perf_teardown(MVMInstance *instance) {
+#ifdef __linux__
+    if (instance->jit_perf_map) {
+        fclose(instance->jit_perf_map);
+        instance->jit_perf_map = NULL;
+    }
+    if (instance->jit_perf_dump) {
+        munmap(instance->jit_perf_dump_marker, sysconf(_SC_PAGESIZE));
+        fclose(instance->jit_perf_dump);
+        instance->jit_perf_dump = NULL;
+    }
+#endif
+}
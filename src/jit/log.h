@@ -1,2 +1,7 @@
 void MVM_jit_log(MVMThreadContext *tc, const char *fmt, ...) MVM_FORMAT(printf, 2, 3);
 void MVM_jit_log_bytecode(MVMThreadContext *tc, MVMJitCode *code);
+void MVM_jit_count_bail(MVMThreadContext *tc, MVMuint16 opcode);
+void MVM_jit_log_bail_census(MVMThreadContext *tc);
+void MVM_jit_perf_setup(MVMInstance *instance, const char *perf_map, const char *perf_dump_dir);
+void MVM_jit_log_perf(MVMThreadContext *tc, MVMJitCode *code);
+void MVM_jit_perf_teardown(MVMInstance *instance);
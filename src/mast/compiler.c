@@ -2,11 +2,12 @@
 #include "nodes.h"
 
 /* Some constants. */
-#define HEADER_SIZE                 92
-#define BYTECODE_VERSION            5
+#define HEADER_SIZE                 100
+#define BYTECODE_VERSION            6
 #define FRAME_HEADER_SIZE           (11 * 4 + 3 * 2)
 #define FRAME_HANDLER_SIZE          (4 * 4 + 2 * 2)
 #define FRAME_SLV_SIZE              (2 * 2 + 2 * 4)
+#define FRAME_CHECK_SIZE            (2 * 4)
 #define SC_DEP_SIZE                 4
 #define EXTOP_SIZE                  (4 + 8)
 #define SCDEP_HEADER_OFFSET         12
@@ -19,6 +20,7 @@
 #define ANNOTATION_HEADER_OFFSET    68
 #define HLL_NAME_HEADER_OFFSET      76
 #define SPECIAL_FRAME_HEADER_OFFSET 80
+#define FRAME_CHECK_HEADER_OFFSET   92
 #define EXTOP_BASE                  1024
 
 /* Frame flags. */
@@ -94,6 +96,9 @@ typedef struct {
     /* Number of annotations. */
     unsigned int num_annotations;
 
+    /* Number of findmeth instructions. */
+    unsigned int num_findmeth_sites;
+
     /* Handlers count and list. */
     unsigned int num_handlers;
     FrameHandler *handlers;
@@ -151,6 +156,10 @@ typedef struct {
     unsigned int  annotation_pos;
     unsigned int  annotation_alloc;
 
+    /* The frame checks segment; we know the size up front. */
+    char         *frame_check_seg;
+    unsigned int  frame_check_bytes;
+
     /* Current instruction info */
     const MVMOpInfo    *current_op_info;
 
@@ -279,6 +288,8 @@ static void cleanup_all(VM, WriterState *ws) {
         MVM_free(ws->bytecode_seg);
     if (ws->annotation_seg)
         MVM_free(ws->annotation_seg);
+    if (ws->frame_check_seg)
+        MVM_free(ws->frame_check_seg);
     HASH_ITER(hash_handle, ws->callsite_reuse_head, current, tmp, bucket_tmp) {
         MVM_free(current->identifier);
     }
@@ -758,6 +769,8 @@ static void compile_instruction(VM, WriterState *ws, MASTNode *node) {
             DIE(vm, "Invalid op specified in instruction %d", op);
         ws->current_op_info = info;
         ws->current_operand_idx = 0;
+        if (op == MVM_OP_findmeth)
+            ws->cur_frame->num_findmeth_sites++;
 
         /* Ensure argument count matches up. */
         if (info->num_operands != 0 && ELEMS(vm, o->operands) != info->num_operands) {
@@ -1137,6 +1150,9 @@ static void compile_frame(VM, WriterState *ws, MASTNode *node, unsigned short id
     /* initialize number of annotation */
     fs->num_annotations = 0;
 
+    /* initialize number of findmeth sites */
+    fs->num_findmeth_sites = 0;
+
     /* initialize number of handlers and handlers pointer */
     fs->num_handlers = 0;
     fs->handlers = NULL;
@@ -1306,6 +1322,14 @@ static void compile_frame(VM, WriterState *ws, MASTNode *node, unsigned short id
         DIE(vm, "Frame has %u unresolved labels", fs->unresolved_labels);
     }
 
+    /* Record a checksum of the bytecode and the number of findmeth sites,
+     * so the VM can skip validating the frame if it trusts us. */
+    write_int32(ws->frame_check_seg, ws->num_frames * FRAME_CHECK_SIZE,
+        MVM_bytecode_checksum((MVMuint8 *)ws->bytecode_seg + instructions_start,
+            ws->bytecode_pos - instructions_start));
+    write_int32(ws->frame_check_seg, ws->num_frames * FRAME_CHECK_SIZE + 4,
+        fs->num_findmeth_sites);
+
     /* Free the frame state. */
     cleanup_frame(vm, fs);
     ws->cur_frame = NULL;
@@ -1400,6 +1424,7 @@ static char * form_bytecode_output(VM, WriterState *ws, unsigned int *bytecode_s
     char         *output;
     unsigned int  string_heap_size;
     char         *string_heap;
+    MVMuint32     serialized_size;
     unsigned int  hll_str_idx;
 
     /* Store HLL name string, if any. */
@@ -1420,8 +1445,9 @@ static char * form_bytecode_output(VM, WriterState *ws, unsigned int *bytecode_s
     size += MVM_ALIGN_SECTION(ws->callsite_pos);
     size += MVM_ALIGN_SECTION(ws->bytecode_pos);
     size += MVM_ALIGN_SECTION(ws->annotation_pos);
-    if (vm->serialized)
-        size += MVM_ALIGN_SECTION(vm->serialized_size);
+    size += MVM_ALIGN_SECTION(ws->frame_check_bytes);
+    serialized_size = MVM_serialization_stashed_size(vm);
+    size += MVM_ALIGN_SECTION(serialized_size);
 
     /* Allocate space for the bytecode output. */
     output = (char *)MVM_malloc(size);
@@ -1467,14 +1493,11 @@ static char * form_bytecode_output(VM, WriterState *ws, unsigned int *bytecode_s
     }
 
     /* SC data. Write it if we have it. */
-    if (vm->serialized) {
+    if (serialized_size) {
         write_int32(output, SCDATA_HEADER_OFFSET, pos);
-        write_int32(output, SCDATA_HEADER_OFFSET + 4, vm->serialized_size);
-        memcpy(output + pos, vm->serialized, vm->serialized_size);
-        pos += MVM_ALIGN_SECTION(vm->serialized_size);
-        MVM_free(vm->serialized);
-        vm->serialized = NULL;
-        vm->serialized_size = 0;
+        write_int32(output, SCDATA_HEADER_OFFSET + 4, serialized_size);
+        MVM_serialization_write_stashed(vm, output + pos);
+        pos += MVM_ALIGN_SECTION(serialized_size);
     }
 
     /* Add bytecode section and its header entries (offset, length). */
@@ -1489,6 +1512,12 @@ static char * form_bytecode_output(VM, WriterState *ws, unsigned int *bytecode_s
     memcpy(output + pos, ws->annotation_seg, ws->annotation_pos);
     pos += MVM_ALIGN_SECTION(ws->annotation_pos);
 
+    /* Add frame checks section and its header entries. */
+    write_int32(output, FRAME_CHECK_HEADER_OFFSET, pos);
+    write_int32(output, FRAME_CHECK_HEADER_OFFSET + 4, ws->num_frames);
+    memcpy(output + pos, ws->frame_check_seg, ws->frame_check_bytes);
+    pos += MVM_ALIGN_SECTION(ws->frame_check_bytes);
+
     /* Add HLL and special frame indexes. */
     write_int32(output, HLL_NAME_HEADER_OFFSET, hll_str_idx);
     if (VM_OBJ_IS_NULL(ws->cu->main_frame))
@@ -1550,6 +1579,8 @@ char * MVM_mast_compile(VM, MASTNode *node, MASTNodeTypes *types, unsigned int *
     ws->annotation_pos   = 0;
     ws->annotation_alloc = 64 * ELEMS(vm, cu->frames);
     ws->annotation_seg   = (char *)MVM_malloc(ws->annotation_alloc);
+    ws->frame_check_bytes = ELEMS(vm, cu->frames) * FRAME_CHECK_SIZE;
+    ws->frame_check_seg  = ws->frame_check_bytes ? (char *)MVM_malloc(ws->frame_check_bytes) : NULL;
     ws->cu               = cu;
     ws->current_frame_idx= 0;
 
@@ -68,7 +68,7 @@ MVMInstance * MVM_vm_create_instance(void) {
     MVMInstance *instance;
     char *spesh_log, *spesh_nodelay, *spesh_disable, *spesh_inline_disable, *spesh_osr_disable;
     char *jit_log, *jit_disable, *jit_bytecode_dir;
-    char *dynvar_log;
+    char *dynvar_log, *gc_stats_log;
     int init_stat;
 
     /* Set up instance data structure. */
@@ -90,6 +90,15 @@ MVMInstance * MVM_vm_create_instance(void) {
     instance->permroot_descriptions = MVM_malloc(sizeof(char *) * instance->alloc_permroots);
     init_mutex(instance->mutex_permroots, "permanent roots");
 
+    /* Set up bytecode preloading. */
+    MVM_preload_init(instance);
+
+    /* Set up GC telemetry, and check if we've a file to dump it to. */
+    gc_stats_log = getenv("MVM_GC_STATS_LOG");
+    MVM_gc_stats_init(instance,
+        gc_stats_log && strlen(gc_stats_log) ? fopen_perhaps_with_pid(gc_stats_log, "a") : NULL,
+        getenv("MVM_GC_STATS_INTERVAL"));
+
     /* Create fixed size allocator. */
     instance->fsa = MVM_fixed_size_create(instance->main_thread);
 
@@ -222,6 +231,9 @@ MVMInstance * MVM_vm_create_instance(void) {
         MVM_free(bytecode_map_name);
     }
     instance->jit_seq_nr = 0;
+    MVM_jit_perf_setup(instance, getenv("MVM_JIT_PERF_MAP"), getenv("MVM_JIT_PERF_DUMP_DIR"));
+    MVM_jit_arena_init(instance);
+    instance->jit_bail_counts = MVM_calloc(MVM_OP_EXT_BASE + 1, sizeof(AO_t));
 
     /* Various kinds of debugging that can be enabled. */
     dynvar_log = getenv("MVM_DYNVAR_LOG");
@@ -234,6 +246,7 @@ MVMInstance * MVM_vm_create_instance(void) {
     else
         instance->dynvar_log_fh = NULL;
     instance->nfa_debug_enabled = getenv("MVM_NFA_DEB") ? 1 : 0;
+    instance->trust_bytecode = getenv("MVM_TRUST_BYTECODE") ? 1 : 0;
     if (getenv("MVM_CROSS_THREAD_WRITE_LOG")) {
         instance->cross_thread_write_logging = 1;
         instance->cross_thread_write_logging_include_locked =
@@ -339,8 +352,11 @@ void MVM_vm_exit(MVMInstance *instance) {
     /* Close any spesh or jit log. */
     if (instance->spesh_log_fh)
         fclose(instance->spesh_log_fh);
-    if (instance->jit_log_fh)
+    if (instance->jit_log_fh) {
+        MVM_jit_log_bail_census(instance->main_thread);
         fclose(instance->jit_log_fh);
+    }
+    MVM_jit_perf_teardown(instance);
     if (instance->jit_bytecode_map)
         fclose(instance->jit_bytecode_map);
     if (instance->dynvar_log_fh) {
@@ -449,10 +465,25 @@ void MVM_vm_destroy_instance(MVMInstance *instance) {
 
     /* Clean up spesh install mutex and close any log. */
     uv_mutex_destroy(&instance->mutex_spesh_install);
+    MVM_jit_arena_destroy(instance);
+
+    /* Stop and clean up the sampling and allocation profilers. */
+    MVM_profile_sampling_destroy(instance);
+    MVM_profile_allocations_destroy(instance);
+
+    /* Clean up GC telemetry, writing a last line to its log. */
+    MVM_gc_stats_destroy(instance);
+
+    /* Wait for and clean up preloading. */
+    MVM_preload_destroy(instance);
+    MVM_free(instance->jit_bail_counts);
     if (instance->spesh_log_fh)
         fclose(instance->spesh_log_fh);
-    if (instance->jit_log_fh)
+    if (instance->jit_log_fh) {
+        MVM_jit_log_bail_census(instance->main_thread);
         fclose(instance->jit_log_fh);
+    }
+    MVM_jit_perf_teardown(instance);
 
     /* Clean up NFG. */
     uv_mutex_destroy(&instance->nfg->update_mutex);
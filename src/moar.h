@@ -126,6 +126,7 @@ MVM_PUBLIC const MVMint32 MVM_jit_support(void);
 #include "6model/serialization.h"
 #include "6model/parametric.h"
 #include "core/compunit.h"
+#include "core/preload.h"
 #include "gc/gen2.h"
 #include "gc/allocation.h"
 #include "gc/worklist.h"
@@ -134,6 +135,7 @@ MVM_PUBLIC const MVMint32 MVM_jit_support(void);
 #include "gc/roots.h"
 #include "gc/objectid.h"
 #include "gc/finalize.h"
+#include "gc/stats.h"
 #include "spesh/dump.h"
 #include "spesh/graph.h"
 #include "spesh/codegen.h"
@@ -174,17 +176,22 @@ MVM_PUBLIC const MVMint32 MVM_jit_support(void);
 #include "io/signals.h"
 #include "io/asyncsocket.h"
 #include "io/asyncsocketudp.h"
+#include "io/copy.h"
+#include "io/asyncfile.h"
 #include "math/bigintops.h"
 #include "mast/driver.h"
 #include "core/intcache.h"
 #include "core/fixedsizealloc.h"
 #include "jit/graph.h"
 #include "jit/compile.h"
+#include "jit/arena.h"
 #include "jit/log.h"
 #include "profiler/instrument.h"
 #include "profiler/log.h"
 #include "profiler/profile.h"
 #include "profiler/heapsnapshot.h"
+#include "profiler/sampling.h"
+#include "profiler/allocations.h"
 #include "instrument/crossthreadwrite.h"
 
 MVMObject *MVM_backend_config(MVMThreadContext *tc);
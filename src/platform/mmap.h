@@ -5,5 +5,7 @@
 void *MVM_platform_alloc_pages(size_t size, int mode);
 int MVM_platform_set_page_mode(void * block, size_t size, int mode);
 int MVM_platform_free_pages(void *block, size_t size);
+int MVM_platform_alloc_dual_pages(size_t size, void **writable, void **executable);
+int MVM_platform_free_dual_pages(void *writable, void *executable, size_t size);
 void *MVM_platform_map_file(int fd, void **handle, size_t size, int writable);
 int MVM_platform_unmap_file(void *block, void *handle, size_t size);
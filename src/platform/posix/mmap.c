@@ -3,6 +3,10 @@
 #include "moar.h"
 #include "platform/mmap.h"
 #include <errno.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 /* MAP_ANONYMOUS is Linux, MAP_ANON is BSD */
 #ifndef MVM_MAP_ANON
@@ -60,6 +64,48 @@ int MVM_platform_free_pages(void *block, size_t size)
     return munmap(block, size) == 0;
 }
 
+/* Allocates memory that is mapped twice, once writable and once executable,
+ * so code can be written to it without any page ever being both. Returns 0
+ * if that isn't possible on this platform. */
+int MVM_platform_alloc_dual_pages(size_t size, void **writable, void **executable)
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+    void *rw, *rx;
+    int fd = (int)syscall(SYS_memfd_create, "moar-jit", 1 /* MFD_CLOEXEC */);
+    if (fd < 0)
+        return 0;
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return 0;
+    }
+    rw = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    rx = mmap(NULL, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+    close(fd);
+    if (rw == MAP_FAILED || rx == MAP_FAILED) {
+        if (rw != MAP_FAILED)
+            munmap(rw, size);
+        if (rx != MAP_FAILED)
+            munmap(rx, size);
+        return 0;
+    }
+    *writable   = rw;
+    *executable = rx;
+    return 1;
+#else
+    (void)size;
+    (void)writable;
+    (void)executable;
+    return 0;
+#endif
+}
+
+int MVM_platform_free_dual_pages(void *writable, void *executable, size_t size)
+{
+    int unmapped_rw = munmap(writable, size) == 0;
+    int unmapped_rx = munmap(executable, size) == 0;
+    return unmapped_rw && unmapped_rx;
+}
+
 void *MVM_platform_map_file(int fd, void **handle, size_t size, int writable)
 {
     void *block = mmap(NULL, size,
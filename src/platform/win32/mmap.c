@@ -42,6 +42,43 @@ int MVM_platform_free_pages(void *pages, size_t size)
     return VirtualFree(pages, 0, MEM_RELEASE);
 }
 
+int MVM_platform_alloc_dual_pages(size_t size, void **writable, void **executable)
+{
+    LARGE_INTEGER li;
+    HANDLE mapping;
+    void *rw, *rx;
+
+    li.QuadPart = size;
+    mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_EXECUTE_READWRITE,
+        li.HighPart, li.LowPart, NULL);
+    if (mapping == NULL)
+        return 0;
+
+    rw = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
+    rx = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_EXECUTE, 0, 0, size);
+    /* The views keep the mapping alive. */
+    CloseHandle(mapping);
+    if (rw == NULL || rx == NULL) {
+        if (rw)
+            UnmapViewOfFile(rw);
+        if (rx)
+            UnmapViewOfFile(rx);
+        return 0;
+    }
+
+    *writable   = rw;
+    *executable = rx;
+    return 1;
+}
+
+int MVM_platform_free_dual_pages(void *writable, void *executable, size_t size)
+{
+    BOOL unmapped_rw = UnmapViewOfFile(writable);
+    BOOL unmapped_rx = UnmapViewOfFile(executable);
+    (void)size;
+    return unmapped_rw && unmapped_rx;
+}
+
 void *MVM_platform_map_file(int fd, void **handle, size_t size, int writable)
 {
     HANDLE fh, mapping;
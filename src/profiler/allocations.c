@@ -0,0 +1,352 @@
+#include "moar.h"
+
+/* Is allocation profiling currently turned on? */
+MVMint32 MVM_profile_allocations_profiling(MVMThreadContext *tc) {
+    return MVM_load(&tc->instance->alloc_sample_interval) != 0;
+}
+
+/* Starts allocation profiling. The configuration may give the interval, in
+ * kilobytes of nursery allocation between samples. */
+void MVM_profile_allocations_start(MVMThreadContext *tc, MVMObject *config) {
+    MVMInstance      *instance = tc->instance;
+    MVMAllocProfiler *ap       = instance->alloc_profiler;
+    MVMint64          interval = MVM_ALLOC_PROFILE_DEFAULT_INTERVAL;
+
+    if (MVM_repr_exists_key(tc, config, instance->str_consts.interval)) {
+        MVMint64 kb = MVM_repr_get_int(tc,
+            MVM_repr_at_key_o(tc, config, instance->str_consts.interval));
+        if (kb <= 0)
+            MVM_exception_throw_adhoc(tc,
+                "Allocation profiler interval must be positive, got %"PRId64, kb);
+        interval = kb * 1024;
+    }
+
+    if (!ap) {
+        ap = MVM_calloc(1, sizeof(MVMAllocProfiler));
+        uv_mutex_init(&ap->mutex);
+        instance->alloc_profiler = ap;
+    }
+    ap->samples  = 0;
+    ap->dropped  = 0;
+    ap->interval = (MVMuint64)interval;
+    MVM_store(&instance->alloc_sample_interval, interval);
+}
+
+/* Called by the allocator when the countdown to the next sample runs out;
+ * records the allocation and the stack it's being made from. */
+void MVM_profile_allocations_sample(MVMThreadContext *tc, void *allocated, size_t size) {
+    MVMint64               interval = (MVMint64)MVM_load(&tc->instance->alloc_sample_interval);
+    MVMAllocProfiler      *ap       = tc->instance->alloc_profiler;
+    MVMAllocProfileThread *apt      = tc->alloc_samples;
+    MVMAllocSample        *s;
+    MVMFrame              *f;
+
+    /* Set the countdown to the next sample. */
+    tc->alloc_sample_countdown += interval;
+    if (tc->alloc_sample_countdown <= 0)
+        tc->alloc_sample_countdown = interval;
+    if (!interval || !ap)
+        return;
+
+    /* Set up our samples list the first time, and try to make room in it
+     * if it's full. */
+    if (!apt) {
+        apt = MVM_calloc(1, sizeof(MVMAllocProfileThread));
+        uv_mutex_init(&apt->mutex);
+        apt->samples = MVM_malloc(MVM_ALLOC_PROFILE_MAX_SAMPLES * sizeof(MVMAllocSample));
+        tc->alloc_samples = apt;
+    }
+    if (apt->num_samples == MVM_ALLOC_PROFILE_MAX_SAMPLES)
+        MVM_profile_allocations_flush(tc, tc, 0);
+
+    uv_mutex_lock(&apt->mutex);
+    if (!MVM_load(&tc->instance->alloc_sample_interval)) {
+        uv_mutex_unlock(&apt->mutex);
+        return;
+    }
+    if (apt->num_samples == MVM_ALLOC_PROFILE_MAX_SAMPLES) {
+        /* Everything outstanding is still being tracked. */
+        uv_mutex_lock(&ap->mutex);
+        ap->dropped++;
+        uv_mutex_unlock(&ap->mutex);
+        uv_mutex_unlock(&apt->mutex);
+        return;
+    }
+    s        = &(apt->samples[apt->num_samples++]);
+    s->obj   = (MVMCollectable *)allocated;
+    s->st    = NULL;
+    s->size  = (MVMuint32)size;
+    s->depth = 0;
+    s->state = MVM_ALLOC_SAMPLE_TRACKING;
+    s->kind  = MVM_ALLOC_KIND_UNKNOWN;
+    for (f = tc->cur_frame; f && s->depth < MVM_ALLOC_PROFILE_DEPTH; f = f->caller)
+        s->frames[s->depth++] = f->static_info;
+    uv_mutex_unlock(&apt->mutex);
+}
+
+/* Marks the STables and static frames of the thread's samples. The first
+ * time we see a sample, its header has surely been set up, so we can find
+ * out what kind of thing it is and its STable. The sampled collectables
+ * themselves are not marked. */
+void MVM_profile_allocations_mark_data(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMAllocProfileThread *apt = tc->alloc_samples;
+    MVMuint32 i, j;
+    if (!apt)
+        return;
+    for (i = 0; i < apt->num_samples; i++) {
+        MVMAllocSample *s = &(apt->samples[i]);
+        if (s->state == MVM_ALLOC_SAMPLE_TRACKING && s->kind == MVM_ALLOC_KIND_UNKNOWN) {
+            MVMCollectable *c = s->obj;
+            if (c->flags & MVM_CF_STABLE) {
+                s->kind = MVM_ALLOC_KIND_STABLE;
+            }
+            else {
+                s->kind = c->flags & MVM_CF_TYPE_OBJECT
+                    ? MVM_ALLOC_KIND_TYPE_OBJECT
+                    : MVM_ALLOC_KIND_OBJECT;
+                s->st = ((MVMObject *)c)->st;
+            }
+        }
+        if (s->st)
+            MVM_gc_worklist_add(tc, worklist, &(s->st));
+        for (j = 0; j < s->depth; j++)
+            MVM_gc_worklist_add(tc, worklist, &(s->frames[j]));
+    }
+}
+
+/* Called once a nursery collection's marking is done, before the fromspace
+ * is cleared up. Sampled collectables that were not copied have died; ones
+ * copied out of the nursery have been promoted to the second generation and
+ * count as retained. */
+void MVM_profile_allocations_update(MVMThreadContext *tc) {
+    MVMAllocProfileThread *apt = tc->alloc_samples;
+    char *nursery_start = (char *)tc->nursery_tospace;
+    char *nursery_end   = nursery_start + MVM_NURSERY_SIZE;
+    MVMuint32 i;
+    if (!apt)
+        return;
+    uv_mutex_lock(&apt->mutex);
+    for (i = 0; i < apt->num_samples; i++) {
+        MVMAllocSample *s = &(apt->samples[i]);
+        MVMCollectable *c = s->obj;
+        if (s->state != MVM_ALLOC_SAMPLE_TRACKING)
+            continue;
+        if (c->flags & MVM_CF_FORWARDER_VALID) {
+            char *moved = (char *)c->sc_forward_u.forwarder;
+            if (moved >= nursery_start && moved < nursery_end) {
+                s->obj = (MVMCollectable *)moved;
+            }
+            else {
+                s->obj   = NULL;
+                s->state = MVM_ALLOC_SAMPLE_RETAINED;
+            }
+        }
+        else {
+            s->obj   = NULL;
+            s->state = MVM_ALLOC_SAMPLE_DIED;
+        }
+    }
+    uv_mutex_unlock(&apt->mutex);
+}
+
+/* Gets the rendered name of a static frame, caching it for the rest of the
+ * flush; no GC can run in that time, so the address is a fine key. */
+static char * frame_name(MVMThreadContext *tc, MVMSamplingName **cache, MVMStaticFrame *sf) {
+    MVMSamplingName *entry;
+    HASH_FIND(hash_handle, *cache, &sf, sizeof(MVMStaticFrame *), entry);
+    if (!entry) {
+        entry       = MVM_malloc(sizeof(MVMSamplingName));
+        entry->sf   = sf;
+        entry->name = MVM_profile_sampling_render_name(tc, sf);
+        HASH_ADD_KEYPTR(hash_handle, *cache, &(entry->sf), sizeof(MVMStaticFrame *), entry);
+    }
+    return entry->name;
+}
+
+/* Builds the key of the site a sample was taken at: the name of the type,
+ * a tab, and the stack with the outermost frame first. */
+static char * site_key(MVMThreadContext *tc, MVMSamplingName **cache, MVMAllocSample *s) {
+    const char *names[MVM_ALLOC_PROFILE_DEPTH];
+    const char *type;
+    const char *suffix = "";
+    size_t      len, pos;
+    char       *key;
+    MVMint32    i;
+
+    switch (s->kind) {
+        case MVM_ALLOC_KIND_STABLE:
+            type = "STable";
+            break;
+        case MVM_ALLOC_KIND_TYPE_OBJECT:
+            suffix = " (type object)";
+            /* Fall through. */
+        case MVM_ALLOC_KIND_OBJECT:
+            type = s->st->debug_name ? s->st->debug_name : "<anon>";
+            break;
+        default:
+            type = "<unknown>";
+    }
+
+    len = strlen(type) + strlen(suffix) + 2;
+    for (i = 0; i < s->depth; i++) {
+        names[i] = frame_name(tc, cache, s->frames[i]);
+        len += strlen(names[i]) + 1;
+    }
+    key = MVM_malloc(len);
+    pos = sprintf(key, "%s%s\t", type, suffix);
+    for (i = s->depth - 1; i >= 0; i--)
+        pos += sprintf(key + pos, i ? "%s;" : "%s", names[i]);
+    return key;
+}
+
+/* Adds a finished sample to its site's totals, taking ownership of the
+ * key. */
+static void count_sample(MVMThreadContext *tc, MVMAllocProfiler *ap, char *key,
+                         MVMAllocSample *s) {
+    MVMAllocSite *site;
+    size_t len = strlen(key);
+    uv_mutex_lock(&ap->mutex);
+    HASH_FIND(hash_handle, ap->sites, key, len, site);
+    if (site) {
+        MVM_free(key);
+    }
+    else {
+        site = MVM_calloc(1, sizeof(MVMAllocSite));
+        site->key = key;
+        HASH_ADD_KEYPTR(hash_handle, ap->sites, site->key, len, site);
+    }
+    site->samples++;
+    if (s->state == MVM_ALLOC_SAMPLE_RETAINED)
+        site->retained++;
+    ap->samples++;
+    uv_mutex_unlock(&ap->mutex);
+}
+
+/* Folds a thread's finished samples into the per-site totals, keeping the
+ * ones still being tracked, unless all is set (when profiling ends, or the
+ * thread does), in which case they count as not retained. */
+void MVM_profile_allocations_flush(MVMThreadContext *tc, MVMThreadContext *owner, MVMint32 all) {
+    MVMAllocProfiler      *ap    = tc->instance->alloc_profiler;
+    MVMAllocProfileThread *apt   = owner->alloc_samples;
+    MVMSamplingName       *cache = NULL;
+    MVMSamplingName       *entry, *tmp;
+    unsigned               bucket_tmp;
+    MVMuint32              i, kept = 0;
+    if (!ap || !apt)
+        return;
+
+    uv_mutex_lock(&apt->mutex);
+    for (i = 0; i < apt->num_samples; i++) {
+        MVMAllocSample *s = &(apt->samples[i]);
+        if (s->state == MVM_ALLOC_SAMPLE_TRACKING && !all) {
+            if (kept != i)
+                apt->samples[kept] = *s;
+            kept++;
+        }
+        else {
+            count_sample(tc, ap, site_key(tc, &cache, s), s);
+        }
+    }
+    apt->num_samples = kept;
+    uv_mutex_unlock(&apt->mutex);
+
+    HASH_ITER(hash_handle, cache, entry, tmp, bucket_tmp) {
+        MVM_free(entry->name);
+    }
+    if (cache)
+        MVM_HASH_DESTROY(hash_handle, MVMSamplingName, cache);
+}
+
+/* Frees a thread's samples, when the thread is destroyed. */
+void MVM_profile_allocations_destroy_thread(MVMThreadContext *tc) {
+    MVMAllocProfileThread *apt = tc->alloc_samples;
+    if (apt) {
+        uv_mutex_destroy(&apt->mutex);
+        MVM_free(apt->samples);
+        MVM_free(apt);
+        tc->alloc_samples = NULL;
+    }
+}
+
+/* Frees the per-site totals. */
+static void free_sites(MVMAllocProfiler *ap) {
+    MVMAllocSite *site, *tmp;
+    unsigned bucket_tmp;
+    HASH_ITER(hash_handle, ap->sites, site, tmp, bucket_tmp) {
+        MVM_free(site->key);
+    }
+    if (ap->sites)
+        MVM_HASH_DESTROY(hash_handle, MVMAllocSite, ap->sites);
+    ap->sites = NULL;
+}
+
+/* Turns the per-site totals into a hash of overall counts and an array of
+ * sites. Byte counts are estimates, from the number of samples times the
+ * sampling interval. */
+#define vmstr(tc, cstr) MVM_string_utf8_decode(tc, tc->instance->VMString, cstr, strlen(cstr))
+#define box_i(tc, i) MVM_repr_box_int(tc, MVM_hll_current(tc)->int_box_type, i)
+#define box_s(tc, str) MVM_repr_box_str(tc, MVM_hll_current(tc)->str_box_type, str)
+static MVMObject * sites_to_mvm_object(MVMThreadContext *tc, MVMAllocProfiler *ap) {
+    MVMObject *result, *sites;
+    MVMAllocSite *site, *tmp;
+    unsigned bucket_tmp;
+
+    /* Allocate in gen2, so as not to trigger GC. */
+    MVM_gc_allocate_gen2_default_set(tc);
+    result = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+    sites  = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_array_type);
+    HASH_ITER(hash_handle, ap->sites, site, tmp, bucket_tmp) {
+        MVMObject *site_hash = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+        char      *tab       = strchr(site->key, '\t');
+        MVM_repr_bind_key_o(tc, site_hash, vmstr(tc, "type"), box_s(tc,
+            MVM_string_utf8_decode(tc, tc->instance->VMString, site->key, tab - site->key)));
+        MVM_repr_bind_key_o(tc, site_hash, vmstr(tc, "stack"), box_s(tc, vmstr(tc, tab + 1)));
+        MVM_repr_bind_key_o(tc, site_hash, vmstr(tc, "samples"), box_i(tc, site->samples));
+        MVM_repr_bind_key_o(tc, site_hash, vmstr(tc, "retained_samples"), box_i(tc, site->retained));
+        MVM_repr_bind_key_o(tc, site_hash, vmstr(tc, "allocated"),
+            box_i(tc, site->samples * ap->interval));
+        MVM_repr_bind_key_o(tc, site_hash, vmstr(tc, "retained"),
+            box_i(tc, site->retained * ap->interval));
+        MVM_repr_push_o(tc, sites, site_hash);
+    }
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "sites"), sites);
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "samples"), box_i(tc, ap->samples));
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "dropped"), box_i(tc, ap->dropped));
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "interval"), box_i(tc, ap->interval));
+    MVM_gc_allocate_gen2_default_clear(tc);
+    return result;
+}
+
+/* Ends allocation profiling, folding in every thread's samples, and returns
+ * the results. */
+MVMObject * MVM_profile_allocations_end(MVMThreadContext *tc) {
+    MVMAllocProfiler *ap = tc->instance->alloc_profiler;
+    MVMThread        *thread;
+    MVMObject        *result;
+
+    MVM_store(&tc->instance->alloc_sample_interval, 0);
+
+    /* No GC run can start while we walk the threads, so their contexts stay
+     * around. Threads that exited already flushed their samples. */
+    thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    while (thread) {
+        if (MVM_load(&thread->body.stage) == MVM_thread_stage_started && thread->body.tc)
+            MVM_profile_allocations_flush(tc, thread->body.tc, 1);
+        thread = thread->body.next;
+    }
+
+    result = sites_to_mvm_object(tc, ap);
+    free_sites(ap);
+    return result;
+}
+
+/* Cleans up the allocation profiler at instance shutdown. */
+void MVM_profile_allocations_destroy(MVMInstance *instance) {
+    MVMAllocProfiler *ap = instance->alloc_profiler;
+    if (ap) {
+        free_sites(ap);
+        uv_mutex_destroy(&ap->mutex);
+        MVM_free(ap);
+        instance->alloc_profiler = NULL;
+    }
+}
@@ -0,0 +1,94 @@
+/* The allocation profiler. Every so many bytes of nursery allocation, a
+ * thread records the allocation's size and the static frames on its stack.
+ * The sampled object is then followed, without keeping it alive, through
+ * nursery collections until it either dies or is promoted to the second
+ * generation, at which point it counts as retained. Finished samples are
+ * totalled up per allocation site: the type allocated and the stack it was
+ * allocated from. */
+
+/* Default number of bytes of nursery allocation between samples. */
+#define MVM_ALLOC_PROFILE_DEFAULT_INTERVAL  (32 * 1024)
+
+/* How many frames of the stack we record for a sample. */
+#define MVM_ALLOC_PROFILE_DEPTH             16
+
+/* Number of samples a thread may have outstanding. */
+#define MVM_ALLOC_PROFILE_MAX_SAMPLES       4096
+
+/* States of a sample. */
+#define MVM_ALLOC_SAMPLE_TRACKING           0
+#define MVM_ALLOC_SAMPLE_DIED               1
+#define MVM_ALLOC_SAMPLE_RETAINED           2
+
+/* Kinds of sampled collectable; we only know once the allocation has been
+ * set up, which is certainly the case by the next GC run. */
+#define MVM_ALLOC_KIND_UNKNOWN              0
+#define MVM_ALLOC_KIND_OBJECT               1
+#define MVM_ALLOC_KIND_TYPE_OBJECT          2
+#define MVM_ALLOC_KIND_STABLE               3
+
+/* A sampled allocation. */
+struct MVMAllocSample {
+    /* The sampled collectable while we're tracking it. This is not marked,
+     * so that sampling doesn't extend its lifetime; it's updated when the
+     * GC moves it. */
+    MVMCollectable *obj;
+
+    /* Its STable, filled out at the first GC after the allocation. */
+    MVMSTable *st;
+
+    /* Static frames on the stack at allocation, innermost first. */
+    MVMStaticFrame *frames[MVM_ALLOC_PROFILE_DEPTH];
+
+    MVMuint32 size;
+    MVMuint16 depth;
+    MVMuint8  state;
+    MVMuint8  kind;
+};
+
+/* A thread's outstanding samples. The lock is held by the thread while it
+ * adds samples, by the GC while updating them, and by whoever folds them
+ * into the per-site totals. */
+struct MVMAllocProfileThread {
+    uv_mutex_t mutex;
+    MVMAllocSample *samples;
+    MVMuint32 num_samples;
+};
+
+/* Totals for an allocation site, keyed on the type name followed by a tab
+ * and the folded stack. Each sample stands for the sampling interval's worth
+ * of bytes allocated. */
+struct MVMAllocSite {
+    char *key;
+    MVMuint64 samples;
+    MVMuint64 retained;
+    UT_hash_handle hash_handle;
+};
+
+/* Allocation profiler state, hung off the instance. Like the sampling
+ * profiler, it lives as long as the instance once created. */
+struct MVMAllocProfiler {
+    /* Protects everything here. */
+    uv_mutex_t mutex;
+
+    /* Totals per allocation site. */
+    MVMAllocSite *sites;
+
+    /* Number of samples taken, and number dropped because a thread had too
+     * many outstanding. */
+    MVMuint64 samples;
+    MVMuint64 dropped;
+
+    /* The sampling interval in bytes, kept for the results. */
+    MVMuint64 interval;
+};
+
+void MVM_profile_allocations_start(MVMThreadContext *tc, MVMObject *config);
+MVMint32 MVM_profile_allocations_profiling(MVMThreadContext *tc);
+void MVM_profile_allocations_sample(MVMThreadContext *tc, void *allocated, size_t size);
+void MVM_profile_allocations_mark_data(MVMThreadContext *tc, MVMGCWorklist *worklist);
+void MVM_profile_allocations_update(MVMThreadContext *tc);
+void MVM_profile_allocations_flush(MVMThreadContext *tc, MVMThreadContext *owner, MVMint32 all);
+void MVM_profile_allocations_destroy_thread(MVMThreadContext *tc);
+MVMObject * MVM_profile_allocations_end(MVMThreadContext *tc);
+void MVM_profile_allocations_destroy(MVMInstance *instance);
@@ -5,9 +5,141 @@ MVMint32 MVM_profile_heap_profiling(MVMThreadContext *tc) {
     return tc->instance->heap_snapshots != NULL;
 }
 
-/* Start heap profiling. */
+/* Writing of the binary snapshot format (described in heapsnapshot.h). We
+ * are called at GC time and so can't throw, so failing to write is fatal. */
+static void write_bytes(MVMHeapSnapshotCollection *col, const void *data, size_t size) {
+    if (size && fwrite(data, 1, size, col->fh) != size)
+        MVM_panic(1, "Failed to write heap snapshot to '%s': %s", col->path, strerror(errno));
+}
+static void write_uint(MVMHeapSnapshotCollection *col, MVMuint64 value, size_t width) {
+    unsigned char buffer[8];
+    size_t i;
+    for (i = 0; i < width; i++)
+        buffer[i] = (value >> (8 * i)) & 0xFF;
+    write_bytes(col, buffer, width);
+}
+static void write_block_start(MVMHeapSnapshotCollection *col, const char *tag, MVMuint64 size) {
+    write_bytes(col, tag, 4);
+    write_uint(col, size, 8);
+}
+
+/* Writes one field from each of a table of structs, as a column. */
+static void write_column(MVMHeapSnapshotCollection *col, void *table, size_t stride,
+                         size_t offset, size_t width, MVMuint64 count) {
+    unsigned char buffer[8192];
+    size_t used = 0;
+    MVMuint64 i;
+    for (i = 0; i < count; i++) {
+        char      *field = (char *)table + i * stride + offset;
+        MVMuint64  value;
+        size_t     b;
+        switch (width) {
+            case 2:  value = *((MVMuint16 *)field); break;
+            case 4:  value = *((MVMuint32 *)field); break;
+            default: value = *((MVMuint64 *)field); break;
+        }
+        if (used + width > sizeof(buffer)) {
+            write_bytes(col, buffer, used);
+            used = 0;
+        }
+        for (b = 0; b < width; b++)
+            buffer[used++] = (value >> (8 * b)) & 0xFF;
+    }
+    write_bytes(col, buffer, used);
+}
+#define WRITE_COLUMN(col, table, type, field, count) \
+    write_column((col), (table), sizeof(type), offsetof(type, field), \
+        sizeof(((type *)0)->field), (count))
+
+/* Writes out the strings, types and static frames we didn't yet write. */
+static void write_new_tables(MVMHeapSnapshotCollection *col) {
+    MVMuint64 first, count, size, i;
+
+    first = col->strings_written;
+    count = col->num_strings - first;
+    if (count) {
+        size = 16;
+        for (i = first; i < col->num_strings; i++)
+            size += 4 + strlen(col->strings[i]);
+        write_block_start(col, "STRS", size);
+        write_uint(col, first, 8);
+        write_uint(col, count, 8);
+        for (i = first; i < col->num_strings; i++) {
+            size_t len = strlen(col->strings[i]);
+            write_uint(col, len, 4);
+            write_bytes(col, col->strings[i], len);
+        }
+        col->strings_written = col->num_strings;
+    }
+
+    first = col->types_written;
+    count = col->num_types - first;
+    if (count) {
+        write_block_start(col, "TYPS", 16 + 16 * count);
+        write_uint(col, first, 8);
+        write_uint(col, count, 8);
+        WRITE_COLUMN(col, col->types + first, MVMHeapSnapshotType, repr_name, count);
+        WRITE_COLUMN(col, col->types + first, MVMHeapSnapshotType, type_name, count);
+        col->types_written = col->num_types;
+    }
+
+    first = col->static_frames_written;
+    count = col->num_static_frames - first;
+    if (count) {
+        MVMHeapSnapshotStaticFrame *sfs = col->static_frames + first;
+        write_block_start(col, "FRMS", 16 + 32 * count);
+        write_uint(col, first, 8);
+        write_uint(col, count, 8);
+        WRITE_COLUMN(col, sfs, MVMHeapSnapshotStaticFrame, name, count);
+        WRITE_COLUMN(col, sfs, MVMHeapSnapshotStaticFrame, cuid, count);
+        WRITE_COLUMN(col, sfs, MVMHeapSnapshotStaticFrame, line, count);
+        WRITE_COLUMN(col, sfs, MVMHeapSnapshotStaticFrame, file, count);
+        col->static_frames_written = col->num_static_frames;
+    }
+}
+
+/* Writes out a snapshot, preceded by any table entries it needs. */
+static void write_snapshot(MVMHeapSnapshotCollection *col, MVMHeapSnapshot *hs,
+                           MVMuint64 snapshot_idx) {
+    MVMuint64 nc = hs->num_collectables;
+    MVMuint64 nr = hs->num_references;
+    write_new_tables(col);
+    write_block_start(col, "SNAP", 24 + 28 * nc + 16 * nr);
+    write_uint(col, snapshot_idx, 8);
+    write_uint(col, nc, 8);
+    write_uint(col, nr, 8);
+    WRITE_COLUMN(col, hs->collectables, MVMHeapSnapshotCollectable, kind, nc);
+    WRITE_COLUMN(col, hs->collectables, MVMHeapSnapshotCollectable, collectable_size, nc);
+    WRITE_COLUMN(col, hs->collectables, MVMHeapSnapshotCollectable, type_or_frame_index, nc);
+    WRITE_COLUMN(col, hs->collectables, MVMHeapSnapshotCollectable, num_refs, nc);
+    WRITE_COLUMN(col, hs->collectables, MVMHeapSnapshotCollectable, refs_start, nc);
+    WRITE_COLUMN(col, hs->collectables, MVMHeapSnapshotCollectable, unmanaged_size, nc);
+    WRITE_COLUMN(col, hs->references, MVMHeapSnapshotReference, description, nr);
+    WRITE_COLUMN(col, hs->references, MVMHeapSnapshotReference, collectable_index, nr);
+    fflush(col->fh);
+}
+
+/* Start heap profiling. If a path is given in the configuration, snapshots
+ * are streamed to that file as they are taken, rather than being kept in
+ * memory until the end. */
 void MVM_profile_heap_start(MVMThreadContext *tc, MVMObject *config) {
-    tc->instance->heap_snapshots = MVM_calloc(1, sizeof(MVMHeapSnapshotCollection));
+    MVMHeapSnapshotCollection *col = MVM_calloc(1, sizeof(MVMHeapSnapshotCollection));
+    if (MVM_repr_exists_key(tc, config, tc->instance->str_consts.path)) {
+        MVMString *path = MVM_repr_get_str(tc,
+            MVM_repr_at_key_o(tc, config, tc->instance->str_consts.path));
+        col->path = MVM_string_utf8_c8_encode_C_string(tc, path);
+        col->fh   = fopen(col->path, "wb");
+        if (!col->fh) {
+            char *waste[] = { col->path, NULL };
+            MVM_free(col);
+            MVM_exception_throw_adhoc_free(tc, waste, "Could not open heap snapshot file '%s': %s",
+                waste[0], strerror(errno));
+        }
+        write_bytes(col, MVM_HEAPSNAPSHOT_MAGIC, 8);
+        write_uint(col, MVM_HEAPSNAPSHOT_VERSION, 4);
+        write_uint(col, 0, 4);
+    }
+    tc->instance->heap_snapshots = col;
 }
 
 /* Grows storage if it's full, zeroing the extension. Assumes it's only being
@@ -26,16 +158,15 @@ static void grow_storage(void **store, MVMuint64 *num, MVMuint64 *alloc, size_t
 #define STR_MODE_DUP    2
 static MVMuint64 get_string_index(MVMThreadContext *tc, MVMHeapSnapshotState *ss,
                                    char *str, char str_mode) {
-     MVMuint64 i;
+    MVMHeapSnapshotCollection  *col = ss->col;
+    MVMHeapSnapshotStringEntry *entry;
+    char                       *stored;
 
-     /* Add a lookup hash here if it gets to be a hotspot. */
-     MVMHeapSnapshotCollection *col = ss->col;
-     for (i = 0; i < col->num_strings; i++) {
-        if (strcmp(col->strings[i], str) == 0) {
-            if (str_mode == STR_MODE_OWN)
-                MVM_free(str);
-            return i;
-        }
+    HASH_FIND(hash_handle, col->strings_hash, str, strlen(str), entry);
+    if (entry) {
+        if (str_mode == STR_MODE_OWN)
+            MVM_free(str);
+        return entry->idx;
     }
 
     grow_storage((void **)&(col->strings), &(col->num_strings),
@@ -44,9 +175,33 @@ static MVMuint64 get_string_index(MVMThreadContext *tc, MVMHeapSnapshotState *ss
         &(col->alloc_strings_free), sizeof(char));
     col->strings_free[col->num_strings_free] = str_mode != STR_MODE_CONST;
     col->num_strings_free++;
-    col->strings[col->num_strings] = str_mode == STR_MODE_DUP ? strdup(str) : str;
+    stored = str_mode == STR_MODE_DUP ? strdup(str) : str;
+    col->strings[col->num_strings] = stored;
+
+    /* The hash is keyed on the string we keep, which lives as long as the
+     * collection. */
+    entry = MVM_malloc(sizeof(MVMHeapSnapshotStringEntry));
+    entry->idx = col->num_strings;
+    HASH_ADD_KEYPTR(hash_handle, col->strings_hash, stored, strlen(stored), entry);
     return col->num_strings++;
- }
+}
+
+/* Looks up a type or static frame table index by the values describing it,
+ * returning 1 if found. Otherwise, records the index it will be added at. */
+static MVMuint32 find_table_index(MVMThreadContext *tc, MVMHeapSnapshotTableEntry **hash, MVMuint64 *key,
+                                  MVMuint64 new_idx, MVMuint32 *found_idx) {
+    MVMHeapSnapshotTableEntry *entry;
+    HASH_FIND(hash_handle, *hash, (char *)key, 4 * sizeof(MVMuint64), entry);
+    if (entry) {
+        *found_idx = (MVMuint32)entry->idx;
+        return 1;
+    }
+    entry = MVM_malloc(sizeof(MVMHeapSnapshotTableEntry));
+    memcpy(entry->key, key, 4 * sizeof(MVMuint64));
+    entry->idx = new_idx;
+    HASH_ADD_KEYPTR(hash_handle, *hash, (char *)entry->key, 4 * sizeof(MVMuint64), entry);
+    return 0;
+}
 
 /* Gets a string index in the string heap for a VM string. */
 static MVMuint64 get_vm_string_index(MVMThreadContext *tc, MVMHeapSnapshotState *ss, MVMString *str) {
@@ -201,15 +356,11 @@ static void set_type_index(MVMThreadContext *tc, MVMHeapSnapshotState *ss,
         ? get_string_index(tc, ss, st->debug_name, STR_MODE_DUP)
         : get_string_index(tc, ss, "<anon>", STR_MODE_CONST);
 
-    MVMuint64 i;
+    MVMuint64 key[4] = { repr_idx, type_idx, 0, 0 };
     MVMHeapSnapshotType *t;
-    for (i = 0; i < ss->col->num_types; i++) {
-        t = &(ss->col->types[i]);
-        if (t->repr_name == repr_idx && t->type_name == type_idx) {
-            col->type_or_frame_index = i;
-            return;
-        }
-    }
+    if (find_table_index(tc, &(ss->col->types_hash), key, ss->col->num_types,
+            &(col->type_or_frame_index)))
+        return;
 
     grow_storage(&(ss->col->types), &(ss->col->num_types),
         &(ss->col->alloc_types), sizeof(MVMHeapSnapshotType));
@@ -228,21 +379,18 @@ static void set_static_frame_index(MVMThreadContext *tc, MVMHeapSnapshotState *s
     MVMuint64 cuid_idx = get_vm_string_index(tc, ss, sf->body.cuuid);
 
     MVMCompUnit *cu = sf->body.cu;
-    MVMBytecodeAnnotation *ann = MVM_bytecode_resolve_annotation(tc, &(sf->body), 0);
+    MVMBytecodeAnnotation  ann_buf;
+    MVMBytecodeAnnotation *ann = MVM_bytecode_resolve_annotation(tc, &(sf->body), 0, &ann_buf);
     MVMuint64 line = ann ? ann->line_number : 1;
     MVMuint64 file_idx = ann && ann->filename_string_heap_index < cu->body.num_strings
         ? get_vm_string_index(tc, ss, MVM_cu_string(tc, cu, ann->filename_string_heap_index))
         : get_vm_string_index(tc, ss, cu->body.filename);
 
-    MVMuint64 i;
+    MVMuint64 key[4] = { name_idx, cuid_idx, line, file_idx };
     MVMHeapSnapshotStaticFrame *s;
-    for (i = 0; i < ss->col->num_static_frames; i++) {
-        s = &(ss->col->static_frames[i]);
-        if (s->name == name_idx && s->cuid == cuid_idx && s->line == line && s->file == file_idx) {
-            col->type_or_frame_index = i;
-            return;
-        }
-    }
+    if (find_table_index(tc, &(ss->col->static_frames_hash), key, ss->col->num_static_frames,
+            &(col->type_or_frame_index)))
+        return;
 
     grow_storage(&(ss->col->static_frames), &(ss->col->num_static_frames),
         &(ss->col->alloc_static_frames), sizeof(MVMHeapSnapshotStaticFrame));
@@ -584,10 +732,20 @@ static void record_snapshot(MVMThreadContext *tc, MVMHeapSnapshotCollection *col
 }
 
 /* Takes a snapshot of the heap, adding it to the current heap snapshot
- * collection. */
+ * collection, or writing it out if we're streaming to a file. */
 void MVM_profile_heap_take_snapshot(MVMThreadContext *tc) {
     if (MVM_profile_heap_profiling(tc)) {
         MVMHeapSnapshotCollection *col = tc->instance->heap_snapshots;
+        if (col->fh) {
+            MVMHeapSnapshot hs;
+            memset(&hs, 0, sizeof(MVMHeapSnapshot));
+            record_snapshot(tc, col, &hs);
+            write_snapshot(col, &hs, col->num_snapshots);
+            MVM_free(hs.collectables);
+            MVM_free(hs.references);
+            col->num_snapshots++;
+            return;
+        }
         grow_storage(&(col->snapshots), &(col->num_snapshots), &(col->alloc_snapshots),
             sizeof(MVMHeapSnapshot));
         record_snapshot(tc, col, &(col->snapshots[col->num_snapshots]));
@@ -600,7 +758,8 @@ static void destroy_heap_snapshot_collection(MVMThreadContext *tc) {
     MVMHeapSnapshotCollection *col = tc->instance->heap_snapshots;
     MVMuint64 i;
 
-    for (i = 0; i < col->num_snapshots; i++) {
+    /* Snapshots streamed to a file are not kept around. */
+    for (i = 0; !col->path && i < col->num_snapshots; i++) {
         MVMHeapSnapshot *hs = &(col->snapshots[i]);
         MVM_free(hs->collectables);
         MVM_free(hs->references);
@@ -616,6 +775,14 @@ static void destroy_heap_snapshot_collection(MVMThreadContext *tc) {
     MVM_free(col->types);
     MVM_free(col->static_frames);
 
+    if (col->strings_hash)
+        MVM_HASH_DESTROY(hash_handle, MVMHeapSnapshotStringEntry, col->strings_hash);
+    if (col->types_hash)
+        MVM_HASH_DESTROY(hash_handle, MVMHeapSnapshotTableEntry, col->types_hash);
+    if (col->static_frames_hash)
+        MVM_HASH_DESTROY(hash_handle, MVMHeapSnapshotTableEntry, col->static_frames_hash);
+    MVM_free(col->path);
+
     MVM_free(col);
     tc->instance->heap_snapshots = NULL;
 }
@@ -811,9 +978,39 @@ MVMObject * collection_to_mvm_objects(MVMThreadContext *tc, MVMHeapSnapshotColle
     return results;
 }
 
+/* When streaming to a file, finishes it off, tears down the collection, and
+ * hands back a hash with the path of the file. */
+static MVMObject * finish_snapshot_file(MVMThreadContext *tc, MVMHeapSnapshotCollection *col) {
+    MVMObject *result;
+    char      *path;
+    int        close_errno = 0;
+    write_new_tables(col);
+    write_block_start(col, "DONE", 0);
+    if (fclose(col->fh) != 0)
+        close_errno = errno;
+    col->fh = NULL;
+    path    = strdup(col->path);
+    destroy_heap_snapshot_collection(tc);
+    if (close_errno) {
+        char *waste[] = { path, NULL };
+        MVM_exception_throw_adhoc_free(tc, waste, "Failed to close heap snapshot file '%s': %s",
+            path, strerror(close_errno));
+    }
+    MVM_gc_allocate_gen2_default_set(tc);
+    result = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "path"), box_s(tc, vmstr(tc, path)));
+    MVM_gc_allocate_gen2_default_clear(tc);
+    MVM_free(path);
+    return result;
+}
+
 /* Finishes heap profiling, getting the data. */
 MVMObject * MVM_profile_heap_end(MVMThreadContext *tc) {
-    MVMObject *dataset = collection_to_mvm_objects(tc, tc->instance->heap_snapshots);
+    MVMHeapSnapshotCollection *col = tc->instance->heap_snapshots;
+    MVMObject *dataset;
+    if (col->fh)
+        return finish_snapshot_file(tc, col);
+    dataset = collection_to_mvm_objects(tc, col);
     destroy_heap_snapshot_collection(tc);
     return dataset;
 }
@@ -8,27 +8,71 @@ struct MVMHeapSnapshotCollection {
     MVMuint64 num_snapshots;
     MVMuint64 alloc_snapshots;
 
-    /* Known types/REPRs. Just a list for now, but we might like to look at a
-     * hash or trie if this ends up making taking a snapshot wicked slow. */
+    /* Known types/REPRs, along with a hash to find them by their strings. */
     MVMHeapSnapshotType *types;
     MVMuint64 num_types;
     MVMuint64 alloc_types;
+    MVMHeapSnapshotTableEntry *types_hash;
 
-    /* Known static frames. Same applies to searching this as to the above. */
+    /* Known static frames, along with a hash to find them. */
     MVMHeapSnapshotStaticFrame *static_frames;
     MVMuint64 num_static_frames;
     MVMuint64 alloc_static_frames;
+    MVMHeapSnapshotTableEntry *static_frames_hash;
 
     /* Strings, referenced by index from various places. Also a "should we
-     * free it" flag for each one. */
+     * free it" flag for each one, and a hash to find them. */
     char **strings;
     MVMuint64 num_strings;
     MVMuint64 alloc_strings;
     char *strings_free;
     MVMuint64 num_strings_free;
     MVMuint64 alloc_strings_free;
+    MVMHeapSnapshotStringEntry *strings_hash;
+
+    /* If we're streaming snapshots to a file rather than keeping them, the
+     * file and its path, along with how many of the strings, types and
+     * static frames have been written out so far. */
+    FILE *fh;
+    char *path;
+    MVMuint64 strings_written;
+    MVMuint64 types_written;
+    MVMuint64 static_frames_written;
 };
 
+/* Entry in the hash of strings in a snapshot collection; the key is the
+ * string itself. */
+struct MVMHeapSnapshotStringEntry {
+    MVMuint64 idx;
+    UT_hash_handle hash_handle;
+};
+
+/* Entry in the hash of types or static frames in a snapshot collection; the
+ * key is the string indexes (and line number) that describe it. */
+struct MVMHeapSnapshotTableEntry {
+    MVMuint64 key[4];
+    MVMuint64 idx;
+    UT_hash_handle hash_handle;
+};
+
+/* The binary format heap snapshots are streamed to a file in. The header is
+ * the 8 byte magic string, a u32 version and a reserved u32. After it comes a sequence of blocks, each a 4 byte tag and 64-bit length
+ * followed by that many bytes. All integers are little endian. Strings,
+ * types and static frames are written as they are first seen, just ahead
+ * of the first snapshot that uses them, and are numbered across the whole
+ * file. Tables are written as columns, one field at a time:
+ *   "STRS": u64 first index, u64 count, then count times (u32 length, bytes)
+ *   "TYPS": u64 first index, u64 count, u64 repr_name[], u64 type_name[]
+ *   "FRMS": u64 first index, u64 count, u64 name[], u64 cuid[], u64 line[],
+ *           u64 file[]
+ *   "SNAP": u64 snapshot number, u64 num collectables, u64 num references,
+ *           u16 kind[], u16 collectable_size[], u32 type_or_frame_index[],
+ *           u32 num_refs[], u64 refs_start[], u64 unmanaged_size[],
+ *           u64 ref description[], u64 ref collectable_index[]
+ *   "DONE": empty, written when profiling ends. */
+#define MVM_HEAPSNAPSHOT_MAGIC      "MOARHEAP"
+#define MVM_HEAPSNAPSHOT_VERSION    1
+
 /* An individual heap snapshot. */
 struct MVMHeapSnapshot {
     /* Array of data about collectables on the heap. */
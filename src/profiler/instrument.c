@@ -283,6 +283,8 @@ typedef struct {
     MVMString *osr;
     MVMString *deopt_one;
     MVMString *deopt_all;
+    MVMString *findmeth_cache_hits;
+    MVMString *findmeth_cache_misses;
     MVMString *spesh_time;
     MVMString *native_lib;
 } ProfDumpStrs;
@@ -296,8 +298,9 @@ static MVMObject * dump_call_graph_node(MVMThreadContext *tc, ProfDumpStrs *pds,
     /* Let's see if we're dealing with a native call or a regular moar call */
     if (pcn->sf) {
         /* Try to resolve the code filename and line number. */
+        MVMBytecodeAnnotation  annot_buf;
         MVMBytecodeAnnotation *annot = MVM_bytecode_resolve_annotation(tc,
-            &(pcn->sf->body), 0);
+            &(pcn->sf->body), 0, &annot_buf);
         MVMint32 fshi = annot ? (MVMint32)annot->filename_string_heap_index : -1;
 
         /* Add name of code object. */
@@ -316,7 +319,6 @@ static MVMObject * dump_call_graph_node(MVMThreadContext *tc, ProfDumpStrs *pds,
                 box_s(tc, tc->instance->str_consts.empty));
         MVM_repr_bind_key_o(tc, node_hash, pds->line,
             box_i(tc, annot ? (MVMint32)annot->line_number : -1));
-        MVM_free(annot);
 
         /* Use static frame memory address to get a unique ID. */
         MVM_repr_bind_key_o(tc, node_hash, pds->id,
@@ -367,6 +369,12 @@ static MVMObject * dump_call_graph_node(MVMThreadContext *tc, ProfDumpStrs *pds,
     if (pcn->deopt_all_count)
         MVM_repr_bind_key_o(tc, node_hash, pds->deopt_all,
             box_i(tc, pcn->deopt_all_count));
+    if (pcn->findmeth_cache_hits)
+        MVM_repr_bind_key_o(tc, node_hash, pds->findmeth_cache_hits,
+            box_i(tc, pcn->findmeth_cache_hits));
+    if (pcn->findmeth_cache_misses)
+        MVM_repr_bind_key_o(tc, node_hash, pds->findmeth_cache_misses,
+            box_i(tc, pcn->findmeth_cache_misses));
 
     /* Visit successors in the call graph, dumping them and working out the
      * exclusive time. */
@@ -496,6 +504,8 @@ static MVMObject * dump_data(MVMThreadContext *tc) {
     pds.osr             = str(tc, "osr");
     pds.deopt_one       = str(tc, "deopt_one");
     pds.deopt_all       = str(tc, "deopt_all");
+    pds.findmeth_cache_hits   = str(tc, "findmeth_cache_hits");
+    pds.findmeth_cache_misses = str(tc, "findmeth_cache_misses");
     pds.spesh_time      = str(tc, "spesh_time");
     pds.native_lib      = str(tc, "native library");
 
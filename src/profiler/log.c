@@ -374,6 +374,18 @@ void MVM_profiler_log_deopt_one(MVMThreadContext *tc) {
         pcn->deopt_one_count++;
 }
 
+/* Log a hit or miss of a method lookup inline cache. */
+void MVM_profiler_log_findmeth_cache(MVMThreadContext *tc, MVMint32 hit) {
+    MVMProfileThreadData *ptd = get_thread_data(tc);
+    MVMProfileCallNode   *pcn = ptd->current_call;
+    if (pcn) {
+        if (hit)
+            pcn->findmeth_cache_hits++;
+        else
+            pcn->findmeth_cache_misses++;
+    }
+}
+
 /* Log that full-stack deoptimization took pace. */
 void MVM_profiler_log_deopt_all(MVMThreadContext *tc) {
     MVMProfileThreadData *ptd = get_thread_data(tc);
@@ -105,6 +105,10 @@ struct MVMProfileCallNode {
     /* Number of times deopt_all happened. */
     MVMuint64 deopt_all_count;
 
+    /* Hits and misses of method lookup inline caches. */
+    MVMuint64 findmeth_cache_hits;
+    MVMuint64 findmeth_cache_misses;
+
     /* Entry mode, persisted for the sake of continuations. */
     MVMuint64 entry_mode;
 };
@@ -159,4 +163,5 @@ void MVM_profiler_log_spesh_start(MVMThreadContext *tc);
 void MVM_profiler_log_spesh_end(MVMThreadContext *tc);
 void MVM_profiler_log_osr(MVMThreadContext *tc, MVMuint64 jitted);
 void MVM_profiler_log_deopt_one(MVMThreadContext *tc);
+void MVM_profiler_log_findmeth_cache(MVMThreadContext *tc, MVMint32 hit);
 void MVM_profiler_log_deopt_all(MVMThreadContext *tc);
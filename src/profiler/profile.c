@@ -2,7 +2,9 @@
 
 /* Starts profiling with the specified configuration. */
 void MVM_profile_start(MVMThreadContext *tc, MVMObject *config) {
-    if (tc->instance->profiling || MVM_profile_heap_profiling(tc))
+    if (tc->instance->profiling || MVM_profile_heap_profiling(tc)
+            || MVM_profile_sampling_profiling(tc)
+            || MVM_profile_allocations_profiling(tc))
         MVM_exception_throw_adhoc(tc, "Profiling is already started");
 
     if (MVM_repr_exists_key(tc, config, tc->instance->str_consts.kind)) {
@@ -12,6 +14,10 @@ void MVM_profile_start(MVMThreadContext *tc, MVMObject *config) {
             MVM_profile_instrumented_start(tc, config);
         else if (MVM_string_equal(tc, kind, tc->instance->str_consts.heap))
             MVM_profile_heap_start(tc, config);
+        else if (MVM_string_equal(tc, kind, tc->instance->str_consts.sampling))
+            MVM_profile_sampling_start(tc, config);
+        else if (MVM_string_equal(tc, kind, tc->instance->str_consts.allocations))
+            MVM_profile_allocations_start(tc, config);
         else
             MVM_exception_throw_adhoc(tc, "Unknown profiler specified");
     }
@@ -28,6 +34,10 @@ MVMObject * MVM_profile_end(MVMThreadContext *tc) {
         return MVM_profile_instrumented_end(tc);
     else if (MVM_profile_heap_profiling(tc))
         return MVM_profile_heap_end(tc);
+    else if (MVM_profile_sampling_profiling(tc))
+        return MVM_profile_sampling_end(tc);
+    else if (MVM_profile_allocations_profiling(tc))
+        return MVM_profile_allocations_end(tc);
     else
         MVM_exception_throw_adhoc(tc, "Cannot end profiling if not profiling");
 }
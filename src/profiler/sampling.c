@@ -0,0 +1,431 @@
+#include "moar.h"
+#include <platform/threads.h>
+#include <platform/time.h>
+
+/* Is sampling profiling currently turned on? */
+MVMint32 MVM_profile_sampling_profiling(MVMThreadContext *tc) {
+    MVMSamplingProfiler *sp = tc->instance->sampling;
+    return sp && MVM_load(&sp->active);
+}
+
+/* The timer thread. It doesn't touch anything managed by the GC, so needn't
+ * take part in GC runs; it just moves the sample tick along. */
+static void timer_thread(void *data) {
+    MVMInstance         *instance = (MVMInstance *)data;
+    MVMSamplingProfiler *sp       = instance->sampling;
+    while (MVM_load(&sp->active)) {
+        MVM_platform_nanosleep(sp->interval);
+        MVM_incr(&instance->sample_tick);
+    }
+}
+
+/* Starts sampling profiling. The configuration may give an interval in
+ * microseconds, and a path to write the folded stacks to at the end. */
+void MVM_profile_sampling_start(MVMThreadContext *tc, MVMObject *config) {
+    MVMInstance         *instance = tc->instance;
+    MVMSamplingProfiler *sp       = instance->sampling;
+    MVMint64             interval = MVM_SAMPLING_DEFAULT_INTERVAL;
+    char                *path     = NULL;
+    int                  status;
+
+    if (MVM_repr_exists_key(tc, config, instance->str_consts.interval)) {
+        interval = MVM_repr_get_int(tc,
+            MVM_repr_at_key_o(tc, config, instance->str_consts.interval));
+        if (interval <= 0)
+            MVM_exception_throw_adhoc(tc,
+                "Sampling profiler interval must be positive, got %"PRId64, interval);
+    }
+    if (MVM_repr_exists_key(tc, config, instance->str_consts.path))
+        path = MVM_string_utf8_c8_encode_C_string(tc, MVM_repr_get_str(tc,
+            MVM_repr_at_key_o(tc, config, instance->str_consts.path)));
+
+    if (!sp) {
+        sp = MVM_calloc(1, sizeof(MVMSamplingProfiler));
+        uv_mutex_init(&sp->mutex);
+        instance->sampling = sp;
+    }
+    sp->interval  = (MVMuint64)interval * 1000;
+    sp->samples   = 0;
+    sp->truncated = 0;
+    sp->path      = path;
+
+    MVM_store(&sp->active, 1);
+    status = uv_thread_create(&sp->timer_thread, timer_thread, instance);
+    if (status < 0) {
+        MVM_store(&sp->active, 0);
+        MVM_free(sp->path);
+        sp->path = NULL;
+        MVM_exception_throw_adhoc(tc, "Could not start sampling profiler thread: %s",
+            uv_strerror(status));
+    }
+}
+
+/* Adds a static frame to a sample, if it's not yet at the depth limit. */
+static MVMuint32 add_frame(MVMSamplingBuffer *buf, MVMStaticFrame *sf,
+                           MVMuint32 flags, MVMuint32 depth) {
+    if (depth < MVM_SAMPLING_MAX_DEPTH) {
+        MVMSamplingEntry *e = &(buf->entries[buf->used++]);
+        e->sf    = sf;
+        e->flags = flags;
+        e->depth = 0;
+        depth++;
+    }
+    return depth;
+}
+
+/* Adds the frames inlined into a frame that are active at its current
+ * position. Inlines nested in others come earlier in the table, so this
+ * adds them innermost first, as a sample wants. */
+static MVMuint32 add_inlines(MVMThreadContext *tc, MVMSamplingBuffer *buf, MVMFrame *f,
+                             MVMSpeshCandidate *cand, MVMuint32 jitted, MVMuint32 depth) {
+    MVMint32 i;
+    if (jitted) {
+        /* For the current frame, the entry label is just where the last call
+         * returned to, so says nothing about where we are now. */
+        void         **labels = cand->jitcode->labels;
+        MVMJitInline  *inls   = cand->jitcode->inlines;
+        void          *label  = f->jit_entry_label;
+        if (f == tc->cur_frame || !label)
+            return depth;
+        for (i = 0; i < cand->jitcode->num_inlines; i++)
+            if (label >= labels[inls[i].start_label] && label <= labels[inls[i].end_label])
+                depth = add_frame(buf, cand->inlines[i].code->body.sf,
+                    MVM_SAMPLING_FRAME_JIT | MVM_SAMPLING_FRAME_INLINED, depth);
+    }
+    else {
+        MVMuint8  *pos    = f == tc->cur_frame ? *(tc->interp_cur_op) : f->return_address;
+        MVMuint32  offset = (MVMuint32)(pos - f->effective_bytecode);
+        for (i = 0; i < cand->num_inlines; i++)
+            if (offset >= cand->inlines[i].start && offset < cand->inlines[i].end)
+                depth = add_frame(buf, cand->inlines[i].code->body.sf,
+                    MVM_SAMPLING_FRAME_INLINED, depth);
+    }
+    return depth;
+}
+
+/* Called at a GC safe point when the sample tick has moved on; records the
+ * current stack into the thread's sample buffer. */
+void MVM_profile_sampling_take_sample(MVMThreadContext *tc) {
+    MVMSamplingProfiler *sp = tc->instance->sampling;
+    MVMSamplingBuffer   *buf;
+    MVMFrame            *f;
+    MVMuint32            header, depth;
+
+    tc->sample_tick = MVM_load(&tc->instance->sample_tick);
+    if (!sp || !tc->cur_frame)
+        return;
+
+    /* Set up the buffer the first time, and make room for a sample of the
+     * maximum depth if it's full. */
+    buf = tc->sampling_buffer;
+    if (!buf) {
+        buf = MVM_calloc(1, sizeof(MVMSamplingBuffer));
+        uv_mutex_init(&buf->mutex);
+        buf->entries = MVM_malloc(MVM_SAMPLING_BUFFER_SIZE * sizeof(MVMSamplingEntry));
+        tc->sampling_buffer = buf;
+    }
+    if (buf->used + MVM_SAMPLING_MAX_DEPTH + 1 > MVM_SAMPLING_BUFFER_SIZE)
+        MVM_profile_sampling_flush(tc, tc);
+
+    /* Check we're still sampling under the lock, so we don't add a sample
+     * after profiling ended and flushed us. */
+    uv_mutex_lock(&buf->mutex);
+    if (!MVM_load(&sp->active)) {
+        uv_mutex_unlock(&buf->mutex);
+        return;
+    }
+    header = buf->used++;
+    depth  = 0;
+    f      = tc->cur_frame;
+    while (f && depth < MVM_SAMPLING_MAX_DEPTH) {
+        MVMSpeshCandidate *cand   = f->spesh_cand;
+        MVMuint32          jitted = cand && cand->jitcode &&
+            f->effective_bytecode == cand->jitcode->bytecode
+            ? MVM_SAMPLING_FRAME_JIT
+            : 0;
+        if (cand && cand->num_inlines)
+            depth = add_inlines(tc, buf, f, cand, jitted, depth);
+        depth = add_frame(buf, f->static_info, jitted, depth);
+        f = f->caller;
+    }
+    buf->entries[header].sf    = NULL;
+    buf->entries[header].flags = f != NULL;
+    buf->entries[header].depth = depth;
+    uv_mutex_unlock(&buf->mutex);
+}
+
+/* A growable C string, for building up folded stacks. */
+typedef struct {
+    char   *data;
+    size_t  len;
+    size_t  alloc;
+} FoldBuffer;
+static void fold_append(FoldBuffer *fb, const char *str, size_t len) {
+    if (fb->len + len + 1 > fb->alloc) {
+        fb->alloc = (fb->len + len + 1) * 2;
+        fb->data  = MVM_realloc(fb->data, fb->alloc);
+    }
+    memcpy(fb->data + fb->len, str, len);
+    fb->len += len;
+    fb->data[fb->len] = '\0';
+}
+
+/* Renders a static frame's name and file, leaving out the characters that
+ * mean something in the folded stacks format. Also used by the allocation
+ * profiler. */
+char * MVM_profile_sampling_render_name(MVMThreadContext *tc, MVMStaticFrame *sf) {
+    MVMCompUnit *cu   = sf->body.cu;
+    char        *name = sf->body.name
+        ? MVM_string_utf8_encode_C_string(tc, sf->body.name)
+        : NULL;
+    char        *file = cu && cu->body.filename
+        ? MVM_string_utf8_encode_C_string(tc, cu->body.filename)
+        : NULL;
+    FoldBuffer   fb   = { NULL, 0, 0 };
+    char        *c;
+    if (name && *name)
+        fold_append(&fb, name, strlen(name));
+    else
+        fold_append(&fb, "<anon>", 6);
+    if (file) {
+        fold_append(&fb, " (", 2);
+        fold_append(&fb, file, strlen(file));
+        fold_append(&fb, ")", 1);
+    }
+    for (c = fb.data; *c; c++)
+        if (*c == ';' || *c == '\n')
+            *c = ' ';
+    MVM_free(name);
+    MVM_free(file);
+    return fb.data;
+}
+
+/* Gets the rendered name of a static frame, from the cache if possible. The
+ * cache is keyed on the frame's address, which is fine since no GC can run
+ * while we're folding a buffer. */
+static char * frame_name(MVMThreadContext *tc, MVMSamplingName **cache, MVMStaticFrame *sf) {
+    MVMSamplingName *entry;
+    HASH_FIND(hash_handle, *cache, &sf, sizeof(MVMStaticFrame *), entry);
+    if (!entry) {
+        entry       = MVM_malloc(sizeof(MVMSamplingName));
+        entry->sf   = sf;
+        entry->name = MVM_profile_sampling_render_name(tc, sf);
+        HASH_ADD_KEYPTR(hash_handle, *cache, &(entry->sf), sizeof(MVMStaticFrame *), entry);
+    }
+    return entry->name;
+}
+
+/* Adds a folded stack to the counts, taking ownership of it. */
+static void count_stack(MVMThreadContext *tc, MVMSamplingProfiler *sp, char *folded,
+                        MVMuint32 truncated) {
+    MVMSamplingStack *stack;
+    size_t len = strlen(folded);
+    uv_mutex_lock(&sp->mutex);
+    HASH_FIND(hash_handle, sp->stacks, folded, len, stack);
+    if (stack) {
+        stack->count++;
+        MVM_free(folded);
+    }
+    else {
+        stack         = MVM_malloc(sizeof(MVMSamplingStack));
+        stack->folded = folded;
+        stack->count  = 1;
+        HASH_ADD_KEYPTR(hash_handle, sp->stacks, stack->folded, len, stack);
+    }
+    sp->samples++;
+    if (truncated)
+        sp->truncated++;
+    uv_mutex_unlock(&sp->mutex);
+}
+
+/* Folds the samples in a thread's buffer into the counts per stack, and
+ * empties it. Either the owning thread or the thread ending profiling may
+ * do this. */
+void MVM_profile_sampling_flush(MVMThreadContext *tc, MVMThreadContext *owner) {
+    MVMSamplingProfiler *sp    = tc->instance->sampling;
+    MVMSamplingBuffer   *buf   = owner->sampling_buffer;
+    MVMSamplingName     *cache = NULL;
+    MVMSamplingName     *entry, *tmp;
+    unsigned             bucket_tmp;
+    MVMuint32            i = 0;
+    if (!sp || !buf)
+        return;
+
+    uv_mutex_lock(&buf->mutex);
+    while (i < buf->used) {
+        MVMSamplingEntry *header = &(buf->entries[i]);
+        FoldBuffer        fb     = { NULL, 0, 0 };
+        MVMint32          j;
+
+        /* Frames are stored innermost first; folded stacks go outermost
+         * first. */
+        for (j = (MVMint32)header->depth; j > 0; j--) {
+            MVMSamplingEntry *e    = &(buf->entries[i + j]);
+            char             *name = frame_name(tc, &cache, e->sf);
+            if (fb.len)
+                fold_append(&fb, ";", 1);
+            fold_append(&fb, name, strlen(name));
+            if (e->flags & MVM_SAMPLING_FRAME_INLINED)
+                fold_append(&fb, "_[i]", 4);
+            else if (e->flags & MVM_SAMPLING_FRAME_JIT)
+                fold_append(&fb, "_[j]", 4);
+        }
+        if (fb.data)
+            count_stack(tc, sp, fb.data, header->flags);
+        i += 1 + header->depth;
+    }
+    buf->used = 0;
+    uv_mutex_unlock(&buf->mutex);
+
+    HASH_ITER(hash_handle, cache, entry, tmp, bucket_tmp) {
+        MVM_free(entry->name);
+    }
+    if (cache)
+        MVM_HASH_DESTROY(hash_handle, MVMSamplingName, cache);
+}
+
+/* Marks the static frames in the thread's sample buffer. */
+void MVM_profile_sampling_mark_data(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMSamplingBuffer *buf = tc->sampling_buffer;
+    MVMuint32 i;
+    if (!buf)
+        return;
+    for (i = 0; i < buf->used; i++)
+        if (buf->entries[i].sf)
+            MVM_gc_worklist_add(tc, worklist, &(buf->entries[i].sf));
+}
+
+/* Frees a thread's sample buffer, when the thread is destroyed. */
+void MVM_profile_sampling_destroy_buffer(MVMThreadContext *tc) {
+    MVMSamplingBuffer *buf = tc->sampling_buffer;
+    if (buf) {
+        uv_mutex_destroy(&buf->mutex);
+        MVM_free(buf->entries);
+        MVM_free(buf);
+        tc->sampling_buffer = NULL;
+    }
+}
+
+/* Stops the timer thread, if it's running. */
+static void stop_timer(MVMSamplingProfiler *sp) {
+    if (MVM_load(&sp->active)) {
+        MVM_store(&sp->active, 0);
+        uv_thread_join(&sp->timer_thread);
+    }
+}
+
+/* Frees the counted stacks. */
+static void free_stacks(MVMSamplingProfiler *sp) {
+    MVMSamplingStack *stack, *tmp;
+    unsigned bucket_tmp;
+    HASH_ITER(hash_handle, sp->stacks, stack, tmp, bucket_tmp) {
+        MVM_free(stack->folded);
+    }
+    if (sp->stacks)
+        MVM_HASH_DESTROY(hash_handle, MVMSamplingStack, sp->stacks);
+    sp->stacks = NULL;
+}
+
+/* Writes the folded stacks to the requested file. Returns 0 on success, or
+ * the errno of the failure, with what set to the step that failed. */
+static int write_folded(MVMSamplingProfiler *sp, char *path, const char **what) {
+    MVMSamplingStack *stack, *tmp;
+    unsigned bucket_tmp;
+    FILE *fh = fopen(path, "w");
+    if (!fh) {
+        *what = "open";
+        return errno;
+    }
+    HASH_ITER(hash_handle, sp->stacks, stack, tmp, bucket_tmp) {
+        fprintf(fh, "%s %"PRIu64"\n", stack->folded, stack->count);
+    }
+    if (fclose(fh) != 0) {
+        *what = "write";
+        return errno;
+    }
+    return 0;
+}
+
+/* Turns the counts into a hash of the sample totals and an array of folded
+ * stacks, each followed by a space and its count. */
+#define vmstr(tc, cstr) MVM_string_utf8_decode(tc, tc->instance->VMString, cstr, strlen(cstr))
+#define box_i(tc, i) MVM_repr_box_int(tc, MVM_hll_current(tc)->int_box_type, i)
+#define box_s(tc, str) MVM_repr_box_str(tc, MVM_hll_current(tc)->str_box_type, str)
+static MVMObject * counts_to_mvm_object(MVMThreadContext *tc, MVMSamplingProfiler *sp) {
+    MVMObject *result, *stacks;
+    MVMSamplingStack *stack, *tmp;
+    unsigned bucket_tmp;
+
+    /* Allocate in gen2, so as not to trigger GC. */
+    MVM_gc_allocate_gen2_default_set(tc);
+    result = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+    stacks = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_array_type);
+    HASH_ITER(hash_handle, sp->stacks, stack, tmp, bucket_tmp) {
+        char *line = MVM_malloc(strlen(stack->folded) + 24);
+        sprintf(line, "%s %"PRIu64, stack->folded, stack->count);
+        MVM_repr_push_o(tc, stacks, box_s(tc, vmstr(tc, line)));
+        MVM_free(line);
+    }
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "stacks"), stacks);
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "samples"), box_i(tc, sp->samples));
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "truncated"), box_i(tc, sp->truncated));
+    MVM_repr_bind_key_o(tc, result, vmstr(tc, "interval"), box_i(tc, sp->interval / 1000));
+    MVM_gc_allocate_gen2_default_clear(tc);
+    return result;
+}
+
+/* Ends sampling profiling, folding the samples every thread has left in its
+ * buffer, and returns the results. */
+MVMObject * MVM_profile_sampling_end(MVMThreadContext *tc) {
+    MVMSamplingProfiler *sp = tc->instance->sampling;
+    MVMThread           *thread;
+    MVMObject           *result;
+
+    MVM_gc_mark_thread_blocked(tc);
+    stop_timer(sp);
+    MVM_gc_mark_thread_unblocked(tc);
+
+    /* No GC run can start while we are walking the threads, so none of the
+     * thread contexts can be destroyed under us. Threads that have exited
+     * already flushed their own buffer. */
+    thread = (MVMThread *)MVM_load(&tc->instance->threads);
+    while (thread) {
+        if (MVM_load(&thread->body.stage) == MVM_thread_stage_started && thread->body.tc)
+            MVM_profile_sampling_flush(tc, thread->body.tc);
+        thread = thread->body.next;
+    }
+
+    /* If the file can't be written, the counts are thrown away as they
+     * would have been on success, so the next run starts afresh. */
+    if (sp->path) {
+        char       *path = sp->path;
+        const char *what;
+        int         err;
+        sp->path = NULL;
+        if ((err = write_folded(sp, path, &what)) != 0) {
+            char *waste[] = { path, NULL };
+            free_stacks(sp);
+            sp->samples   = 0;
+            sp->truncated = 0;
+            MVM_exception_throw_adhoc_free(tc, waste, "Could not %s sampling profile file '%s': %s",
+                what, path, strerror(err));
+        }
+        MVM_free(path);
+    }
+    result = counts_to_mvm_object(tc, sp);
+    free_stacks(sp);
+    return result;
+}
+
+/* Cleans up the sampling profiler at instance shutdown. */
+void MVM_profile_sampling_destroy(MVMInstance *instance) {
+    MVMSamplingProfiler *sp = instance->sampling;
+    if (sp) {
+        stop_timer(sp);
+        free_stacks(sp);
+        MVM_free(sp->path);
+        uv_mutex_destroy(&sp->mutex);
+        MVM_free(sp);
+        instance->sampling = NULL;
+    }
+}
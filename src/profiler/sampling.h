@@ -0,0 +1,86 @@
+/* The sampling profiler. A timer thread bumps the instance's sample tick at
+ * the requested interval; each thread notices this at its next GC safe point
+ * (which are at branches and invocations, in both the interpreter and JIT
+ * compiled code) and records its current chain of static frames, including
+ * any inlined frames, into a per-thread buffer. Buffers are folded into
+ * counts per distinct stack when they fill up, when a thread ends, and when
+ * profiling ends. The result is in the "folded stacks" format understood by
+ * flame graph tools. */
+
+/* Default sampling interval, in microseconds. */
+#define MVM_SAMPLING_DEFAULT_INTERVAL   1000
+
+/* Deepest stack we record; deeper ones are truncated at the outermost end. */
+#define MVM_SAMPLING_MAX_DEPTH          256
+
+/* Number of entries in a thread's sample buffer. */
+#define MVM_SAMPLING_BUFFER_SIZE        16384
+
+/* Flags for a frame in a sample, rendered as the annotation suffixes flame
+ * graph tools know about. */
+#define MVM_SAMPLING_FRAME_JIT          1
+#define MVM_SAMPLING_FRAME_INLINED      2
+
+/* An entry in a sample buffer. A sample starts with an entry with no static
+ * frame, whose depth is the number of frames that follow it, innermost
+ * first. */
+struct MVMSamplingEntry {
+    MVMStaticFrame *sf;
+    MVMuint32 flags;
+    MVMuint32 depth;
+};
+
+/* A thread's buffer of samples not yet folded. The lock is held by the
+ * thread while recording, and by whoever is folding it. */
+struct MVMSamplingBuffer {
+    uv_mutex_t mutex;
+    MVMSamplingEntry *entries;
+    MVMuint32 used;
+};
+
+/* Number of times a distinct stack was seen, keyed on its folded form. */
+struct MVMSamplingStack {
+    char *folded;
+    MVMuint64 count;
+    UT_hash_handle hash_handle;
+};
+
+/* Cache of rendered static frame names, used while folding a buffer. */
+struct MVMSamplingName {
+    MVMStaticFrame *sf;
+    char *name;
+    UT_hash_handle hash_handle;
+};
+
+/* Sampling profiler state, hung off the instance. It is allocated the first
+ * time sampling starts and lives as long as the instance, since threads may
+ * still look at it after profiling ends. */
+struct MVMSamplingProfiler {
+    /* Non-zero while sampling; the timer thread exits when it's cleared. */
+    AO_t active;
+
+    /* The timer thread, and the interval it ticks at in nanoseconds. */
+    uv_thread_t timer_thread;
+    MVMuint64 interval;
+
+    /* Protects everything below. */
+    uv_mutex_t mutex;
+
+    /* Folded stacks seen so far, and sample counts. */
+    MVMSamplingStack *stacks;
+    MVMuint64 samples;
+    MVMuint64 truncated;
+
+    /* Where to write the folded stacks at the end, if anywhere. */
+    char *path;
+};
+
+void MVM_profile_sampling_start(MVMThreadContext *tc, MVMObject *config);
+MVMint32 MVM_profile_sampling_profiling(MVMThreadContext *tc);
+void MVM_profile_sampling_take_sample(MVMThreadContext *tc);
+char * MVM_profile_sampling_render_name(MVMThreadContext *tc, MVMStaticFrame *sf);
+void MVM_profile_sampling_flush(MVMThreadContext *tc, MVMThreadContext *owner);
+void MVM_profile_sampling_mark_data(MVMThreadContext *tc, MVMGCWorklist *worklist);
+void MVM_profile_sampling_destroy_buffer(MVMThreadContext *tc);
+MVMObject * MVM_profile_sampling_end(MVMThreadContext *tc);
+void MVM_profile_sampling_destroy(MVMInstance *instance);
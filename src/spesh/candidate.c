@@ -9,6 +9,47 @@ static void calculate_work_env_sizes(MVMThreadContext *tc, MVMStaticFrame *sf,
     c->env_size = c->num_lexicals * sizeof(MVMRegister);
 }
 
+/* Checks if a candidate is for the given callsite and guards. */
+static MVMint32 same_guards(MVMSpeshCandidate *cand, MVMCallsite *callsite,
+                            MVMSpeshGuard *guards, MVMint32 num_guards) {
+    return cand->cs == callsite && cand->num_guards == num_guards &&
+        memcmp(cand->guards, guards, num_guards * sizeof(MVMSpeshGuard)) == 0;
+}
+
+/* Works out the tier a new candidate for the given callsite and guards will
+ * be at: one past the highest of any retired candidates it replaces. */
+static MVMuint32 find_tier(MVMThreadContext *tc, MVMStaticFrame *static_frame,
+                           MVMCallsite *callsite, MVMSpeshGuard *guards, MVMint32 num_guards) {
+    MVMint32  num_spesh = static_frame->body.num_spesh_candidates;
+    MVMuint32 tier      = 0;
+    MVMint32  i;
+    for (i = 0; i < num_spesh; i++) {
+        MVMSpeshCandidate *cand = &static_frame->body.spesh_candidates[i];
+        if (cand->retired && cand->tier >= tier && same_guards(cand, callsite, guards, num_guards))
+            tier = cand->tier + 1;
+    }
+    return tier;
+}
+
+/* Writes a line about a tiering decision to the spesh log, if enabled. */
+static void log_tier_decision(MVMThreadContext *tc, MVMStaticFrame *static_frame,
+                              const char *what, MVMSpeshCandidate *cand, MVMuint32 tier) {
+    if (tc->instance->spesh_log_fh) {
+        char *c_name = MVM_string_utf8_encode_C_string(tc, static_frame->body.name);
+        char *c_cuid = MVM_string_utf8_encode_C_string(tc, static_frame->body.cuuid);
+        fprintf(tc->instance->spesh_log_fh,
+            "Tiering: %s '%s' (cuid: %s) at tier %u", what, c_name, c_cuid, tier);
+        if (cand)
+            fprintf(tc->instance->spesh_log_fh, " after %u deopts",
+                (MVMuint32)MVM_load(&cand->deopt_count));
+        fprintf(tc->instance->spesh_log_fh, " (%d of %d candidates in use)\n\n",
+            static_frame->body.num_spesh_candidates, MVM_SPESH_LIMIT);
+        fflush(tc->instance->spesh_log_fh);
+        MVM_free(c_name);
+        MVM_free(c_cuid);
+    }
+}
+
 /* Tries to set up a specialization of the bytecode for a given arg tuple.
  * Doesn't do the actual optimizations, just works out the guards and does
  * any simple argument transformations, and then inserts logging to record
@@ -22,6 +63,7 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
     MVMSpeshCode *sc;
     MVMint32 num_spesh_slots, num_log_slots, num_guards, *deopts, num_deopts;
     MVMuint16 num_locals, num_lexicals, used;
+    MVMuint32 tier;
     MVMCollectable **spesh_slots, **log_slots;
     char *before = 0;
     char *after = 0;
@@ -37,6 +79,21 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
     if (tc->instance->spesh_log_fh)
         before = MVM_spesh_dump(tc, sg);
     MVM_spesh_args(tc, sg, callsite, args);
+
+    /* If we're replacing candidates that deoptimized too much, log for more
+     * runs to get a more reliable profile; give up past the last tier. */
+    tier = find_tier(tc, static_frame, callsite, sg->arg_guards, sg->num_arg_guards);
+    if (tier > MVM_SPESH_MAX_TIER) {
+        log_tier_decision(tc, static_frame, "not re-specializing", NULL, tier);
+        MVM_free(before);
+        MVM_free(sg->arg_guards);
+        MVM_spesh_graph_destroy(tc, sg);
+        if (tc->instance->profiling)
+            MVM_profiler_log_spesh_end(tc);
+        return NULL;
+    }
+    if (tier)
+        sg->log_runs = MVM_SPESH_RELOG_RUNS;
     MVM_spesh_log_add_logging(tc, sg, osr);
     if (tc->instance->spesh_log_fh)
         after = MVM_spesh_dump(tc, sg);
@@ -64,8 +121,7 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
         MVMint32 i;
         for (i = 0; i < num_spesh; i++) {
             MVMSpeshCandidate *compare = &static_frame->body.spesh_candidates[i];
-            if (compare->cs == callsite && compare->num_guards == num_guards &&
-                memcmp(compare->guards, guards, num_guards * sizeof(MVMSpeshGuard)) == 0) {
+            if (!compare->retired && same_guards(compare, callsite, guards, num_guards)) {
                 /* Beaten! */
                 result = osr ? NULL : &static_frame->body.spesh_candidates[i];
                 break;
@@ -83,19 +139,26 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
             result->bytecode_size       = sc->bytecode_size;
             result->handlers            = sc->handlers;
             result->num_handlers        = sg->num_handlers;
+            result->handler_categories  = MVM_exception_handler_categories(
+                sc->handlers, sg->num_handlers);
             result->num_spesh_slots     = num_spesh_slots;
             result->spesh_slots         = spesh_slots;
             result->num_deopts          = num_deopts;
             result->deopts              = deopts;
             result->num_log_slots       = num_log_slots;
             result->log_slots           = log_slots;
+            result->call_counts         = sg->call_counts;
             result->num_locals          = num_locals;
             result->num_lexicals        = num_lexicals;
             result->local_types         = sg->local_types;
             result->lexical_types       = sg->lexical_types;
             result->sg                  = sg;
+            result->log_runs            = sg->log_runs;
             result->log_enter_idx       = 0;
-            result->log_exits_remaining = MVM_SPESH_LOG_RUNS;
+            result->log_exits_remaining = sg->log_runs;
+            result->tier                = tier;
+            result->deopt_count         = 0;
+            result->retired             = 0;
             calculate_work_env_sizes(tc, static_frame, result);
             if (osr)
                 result->osr_logging = 1;
@@ -114,12 +177,15 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
                 MVM_free(c_name);
                 MVM_free(c_cuid);
             }
+            if (tier)
+                log_tier_decision(tc, static_frame, "re-specializing", NULL, tier);
             used = 1;
         }
     }
     MVM_free(after);
     MVM_free(before);
     if (result && !used) {
+        MVM_free(sg->call_counts);
         MVM_free(sc->bytecode);
         if (sc->handlers)
             MVM_free(sc->handlers);
@@ -178,6 +244,8 @@ void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static
     candidate->bytecode_size = sc->bytecode_size;
     candidate->handlers      = sc->handlers;
     candidate->num_handlers  = sg->num_handlers;
+    candidate->handler_categories = MVM_exception_handler_categories(
+        sc->handlers, sg->num_handlers);
     candidate->num_deopts    = sg->num_deopt_addrs;
     candidate->deopts        = sg->deopt_addrs;
     candidate->num_locals    = sg->num_locals;
@@ -186,6 +254,7 @@ void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static
     candidate->inlines       = sg->inlines;
     candidate->local_types   = sg->local_types;
     candidate->lexical_types = sg->lexical_types;
+    candidate->inline_depth  = sg->inline_depth;
     calculate_work_env_sizes(tc, static_frame, candidate);
     MVM_free(sc);
 
@@ -224,6 +293,19 @@ void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static
         MVM_profiler_log_spesh_end(tc);
 }
 
+/* Notes that code running a candidate deoptimized. Once it has done so too
+ * many times, the candidate is retired, so that new calls get a candidate
+ * made from a fresh and longer profile, up to the last tier. */
+void MVM_spesh_candidate_note_deopt(MVMThreadContext *tc, MVMStaticFrame *static_frame,
+        MVMSpeshCandidate *candidate) {
+    if (!candidate || candidate->retired)
+        return;
+    if (MVM_incr(&candidate->deopt_count) + 1 == MVM_SPESH_RETIRE_DEOPTS) {
+        candidate->retired = 1;
+        MVM_barrier();
+        log_tier_decision(tc, static_frame, "retiring", candidate, candidate->tier);
+    }
+}
 
 void MVM_spesh_candidate_destroy(MVMThreadContext *tc, MVMSpeshCandidate *candidate) {
     if (candidate->sg)
@@ -234,6 +316,7 @@ void MVM_spesh_candidate_destroy(MVMThreadContext *tc, MVMSpeshCandidate *candid
     MVM_free(candidate->spesh_slots);
     MVM_free(candidate->deopts);
     MVM_free(candidate->log_slots);
+    MVM_free(candidate->call_counts);
     MVM_free(candidate->inlines);
     MVM_free(candidate->local_types);
     MVM_free(candidate->lexical_types);
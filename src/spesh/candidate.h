@@ -53,6 +53,13 @@ struct MVMSpeshCandidate {
     /* Number of logging slots. */
     MVMuint32 num_log_slots;
 
+    /* Which logging runs reached each call site. Kept until the candidate
+     * is destroyed, as code may still be running the logging bytecode. */
+    MVMuint8 *call_counts;
+
+    /* Deepest nesting of inlines in the specialized code. */
+    MVMuint16 inline_depth;
+
     /* Number of inlines and inlines table; see graph.h for description of
      * the table format. */
     MVMint32 num_inlines;
@@ -78,16 +85,44 @@ struct MVMSpeshCandidate {
     /* Number of handlers. */
     MVMuint32 num_handlers;
 
+    /* Union of the category masks of the handlers. */
+    MVMuint32 handler_categories;
+
     /* Whether this is a candidate we're in the process of doing OSR logging
      * on. */
     MVMuint32 osr_logging;
 
+    /* Number of runs we log for before specializing. */
+    MVMuint32 log_runs;
+
+    /* The tier of this candidate: 0 for the first specialization for its
+     * callsite and guards, and one more each time it was re-specialized
+     * after the previous one was retired. */
+    MVMuint32 tier;
+
+    /* Atomic count of the number of times code running this candidate has
+     * deoptimized. */
+    AO_t deopt_count;
+
+    /* Set once the candidate has deoptimized too often. It is then no longer
+     * chosen for new calls, which instead get a new candidate made from a
+     * longer profile. Frames already running it carry on. */
+    MVMuint32 retired;
+
     /* JIT-code structure */
     MVMJitCode *jitcode;
 };
 
-/* The number of specializations we'll allow per static frame. */
-#define MVM_SPESH_LIMIT 4
+/* The number of specializations we'll allow per static frame, including any
+ * that have been retired. */
+#define MVM_SPESH_LIMIT 8
+
+/* The number of deopts after which a candidate is retired. */
+#define MVM_SPESH_RETIRE_DEOPTS 64
+
+/* The highest tier we'll re-specialize to; past it, code that keeps on
+ * deoptimizing just runs unspecialized. */
+#define MVM_SPESH_MAX_TIER 2
 
 /* A specialization guard. */
 struct MVMSpeshGuard {
@@ -115,4 +150,6 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
     MVMint32 osr);
 void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static_frame,
         MVMSpeshCandidate *candidate);
+void MVM_spesh_candidate_note_deopt(MVMThreadContext *tc, MVMStaticFrame *static_frame,
+        MVMSpeshCandidate *candidate);
 void MVM_spesh_candidate_destroy(MVMThreadContext *tc, MVMSpeshCandidate *candidate);
@@ -188,6 +188,7 @@ void MVM_spesh_deopt_one(MVMThreadContext *tc) {
     if (f->effective_bytecode != f->static_info->body.bytecode) {
         MVMint32 deopt_offset = *(tc->interp_cur_op) - f->effective_bytecode;
         MVMint32 deopt_target = find_deopt_target(tc, f, deopt_offset);
+        MVM_spesh_candidate_note_deopt(tc, f->static_info, f->spesh_cand);
         deopt_frame(tc, tc->cur_frame, deopt_offset, deopt_target);
     }
     else {
@@ -204,6 +205,7 @@ void MVM_spesh_deopt_one_direct(MVMThreadContext *tc, MVMint32 deopt_offset,
     if (tc->instance->profiling)
         MVM_profiler_log_deopt_one(tc);
     if (f->effective_bytecode != f->static_info->body.bytecode) {
+        MVM_spesh_candidate_note_deopt(tc, f->static_info, f->spesh_cand);
         deopt_frame(tc, tc->cur_frame, deopt_offset, deopt_target);
     } else {
         MVM_oops(tc, "deopt_one_direct failed for %s (%s)",
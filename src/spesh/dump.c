@@ -68,11 +68,11 @@ static void dump_bb(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g, MVMSpes
 
     {
         /* Also, we have a line number */
-        MVMBytecodeAnnotation *bbba = MVM_bytecode_resolve_annotation(tc, &g->sf->body, bb->initial_pc);
+        MVMBytecodeAnnotation bbba_buf;
+        MVMBytecodeAnnotation *bbba = MVM_bytecode_resolve_annotation(tc, &g->sf->body, bb->initial_pc, &bbba_buf);
         MVMuint32 line_number;
         if (bbba) {
             line_number = bbba->line_number;
-            MVM_free(bbba);
         } else {
             line_number = -1;
         }
@@ -93,10 +93,10 @@ static void dump_bb(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g, MVMSpes
                 || ann->type == MVM_SPESH_ANN_DEOPT_ALL_INS
                 || ann->type == MVM_SPESH_ANN_DEOPT_INLINE
                 || ann->type == MVM_SPESH_ANN_DEOPT_OSR) {
-                MVMBytecodeAnnotation *ba = MVM_bytecode_resolve_annotation(tc, &g->sf->body, g->deopt_addrs[2 * ann->data.deopt_idx]);
+                MVMBytecodeAnnotation ba_buf;
+                MVMBytecodeAnnotation *ba = MVM_bytecode_resolve_annotation(tc, &g->sf->body, g->deopt_addrs[2 * ann->data.deopt_idx], &ba_buf);
                 if (ba) {
                     line_number = ba->line_number;
-                    MVM_free(ba);
                 } else {
                     line_number = -1;
                 }
@@ -242,7 +242,8 @@ static void dump_bb(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g, MVMSpes
                             break;
                         case MVM_operand_coderef: {
                             MVMCodeBody *body = &((MVMCode*)g->sf->body.cu->body.coderefs[cur_ins->operands[i].coderef_idx])->body;
-                            MVMBytecodeAnnotation *anno = MVM_bytecode_resolve_annotation(tc, &body->sf->body, 0);
+                            MVMBytecodeAnnotation anno_buf;
+                            MVMBytecodeAnnotation *anno = MVM_bytecode_resolve_annotation(tc, &body->sf->body, 0, &anno_buf);
 
                             append(ds, "coderef(");
 
@@ -254,8 +255,6 @@ static void dump_bb(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g, MVMSpes
                             } else {
                                 append(ds, "??\?)");
                             }
-
-                            MVM_free(anno);
                             break;
                         }
                         default:
@@ -375,25 +374,25 @@ static void dump_facts(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g) {
 
 /* Dumps a table of all logged values */
 static void dump_log_values(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g) {
-    MVMint16 log_index;
-    MVMint16 seen_table_size =  g->num_log_slots * MVM_SPESH_LOG_RUNS;
+    MVMint32 log_index;
+    MVMint32 seen_table_size =  g->num_log_slots * g->log_runs;
     size_t   ds_pos_before = tell_ds(ds);
     MVMint16 interesting = 0;
 
-    MVMCollectable **seen_table = alloca(sizeof(MVMCollectable *) *seen_table_size);
-    memset(seen_table, 0, sizeof(MVMCollectable *) * seen_table_size);
+    MVMCollectable **seen_table = MVM_calloc(seen_table_size ? seen_table_size : 1,
+        sizeof(MVMCollectable *));
 
     append(ds, "Logged values:\n");
 
     for (log_index = 0; log_index < g->num_log_slots; log_index++) {
-        MVMint16 run_index;
+        MVMint32 run_index;
 
         appendf(ds, "    % 3d ", log_index);
 
-        for (run_index = 0; run_index < MVM_SPESH_LOG_RUNS; run_index++) {
-            MVMuint16       log_slot = log_index * MVM_SPESH_LOG_RUNS + run_index;
+        for (run_index = 0; run_index < g->log_runs; run_index++) {
+            MVMuint32       log_slot = log_index * g->log_runs + run_index;
             MVMCollectable *log_obj  = g->log_slots[log_slot];
-            MVMint16        log_obj_idx;
+            MVMint32        log_obj_idx;
 
             if (log_obj) {
                 for (log_obj_idx = 0; log_obj_idx < seen_table_size; log_obj_idx++) {
@@ -437,6 +436,7 @@ static void dump_log_values(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g)
     }
 
     append(ds, "\n");
+    MVM_free(seen_table);
 
     if (!interesting) {
         rewind_ds(ds, ds_pos_before);
@@ -519,7 +519,8 @@ static void dump_arg_guards(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g)
 }
 
 static void dump_fileinfo(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g) {
-    MVMBytecodeAnnotation *ann = MVM_bytecode_resolve_annotation(tc, &g->sf->body, 0);
+    MVMBytecodeAnnotation  ann_buf;
+    MVMBytecodeAnnotation *ann = MVM_bytecode_resolve_annotation(tc, &g->sf->body, 0, &ann_buf);
     MVMCompUnit            *cu = g->sf->body.cu;
     MVMint32           str_idx = ann ? ann->filename_string_heap_index : 0;
     MVMint32           line_nr = ann ? ann->line_number : 1;
@@ -533,7 +534,6 @@ static void dump_fileinfo(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g) {
     appendf(ds, "%s:%d", filename_utf8, line_nr);
     if (filename)
         MVM_free(filename_utf8);
-    MVM_free(ann);
 }
 
 /* Dump a spesh graph into string form, for debugging purposes. */
@@ -230,9 +230,9 @@ static void log_facts(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb, MV
 
     /* See if all the recorded facts match up; a NULL means there was a code
      * path that never reached making a log entry. */
-    MVMuint16 log_start = ins->operands[1].lit_i16 * MVM_SPESH_LOG_RUNS;
-    MVMuint16 i;
-    for (i = log_start; i < log_start + MVM_SPESH_LOG_RUNS; i++) {
+    MVMuint32 log_start = ins->operands[1].lit_i16 * g->log_runs;
+    MVMuint32 i;
+    for (i = log_start; i < log_start + g->log_runs; i++) {
         MVMObject *consider = (MVMObject *)g->log_slots[i];
         if (consider) {
             if (!stable_value) {
@@ -255,7 +255,7 @@ static void log_facts(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb, MV
             return;
         stable_cont  = stable_value;
         stable_value = NULL;
-        for (i = log_start; i < log_start + MVM_SPESH_LOG_RUNS; i++) {
+        for (i = log_start; i < log_start + g->log_runs; i++) {
             MVMRegister r;
             contspec->fetch(tc, stable_cont, &r);
             if (r.o) {
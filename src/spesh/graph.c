@@ -65,9 +65,11 @@ static const MVMOpInfo * get_op_info(MVMThreadContext *tc, MVMCompUnit *cu, MVMu
     }
 }
 
-/* Records a de-optimization annotation and mapping pair. */
-static void add_deopt_annotation(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins_node,
-                                 MVMuint8 *pc, MVMint32 type) {
+/* Records a de-optimization annotation and mapping pair, where the target is
+ * an offset into the original bytecode. Returns the new deopt index. */
+MVMint32 MVM_spesh_graph_add_deopt_annotation(MVMThreadContext *tc, MVMSpeshGraph *g,
+                                              MVMSpeshIns *ins_node, MVMuint32 deopt_target,
+                                              MVMint32 type) {
     /* Add an the annotations. */
     MVMSpeshAnn *ann      = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshAnn));
     ann->type             = type;
@@ -84,8 +86,12 @@ static void add_deopt_annotation(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpes
         else
             g->deopt_addrs = MVM_malloc(g->alloc_deopt_addrs * sizeof(MVMint32) * 2);
     }
-    g->deopt_addrs[2 * g->num_deopt_addrs] = pc - g->bytecode;
-    g->num_deopt_addrs++;
+    g->deopt_addrs[2 * g->num_deopt_addrs] = deopt_target;
+    return g->num_deopt_addrs++;
+}
+static void add_deopt_annotation(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins_node,
+                                 MVMuint8 *pc, MVMint32 type) {
+    MVM_spesh_graph_add_deopt_annotation(tc, g, ins_node, pc - g->bytecode, type);
 }
 
 /* Finds the linearly previous basic block (not cheap, but uncommon). */
@@ -1090,6 +1096,7 @@ MVMSpeshGraph * MVM_spesh_graph_create(MVMThreadContext *tc, MVMStaticFrame *sf,
     g->num_handlers  = sf->body.num_handlers;
     g->num_locals    = sf->body.num_locals;
     g->num_lexicals  = sf->body.num_lexicals;
+    g->log_runs      = MVM_SPESH_LOG_RUNS;
     g->phi_infos     = MVM_spesh_alloc(tc, g, MVMPhiNodeCacheSize * sizeof(MVMOpInfo));
 
     /* Ensure the frame is validated, since we'll rely on this. */
@@ -1127,6 +1134,7 @@ MVMSpeshGraph * MVM_spesh_graph_create_from_cand(MVMThreadContext *tc, MVMStatic
     g->deopt_addrs       = cand->deopts;
     g->num_deopt_addrs   = cand->num_deopts;
     g->alloc_deopt_addrs = cand->num_deopts;
+    g->log_runs          = cand->log_runs;
     g->local_types       = cand->local_types;
     g->lexical_types     = cand->lexical_types;
     g->spesh_slots       = cand->spesh_slots;
@@ -71,9 +71,22 @@ struct MVMSpeshGraph {
     MVMSpeshInline *inlines;
     MVMint32 num_inlines;
 
-    /* Logging slots, along with the number of them. */
+    /* Logging slots, along with the number of them, and the number of runs
+     * logged into each. */
     MVMint32 num_log_slots;
     MVMCollectable **log_slots;
+    MVMuint32 log_runs;
+
+    /* Which logging runs reached each call site, with a flag per run laid
+     * out like the log slots, indexed by the operand of its sp_countcall;
+     * along with the number of call sites. */
+    MVMint32 num_call_counts;
+    MVMuint8 *call_counts;
+
+    /* Total size of the bytecode inlined so far, and the deepest nesting of
+     * inlines, for keeping within the inlining budget. */
+    MVMuint32 inlined_size;
+    MVMuint16 inline_depth;
 
     /* Number of basic blocks we have. */
     MVMint32 num_bbs;
@@ -259,6 +272,8 @@ struct MVMSpeshAnn {
 MVMSpeshGraph * MVM_spesh_graph_create(MVMThreadContext *tc, MVMStaticFrame *sf, MVMuint32 cfg_only);
 MVMSpeshGraph * MVM_spesh_graph_create_from_cand(MVMThreadContext *tc, MVMStaticFrame *sf,
     MVMSpeshCandidate *cand, MVMuint32 cfg_only);
+MVMint32 MVM_spesh_graph_add_deopt_annotation(MVMThreadContext *tc, MVMSpeshGraph *g,
+    MVMSpeshIns *ins_node, MVMuint32 deopt_target, MVMint32 type);
 MVMSpeshBB * MVM_spesh_graph_linear_prev(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *search);
 void MVM_spesh_graph_mark(MVMThreadContext *tc, MVMSpeshGraph *g, MVMGCWorklist *worklist);
 void MVM_spesh_graph_destroy(MVMThreadContext *tc, MVMSpeshGraph *g);
@@ -40,19 +40,36 @@ static void demand_extop(MVMThreadContext *tc, MVMCompUnit *target_cu, MVMCompUn
 }
 
 /* Sees if it will be possible to inline the target code ref, given we could
- * already identify a spesh candidate. Returns NULL if no inlining is possible
- * or a graph ready to be merged if it will be possible. */
+ * already identify a spesh candidate. The call count is on how many of the
+ * logging runs the call site was reached, or -1 if unknown. Returns NULL if no
+ * inlining is possible or a graph ready to be merged if it will be possible. */
 MVMSpeshGraph * MVM_spesh_inline_try_get_graph(MVMThreadContext *tc, MVMSpeshGraph *inliner,
-                                               MVMCode *target, MVMSpeshCandidate *cand) {
+                                               MVMCode *target, MVMSpeshCandidate *cand,
+                                               MVMint32 call_count) {
     MVMSpeshGraph *ig;
     MVMSpeshBB    *bb;
+    MVMuint32      max_size;
 
     /* Check inlining is enabled. */
     if (!tc->instance->spesh_inline_enabled)
         return NULL;
 
-    /* Check bytecode size is within the inline limit. */
-    if (cand->bytecode_size > MVM_SPESH_MAX_INLINE_SIZE)
+    /* A call site never reached while logging is cold, and not worth making
+     * the caller bigger for. One reached on every logging run is hot, and
+     * so worth inlining considerably bigger code into. */
+    if (call_count == 0)
+        return NULL;
+    max_size = call_count >= inliner->log_runs
+        ? MVM_SPESH_MAX_HOT_INLINE_SIZE
+        : MVM_SPESH_MAX_INLINE_SIZE;
+
+    /* Check bytecode size is within the inline limit, that the caller has
+     * enough inlining budget left, and that we won't nest too deeply. */
+    if (cand->bytecode_size > max_size)
+        return NULL;
+    if (inliner->inlined_size + cand->bytecode_size > MVM_SPESH_INLINE_BUDGET)
+        return NULL;
+    if (cand->inline_depth + 1 > MVM_SPESH_MAX_INLINE_DEPTH)
         return NULL;
 
     /* Ensure that this isn't a recursive inlining. */
@@ -125,7 +142,11 @@ MVMSpeshGraph * MVM_spesh_inline_try_get_graph(MVMThreadContext *tc, MVMSpeshGra
         bb = bb->linear_next;
     }
 
-    /* If we found nothing we can't inline, inlining is fine. */
+    /* If we found nothing we can't inline, inlining is fine; charge it to
+     * the caller's budget. */
+    inliner->inlined_size += cand->bytecode_size;
+    if (cand->inline_depth + 1 > inliner->inline_depth)
+        inliner->inline_depth = cand->inline_depth + 1;
     return ig;
 
     /* If we can't find a way to inline, we end up here. */
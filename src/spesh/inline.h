@@ -1,6 +1,17 @@
-/* Maximum size of bytecode we'll inline. */
+/* Maximum size of bytecode we'll inline, unless the call site is known to
+ * be hot. */
 #define MVM_SPESH_MAX_INLINE_SIZE 256
 
+/* Maximum size of bytecode we'll inline at a call site that was reached on
+ * every logging run. */
+#define MVM_SPESH_MAX_HOT_INLINE_SIZE 1024
+
+/* Maximum total size of bytecode inlined into one specialization. */
+#define MVM_SPESH_INLINE_BUDGET 4096
+
+/* Maximum depth of nested inlines. */
+#define MVM_SPESH_MAX_INLINE_DEPTH 4
+
 /* Inline table entry. The data is primarily used in deopt. */
 struct MVMSpeshInline {
     /* Start and end position in the bytecode where we're inside of this
@@ -28,7 +39,8 @@ struct MVMSpeshInline {
 };
 
 MVMSpeshGraph * MVM_spesh_inline_try_get_graph(MVMThreadContext *tc,
-    MVMSpeshGraph *inliner, MVMCode *target, MVMSpeshCandidate *cand);
+    MVMSpeshGraph *inliner, MVMCode *target, MVMSpeshCandidate *cand,
+    MVMint32 call_count);
 void MVM_spesh_inline(MVMThreadContext *tc, MVMSpeshGraph *inliner,
     MVMSpeshCallInfo *call_info, MVMSpeshBB *invoke_bb,
     MVMSpeshIns *invoke, MVMSpeshGraph *inlinee, MVMCode *inlinee_code);
@@ -38,12 +38,24 @@ static void insert_log(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb, M
         }
     }
 }
- 
+
+/* Adds an instruction noting which logging runs reach a call site, just
+ * after the prepargs that starts it. */
+static void insert_call_count(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb, MVMSpeshIns *ins) {
+    MVMSpeshIns *count_ins         = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshIns));
+    count_ins->info                = MVM_op_get_op(MVM_OP_sp_countcall);
+    count_ins->operands            = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshOperand));
+    count_ins->operands[0].lit_i16 = g->num_call_counts;
+    MVM_spesh_manipulate_insert_ins(tc, bb, ins, count_ins);
+    g->num_call_counts++;
+}
+
 void MVM_spesh_log_add_logging(MVMThreadContext *tc, MVMSpeshGraph *g, MVMint32 osr) {
     MVMSpeshBB  *bb;
 
-    /* We've no log slots so far. */
-    g->num_log_slots = 0;
+    /* We've no log slots or call counts so far. */
+    g->num_log_slots   = 0;
+    g->num_call_counts = 0;
 
     /* Work through the code, adding logging instructions where needed. */
     bb = g->entry;
@@ -65,6 +77,9 @@ void MVM_spesh_log_add_logging(MVMThreadContext *tc, MVMSpeshGraph *g, MVMint32
             case MVM_OP_invoke_o:
                 insert_log(tc, g, bb, ins, 1);
                 break;
+            case MVM_OP_prepargs:
+                insert_call_count(tc, g, bb, ins);
+                break;
             case MVM_OP_osrpoint:
                 if (osr)
                     ins->info = MVM_op_get_op(MVM_OP_sp_osrfinalize);
@@ -79,6 +94,9 @@ void MVM_spesh_log_add_logging(MVMThreadContext *tc, MVMSpeshGraph *g, MVMint32
 
     /* Allocate space for logging storage. */
     g->log_slots = g->num_log_slots
-        ? MVM_calloc(g->num_log_slots * MVM_SPESH_LOG_RUNS, sizeof(MVMCollectable *))
+        ? MVM_calloc(g->num_log_slots * g->log_runs, sizeof(MVMCollectable *))
+        : NULL;
+    g->call_counts = g->num_call_counts
+        ? MVM_calloc(g->num_call_counts * g->log_runs, sizeof(MVMuint8))
         : NULL;
 }
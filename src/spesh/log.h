@@ -1,6 +1,10 @@
 /* The number of runs we do to log what we see. */
 #define MVM_SPESH_LOG_RUNS  8
 
+/* The number of runs we log for when re-specializing code whose first
+ * specialization was retired, to get a more reliable picture of it. */
+#define MVM_SPESH_RELOG_RUNS 64
+
 /* Information about an inserted guard instruction due to logging. */
 struct MVMSpeshLogGuard {
     /* Instruction and containing basic block. */
@@ -119,14 +119,41 @@ void MVM_spesh_manipulate_remove_successor(MVMThreadContext *tc, MVMSpeshBB *bb,
     succ_pred[succ_num_pred] = NULL;
 }
 
+/* Adds a new local of the specified kind to the graph, with a single
+ * version, and returns its index. */
+static MVMuint16 add_local(MVMThreadContext *tc, MVMSpeshGraph *g, MVMuint16 kind) {
+    MVMSpeshFacts   **new_facts;
+    MVMuint16        *new_fact_counts;
+
+    /* Add locals table entry. */
+    if (!g->local_types) {
+        MVMint32 local_types_size = g->num_locals * sizeof(MVMuint16);
+        g->local_types = MVM_malloc(local_types_size);
+        memcpy(g->local_types, g->sf->body.local_types, local_types_size);
+    }
+    g->local_types = MVM_realloc(g->local_types, (g->num_locals + 1) * sizeof(MVMuint16));
+    g->local_types[g->num_locals] = kind;
+
+    /* Add facts table entry. */
+    new_facts       = MVM_spesh_alloc(tc, g, (g->num_locals + 1) * sizeof(MVMSpeshFacts *));
+    new_fact_counts = MVM_spesh_alloc(tc, g, (g->num_locals + 1) * sizeof(MVMuint16));
+    memcpy(new_facts, g->facts, g->num_locals * sizeof(MVMSpeshFacts *));
+    memcpy(new_fact_counts, g->fact_counts, g->num_locals * sizeof(MVMuint16));
+    new_facts[g->num_locals]       = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshFacts));
+    new_fact_counts[g->num_locals] = 1;
+    g->facts                       = new_facts;
+    g->fact_counts                 = new_fact_counts;
+
+    /* Increment number of locals. */
+    return g->num_locals++;
+}
+
 /* Gets a temporary register of the specified kind to use in some transform.
  * Will only actaully extend the frame if needed; if an existing temproary
  * was requested and then released, then it will just use a new version of
  * that. */
 MVMSpeshOperand MVM_spesh_manipulate_get_temp_reg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMuint16 kind) {
     MVMSpeshOperand   result;
-    MVMSpeshFacts   **new_facts;
-    MVMuint16        *new_fact_counts;
     MVMuint16         i;
 
     /* First, see if we can find an existing free temporary; use it if so. */
@@ -163,34 +190,22 @@ MVMSpeshOperand MVM_spesh_manipulate_get_temp_reg(MVMThreadContext *tc, MVMSpesh
     }
 
     /* Allocate temporary and set up result. */
-    g->temps[g->num_temps].orig   = result.reg.orig = g->num_locals;
+    g->temps[g->num_temps].orig   = result.reg.orig = add_local(tc, g, kind);
     g->temps[g->num_temps].i      = result.reg.i    = 0;
     g->temps[g->num_temps].kind   = kind;
     g->temps[g->num_temps].in_use = 1;
     g->num_temps++;
 
-    /* Add locals table entry. */
-    if (!g->local_types) {
-        MVMint32 local_types_size = g->num_locals * sizeof(MVMuint16);
-        g->local_types = MVM_malloc(local_types_size);
-        memcpy(g->local_types, g->sf->body.local_types, local_types_size);
-    }
-    g->local_types = MVM_realloc(g->local_types, (g->num_locals + 1) * sizeof(MVMuint16));
-    g->local_types[g->num_locals] = kind;
-
-    /* Add facts table entry. */
-    new_facts       = MVM_spesh_alloc(tc, g, (g->num_locals + 1) * sizeof(MVMSpeshFacts *));
-    new_fact_counts = MVM_spesh_alloc(tc, g, (g->num_locals + 1) * sizeof(MVMuint16));
-    memcpy(new_facts, g->facts, g->num_locals * sizeof(MVMSpeshFacts *));
-    memcpy(new_fact_counts, g->fact_counts, g->num_locals * sizeof(MVMuint16));
-    new_facts[g->num_locals]       = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshFacts));
-    new_fact_counts[g->num_locals] = 1;
-    g->facts                       = new_facts;
-    g->fact_counts                 = new_fact_counts;
-
-    /* Increment number of locals. */
-    g->num_locals++;
+    return result;
+}
 
+/* Gets a register of the specified kind that no other transform will ever
+ * be handed, for values that must stay live over code that may use (and
+ * release) temporaries, such as a value hoisted out of a loop. */
+MVMSpeshOperand MVM_spesh_manipulate_new_local(MVMThreadContext *tc, MVMSpeshGraph *g, MVMuint16 kind) {
+    MVMSpeshOperand result;
+    result.reg.orig = add_local(tc, g, kind);
+    result.reg.i    = 0;
     return result;
 }
 
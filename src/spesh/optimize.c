@@ -124,16 +124,18 @@ static void optimize_method_lookup(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSp
         }
     }
 
-    /* If not, add space to cache a single type/method pair, to save hash
-     * lookups in the (common) monomorphic case, and rewrite to caching
-     * version of the instruction. */
+    /* If not, add space to cache a few type/method pairs, to save hash
+     * lookups in the (common) monomorphic and polymorphic cases, and
+     * rewrite to caching version of the instruction. */
     if (!resolved) {
         MVMSpeshOperand *orig_o = ins->operands;
+        MVMint32 i;
         ins->info = MVM_op_get_op(MVM_OP_sp_findmeth);
         ins->operands = MVM_spesh_alloc(tc, g, 4 * sizeof(MVMSpeshOperand));
         memcpy(ins->operands, orig_o, 3 * sizeof(MVMSpeshOperand));
         ins->operands[3].lit_i16 = MVM_spesh_add_spesh_slot(tc, g, NULL);
-        MVM_spesh_add_spesh_slot(tc, g, NULL);
+        for (i = 1; i < 2 * MVM_FINDMETH_CACHE_TYPES; i++)
+            MVM_spesh_add_spesh_slot(tc, g, NULL);
     }
 }
 
@@ -940,7 +942,7 @@ static void optimize_getlex_known(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpe
     /* Ensure we have a log instruction following this one. */
     if (ins->next && ins->next->info->opcode == MVM_OP_sp_log) {
         /* Locate logged object. */
-        MVMuint16       log_slot = ins->next->operands[1].lit_i16 * MVM_SPESH_LOG_RUNS;
+        MVMuint32       log_slot = ins->next->operands[1].lit_i16 * g->log_runs;
         MVMCollectable *log_obj  = g->log_slots[log_slot];
         if (log_obj) {
             MVMSpeshFacts *facts;
@@ -981,7 +983,7 @@ static MVMint32 try_find_spesh_candidate(MVMThreadContext *tc, MVMCode *code, MV
     MVMint32 i, j;
     for (i = 0; i < num_spesh; i++) {
         MVMSpeshCandidate *cand = &sfb->spesh_candidates[i];
-        if (cand->cs == arg_info->cs) {
+        if (cand->cs == arg_info->cs && !cand->retired) {
             /* Matching callsite, now see if we have enough information to
              * test the guards. */
             MVMint32 guard_failed = 0;
@@ -1156,7 +1158,8 @@ static void optimize_call(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb
             if (spesh_cand >= 0) {
                 /* Yes. Will we be able to inline? */
                 MVMSpeshGraph *inline_graph = MVM_spesh_inline_try_get_graph(tc, g,
-                    target_code, &target_code->body.sf->body.spesh_candidates[spesh_cand]);
+                    target_code, &target_code->body.sf->body.spesh_candidates[spesh_cand],
+                    arg_info->call_count);
                 if (inline_graph) {
                     /* Yes, have inline graph, so go ahead and do it. */
                     /*char *c_name_i = MVM_string_utf8_encode_C_string(tc, target_code->body.sf->body.name);
@@ -1223,30 +1226,44 @@ static void optimize_extop(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *b
     }
 }
 
-/* Tries to optimize a throwcat instruction. Note that within a given frame
- * (we don't consider inlines here) the throwcat instructions all have the
- * same semantics. */
+/* Checks if a handler with the given category mask will accept an exception
+ * of the given (unlabeled) category, just as the runtime search does. */
+static MVMint32 handler_accepts(MVMuint32 mask, MVMuint32 category) {
+    return (mask & category) == category
+        || ((mask & MVM_EX_CAT_CONTROL) && category != MVM_EX_CAT_CATCH);
+}
+
+/* Tries to optimize a throwcat instruction into a goto. Within a given
+ * frame, inlines included, the throwcat instructions all have the same
+ * semantics: the handler picked is the first one in the table that is in
+ * effect at the throw and accepts the category. Inlined code is placed at
+ * the end of the graph with its own handlers and copies of the inliner's
+ * handlers in effect around it, so one walk in linear order sees the same
+ * handlers in effect as the exception handler search would at runtime. */
 static void optimize_throwcat(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb, MVMSpeshIns *ins) {
-    /* First, see if we have any goto handlers for this category. */
-    MVMint32 *handlers_found = MVM_malloc(g->sf->body.num_handlers * sizeof(MVMint32));
-    MVMint32  num_found      = 0;
-    MVMuint32 category       = (MVMuint32)ins->operands[1].lit_i64;
-    MVMint32  i;
-    for (i = 0; i < g->sf->body.num_handlers; i++)
-        if (g->sf->body.handlers[i].action == MVM_EX_ACTION_GOTO)
-            if (g->sf->body.handlers[i].category_mask & category)
-                handlers_found[num_found++] = i;
+    /* First, see if we have any goto handlers for this category. Labeled
+     * throws depend on the label the handler has at runtime, so leave them
+     * alone. */
+    MVMuint32 category  = (MVMuint32)ins->operands[1].lit_i64;
+    MVMint32  num_found = 0;
+    MVMuint32 i;
+    if (category & MVM_EX_CAT_LABELED)
+        return;
+    for (i = 0; i < g->num_handlers; i++)
+        if (g->handlers[i].action == MVM_EX_ACTION_GOTO)
+            if (handler_accepts(g->handlers[i].category_mask, category))
+                num_found++;
 
     /* If we found any appropriate handlers, we'll now do a scan through the
      * graph to see if we're in the scope of any of them. Note we can't keep
      * track of this in optimize_bb as it walks the dominance children, but
      * we need a linear view. */
     if (num_found) {
-        MVMint32    *in_handlers = MVM_calloc(g->sf->body.num_handlers, sizeof(MVMint32));
-        MVMSpeshBB **goto_bbs    = MVM_calloc(g->sf->body.num_handlers, sizeof(MVMSpeshBB *));
+        MVMint32    *in_handlers = MVM_calloc(g->num_handlers, sizeof(MVMint32));
+        MVMSpeshBB **goto_bbs    = MVM_calloc(g->num_handlers, sizeof(MVMSpeshBB *));
         MVMSpeshBB  *search_bb   = g->entry;
         MVMint32     picked      = -1;
-        while (search_bb && !search_bb->inlined) {
+        while (search_bb) {
             MVMSpeshIns *search_ins = search_bb->first_ins;
             while (search_ins) {
                 /* Track handlers. */
@@ -1260,7 +1277,7 @@ static void optimize_throwcat(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB
                         in_handlers[ann->data.frame_handler_index] = 0;
                         break;
                     case MVM_SPESH_ANN_FH_GOTO:
-                        if (ann->data.frame_handler_index < g->sf->body.num_handlers) {
+                        if (ann->data.frame_handler_index < g->num_handlers) {
                             goto_bbs[ann->data.frame_handler_index] = search_bb;
                             if (picked >= 0 && ann->data.frame_handler_index == picked)
                                 goto search_over;
@@ -1272,19 +1289,24 @@ static void optimize_throwcat(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB
 
                 /* Is this instruction the one we're trying to optimize? */
                 if (search_ins == ins) {
-                    /* See if we're in any acceptable handler (rely on the
-                     * table being pre-sorted by nesting depth here, just like
-                     * normal exception handler search does). */
-                    for (i = 0; i < num_found; i++) {
-                        if (in_handlers[handlers_found[i]]) {
-                            /* Got it! If we already found its goto target, we
-                             * can finish the search. */
-                            picked = handlers_found[i];
-                            if (goto_bbs[picked])
-                                goto search_over;
-                            break;
-                        }
+                    /* Find the handler that the runtime search would pick
+                     * (relying on the table being sorted innermost first).
+                     * If it isn't a goto handler, we can't rewrite. */
+                    for (i = 0; i < g->num_handlers; i++) {
+                        if (!in_handlers[i] || !handler_accepts(g->handlers[i].category_mask, category))
+                            continue;
+                        if (g->handlers[i].action != MVM_EX_ACTION_GOTO)
+                            goto search_over;
+
+                        /* Got it! If we already found its goto target, we
+                         * can finish the search. */
+                        picked = i;
+                        if (goto_bbs[picked])
+                            goto search_over;
+                        break;
                     }
+                    if (picked < 0)
+                        goto search_over;
                 }
 
                 search_ins = search_ins->next;
@@ -1304,8 +1326,6 @@ static void optimize_throwcat(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB
         MVM_free(in_handlers);
         MVM_free(goto_bbs);
     }
-
-    MVM_free(handlers_found);
 }
 
 static void analyze_phi(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins) {
@@ -1423,6 +1443,19 @@ static void optimize_bb(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb)
         case MVM_OP_prepargs:
             arg_info.cs = g->sf->body.cu->body.callsites[ins->operands[0].callsite_idx];
             arg_info.prepargs_ins = ins;
+            arg_info.call_count = -1;
+            break;
+        case MVM_OP_sp_countcall:
+            /* Note on how many logging runs the call was reached, for the
+             * inliner; the instruction itself is no longer needed. */
+            if (g->call_counts) {
+                MVMuint8 *runs = g->call_counts + ins->operands[0].lit_i16 * g->log_runs;
+                MVMint32  j;
+                arg_info.call_count = 0;
+                for (j = 0; j < g->log_runs; j++)
+                    arg_info.call_count += runs[j];
+            }
+            MVM_spesh_manipulate_delete_ins(tc, g, bb, ins);
             break;
         case MVM_OP_arg_i:
         case MVM_OP_arg_n:
@@ -1799,6 +1832,805 @@ static void eliminate_dead_bbs(MVMThreadContext *tc, MVMSpeshGraph *g) {
     }
 }
 
+/* Checks if an instruction is a point where we might deoptimize, at which
+ * point any object we have scalar-replaced would need to exist. */
+static MVMint32 is_deopt_point(MVMSpeshIns *ins) {
+    MVMSpeshAnn *ann = ins->annotations;
+    while (ann) {
+        switch (ann->type) {
+        case MVM_SPESH_ANN_DEOPT_ONE_INS:
+        case MVM_SPESH_ANN_DEOPT_ALL_INS:
+        case MVM_SPESH_ANN_DEOPT_INLINE:
+        case MVM_SPESH_ANN_DEOPT_OSR:
+            return 1;
+        }
+        ann = ann->next;
+    }
+    return 0;
+}
+
+/* Checks if an instruction writes to the given register. Since SSA versions
+ * of a local all live in the same register, this tells us if it's still safe
+ * to forward an earlier version of it. */
+static MVMint32 writes_register(MVMSpeshIns *ins, MVMuint16 orig) {
+    MVMint32 i;
+    if (ins->info->opcode == MVM_SSA_PHI)
+        return ins->operands[0].reg.orig == orig;
+    for (i = 0; i < ins->info->num_operands; i++)
+        if ((ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_write_reg
+                && ins->operands[i].reg.orig == orig)
+            return 1;
+    return 0;
+}
+
+/* Counts how many times an instruction reads the given SSA value, and if it
+ * does so gives the index of the (last) operand that does the reading. */
+static MVMint32 reads_value(MVMSpeshIns *ins, MVMSpeshOperand value, MVMint32 *idx) {
+    MVMint32 i, reads = 0;
+    MVMint32 phi = ins->info->opcode == MVM_SSA_PHI;
+    for (i = phi ? 1 : 0; i < ins->info->num_operands; i++) {
+        if ((phi || (ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg)
+                && ins->operands[i].reg.orig == value.reg.orig
+                && ins->operands[i].reg.i == value.reg.i) {
+            reads++;
+            *idx = i;
+        }
+    }
+    return reads;
+}
+
+/* Turns an instruction producing a value into a set from the register that
+ * we already know holds it. */
+static void rewrite_to_set(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins,
+                           MVMSpeshOperand value) {
+    MVMSpeshOperand target = ins->operands[0];
+    ins->info        = MVM_op_get_op(MVM_OP_set);
+    ins->operands    = MVM_spesh_alloc(tc, g, 2 * sizeof(MVMSpeshOperand));
+    ins->operands[0] = target;
+    ins->operands[1] = value;
+    get_facts_direct(tc, g, value)->usages++;
+    copy_facts(tc, g, target, value);
+}
+
+static MVMint32 unbox_op_for(MVMuint16 box_op) {
+    switch (box_op) {
+    case MVM_OP_box_i: return MVM_OP_unbox_i;
+    case MVM_OP_box_n: return MVM_OP_unbox_n;
+    case MVM_OP_box_s: return MVM_OP_unbox_s;
+    default:           return -1;
+    }
+}
+/* Checks if a deopt point may be reached after the given instruction,
+ * anywhere in the frame. Deopt resumes the original bytecode, which may still
+ * read the register of an object we replaced where the optimized code no
+ * longer does (for example, a type check that was folded away), so we can't
+ * replace an object if that can happen. */
+static MVMint32 deopt_point_follows(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
+                                    MVMSpeshIns *ins) {
+    MVMSpeshBB **todo     = MVM_malloc(g->num_bbs * sizeof(MVMSpeshBB *));
+    MVMuint8    *seen     = MVM_calloc(g->num_bbs, sizeof(MVMuint8));
+    MVMint32     num_todo = 0;
+    MVMint32     found    = 0;
+    MVMuint16    i;
+    for (ins = ins->next; ins && !found; ins = ins->next)
+        found = is_deopt_point(ins);
+    while (!found) {
+        for (i = 0; i < bb->num_succ; i++) {
+            MVMSpeshBB *succ = bb->succ[i];
+            if (!seen[succ->idx]) {
+                seen[succ->idx] = 1;
+                todo[num_todo++] = succ;
+            }
+        }
+        if (!num_todo)
+            break;
+        bb = todo[--num_todo];
+        for (ins = bb->first_ins; ins && !found; ins = ins->next)
+            found = is_deopt_point(ins);
+    }
+    MVM_free(todo);
+    MVM_free(seen);
+    return found;
+}
+
+/* Checks if unboxing what a box made gives back exactly the value that was
+ * boxed, which is only so if the box type is known, and stores values of the
+ * full width without any checks. */
+static MVMint32 box_is_exact(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *box) {
+    MVMSpeshFacts        *facts = get_facts_direct(tc, g, box->operands[2]);
+    const MVMStorageSpec *ss;
+    if (!(facts->flags & MVM_SPESH_FACT_KNOWN_TYPE) || !facts->type)
+        return 0;
+    ss = REPR(facts->type)->get_storage_spec(tc, STABLE(facts->type));
+    switch (REPR(facts->type)->ID) {
+    case MVM_REPR_ID_P6int:
+        return box->info->opcode == MVM_OP_box_i && ss->bits == 64;
+    case MVM_REPR_ID_P6num:
+        return box->info->opcode == MVM_OP_box_n && ss->bits == 64;
+    case MVM_REPR_ID_P6str:
+        return box->info->opcode == MVM_OP_box_s;
+    default:
+        return 0;
+    }
+}
+
+/* Looks for a box whose result is only ever unboxed again, later on in the
+ * same basic block, without any deopt point in between or after. In that
+ * case, the box never escapes, and the unboxes can just take the original
+ * value. */
+static void scalar_replace_box(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
+                               MVMSpeshIns *box) {
+    MVMSpeshOperand boxed    = box->operands[0];
+    MVMSpeshOperand value    = box->operands[1];
+    MVMSpeshFacts  *facts    = get_facts_direct(tc, g, boxed);
+    MVMint32        unbox_op = unbox_op_for(box->info->opcode);
+    MVMint32        found    = 0;
+    MVMint32        idx;
+    MVMSpeshIns    *ins;
+
+    /* Dead boxes are dead instruction elimination's problem. */
+    if (facts->usages == 0 || !box_is_exact(tc, g, box))
+        return;
+
+    /* First, make sure that every use is an unbox we can see. */
+    ins = box->next;
+    while (ins && found < facts->usages) {
+        MVMint32 reads;
+        if (is_deopt_point(ins))
+            return;
+        reads = reads_value(ins, boxed, &idx);
+        if (reads) {
+            if (ins->info->opcode != unbox_op || reads != 1)
+                return;
+            found++;
+        }
+        if (found < facts->usages && writes_register(ins, value.reg.orig))
+            return;
+        ins = ins->next;
+    }
+    if (found != facts->usages || deopt_point_follows(tc, g, bb, box))
+        return;
+
+    /* Now rewrite the unboxes, and toss the box. */
+    ins = box->next;
+    while (found) {
+        if (reads_value(ins, boxed, &idx)) {
+            rewrite_to_set(tc, g, ins, value);
+            found--;
+        }
+        ins = ins->next;
+    }
+    facts->usages = 0;
+    get_facts_direct(tc, g, value)->usages--;
+    get_facts_direct(tc, g, box->operands[2])->usages--;
+    MVM_spesh_manipulate_delete_ins(tc, g, bb, box);
+}
+
+/* Looks for an object that is created, has attributes bound and read, and is
+ * then never used again, all in the same basic block and with no deopt point
+ * in between or after. Such an object never escapes, so we can keep its
+ * attributes in the registers holding the bound values, and never create it
+ * at all. Only attribute access at full width is considered, so that reads
+ * give back just what was bound. */
+#define MVM_SPESH_MAX_REPLACED_ATTRS 16
+static MVMint32 is_replaceable_bind(MVMuint16 op) {
+    switch (op) {
+    case MVM_OP_sp_p6obind_o: case MVM_OP_sp_p6obind_i:
+    case MVM_OP_sp_p6obind_n: case MVM_OP_sp_p6obind_s:
+    case MVM_OP_sp_bind_o: case MVM_OP_sp_bind_i64:
+    case MVM_OP_sp_bind_n: case MVM_OP_sp_bind_s:
+        return 1;
+    default:
+        return 0;
+    }
+}
+static MVMint32 is_replaceable_get(MVMuint16 op) {
+    switch (op) {
+    case MVM_OP_sp_p6oget_o: case MVM_OP_sp_p6oget_i:
+    case MVM_OP_sp_p6oget_n: case MVM_OP_sp_p6oget_s:
+    case MVM_OP_sp_get_o: case MVM_OP_sp_get_i64:
+    case MVM_OP_sp_get_n: case MVM_OP_sp_get_s:
+        return 1;
+    default:
+        return 0;
+    }
+}
+/* The sp_bind_* and sp_get_* ops take an offset from the start of the object,
+ * but the sp_p6obind_* and sp_p6oget_* ones take it from the start of the
+ * P6opaque body. Give both from the object start, so that the two families
+ * key attributes the same way. */
+static MVMint32 object_offset(MVMSpeshIns *ins, MVMSpeshOperand offset) {
+    switch (ins->info->opcode) {
+    case MVM_OP_sp_p6obind_o: case MVM_OP_sp_p6obind_i:
+    case MVM_OP_sp_p6obind_n: case MVM_OP_sp_p6obind_s:
+    case MVM_OP_sp_p6oget_o: case MVM_OP_sp_p6oget_i:
+    case MVM_OP_sp_p6oget_n: case MVM_OP_sp_p6oget_s:
+        return (MVMint32)offsetof(MVMP6opaque, body) + offset.lit_i16;
+    default:
+        return offset.lit_i16;
+    }
+}
+static void scalar_replace_create(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
+                                  MVMSpeshIns *create) {
+    MVMSpeshOperand  obj   = create->operands[0];
+    MVMSpeshFacts   *facts = get_facts_direct(tc, g, obj);
+    MVMint32         offsets[MVM_SPESH_MAX_REPLACED_ATTRS];
+    MVMSpeshOperand  values[MVM_SPESH_MAX_REPLACED_ATTRS];
+    MVMint32         num_attrs = 0;
+    MVMint32         found     = 0;
+    MVMint32         pass, idx, i;
+    MVMSpeshIns     *ins;
+
+    if (facts->usages == 0)
+        return;
+
+    /* The first pass checks we can do it; the second does it. Both track
+     * which register holds the value of each attribute as we go. */
+    for (pass = 0; pass < 2; pass++) {
+        num_attrs = 0;
+        found     = 0;
+        ins       = create->next;
+        while (ins && found < facts->usages) {
+            MVMSpeshIns *next = ins->next;
+            MVMint32     reads;
+            if (pass == 0 && is_deopt_point(ins))
+                return;
+            reads = reads_value(ins, obj, &idx);
+            if (reads) {
+                MVMuint16 op = ins->info->opcode;
+                if (reads != 1 || (op == MVM_SSA_PHI))
+                    return;
+                if (is_replaceable_bind(op) && idx == 0) {
+                    MVMint32 offset = object_offset(ins, ins->operands[1]);
+                    for (i = 0; i < num_attrs; i++)
+                        if (offsets[i] == offset)
+                            break;
+                    if (i == num_attrs) {
+                        if (num_attrs == MVM_SPESH_MAX_REPLACED_ATTRS)
+                            return;
+                        offsets[num_attrs++] = offset;
+                    }
+                    values[i] = ins->operands[2];
+                    if (pass == 1) {
+                        get_facts_direct(tc, g, ins->operands[2])->usages--;
+                        MVM_spesh_manipulate_delete_ins(tc, g, bb, ins);
+                    }
+                }
+                else if (is_replaceable_get(op) && idx == 1) {
+                    MVMint32 offset = object_offset(ins, ins->operands[2]);
+                    for (i = 0; i < num_attrs; i++)
+                        if (offsets[i] == offset)
+                            break;
+                    if (i == num_attrs)
+                        return;
+                    if (pass == 1)
+                        rewrite_to_set(tc, g, ins, values[i]);
+                }
+                else {
+                    return;
+                }
+                found++;
+            }
+
+            /* If a register holding an attribute value gets overwritten,
+             * we can no longer read the attribute from it. */
+            if (found < facts->usages) {
+                for (i = 0; i < num_attrs; i++) {
+                    if (writes_register(ins, values[i].reg.orig)) {
+                        offsets[i] = offsets[num_attrs - 1];
+                        values[i]  = values[num_attrs - 1];
+                        num_attrs--;
+                        i--;
+                    }
+                }
+            }
+            ins = next;
+        }
+        if (found != facts->usages)
+            return;
+        if (pass == 0 && deopt_point_follows(tc, g, bb, create))
+            return;
+    }
+
+    facts->usages = 0;
+    MVM_spesh_manipulate_delete_ins(tc, g, bb, create);
+}
+
+/* Goes through the graph looking for objects that never escape the basic
+ * block that creates them, and replaces them with the values they hold. */
+static void eliminate_non_escaping_objects(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    MVMSpeshBB *bb = g->entry;
+    while (bb) {
+        MVMSpeshIns *ins = bb->first_ins;
+        while (ins) {
+            MVMSpeshIns *next = ins->next;
+            switch (ins->info->opcode) {
+            case MVM_OP_box_i:
+            case MVM_OP_box_n:
+            case MVM_OP_box_s:
+                scalar_replace_box(tc, g, bb, ins);
+                break;
+            case MVM_OP_sp_fastcreate:
+                scalar_replace_create(tc, g, bb, ins);
+                break;
+            }
+            ins = next;
+        }
+        bb = bb->linear_next;
+    }
+}
+
+/* Loop-invariant code motion. We find natural loops using the dominator
+ * tree, and for those with a single block leading into them (a preheader)
+ * move work that gives the same result on every iteration into it. */
+#define MVM_LICM_PURE       1   /* Depends only on its operands. */
+#define MVM_LICM_LEX        2   /* Reads a lexical. */
+#define MVM_LICM_ATTR       3   /* Reads an attribute or container. */
+#define MVM_LICM_GUARD      4   /* Guards the type of an object. */
+#define MVM_LICM_CONT_GUARD 5   /* Guards what a container holds. */
+static MVMint32 licm_kind(MVMuint16 op) {
+    switch (op) {
+    case MVM_OP_const_i8: case MVM_OP_const_i16: case MVM_OP_const_i32:
+    case MVM_OP_const_i64: case MVM_OP_const_i64_16: case MVM_OP_const_i64_32:
+    case MVM_OP_const_n32: case MVM_OP_const_n64: case MVM_OP_const_s:
+    case MVM_OP_null: case MVM_OP_null_s: case MVM_OP_sp_getspeshslot:
+    case MVM_OP_add_i: case MVM_OP_sub_i: case MVM_OP_mul_i: case MVM_OP_neg_i:
+    case MVM_OP_abs_i: case MVM_OP_band_i: case MVM_OP_bor_i: case MVM_OP_bxor_i:
+    case MVM_OP_bnot_i: case MVM_OP_blshift_i: case MVM_OP_brshift_i: case MVM_OP_not_i:
+    case MVM_OP_eq_i: case MVM_OP_ne_i: case MVM_OP_lt_i: case MVM_OP_le_i:
+    case MVM_OP_gt_i: case MVM_OP_ge_i: case MVM_OP_cmp_i:
+    case MVM_OP_add_n: case MVM_OP_sub_n: case MVM_OP_mul_n: case MVM_OP_div_n:
+    case MVM_OP_neg_n: case MVM_OP_abs_n: case MVM_OP_sqrt_n:
+    case MVM_OP_eq_n: case MVM_OP_ne_n: case MVM_OP_lt_n: case MVM_OP_le_n:
+    case MVM_OP_gt_n: case MVM_OP_ge_n: case MVM_OP_cmp_n:
+    case MVM_OP_coerce_in: case MVM_OP_isnull: case MVM_OP_isnonnull:
+    case MVM_OP_isconcrete: case MVM_OP_eqaddr:
+        return MVM_LICM_PURE;
+    case MVM_OP_getlex:
+        return MVM_LICM_LEX;
+    case MVM_OP_sp_p6oget_o: case MVM_OP_sp_p6oget_i:
+    case MVM_OP_sp_p6oget_n: case MVM_OP_sp_p6oget_s:
+    case MVM_OP_sp_get_o: case MVM_OP_sp_get_i64: case MVM_OP_sp_get_i32:
+    case MVM_OP_sp_get_i16: case MVM_OP_sp_get_i8:
+    case MVM_OP_sp_get_n: case MVM_OP_sp_get_s:
+        return MVM_LICM_ATTR;
+    case MVM_OP_sp_guardconc: case MVM_OP_sp_guardtype:
+        return MVM_LICM_GUARD;
+    case MVM_OP_sp_guardcontconc: case MVM_OP_sp_guardconttype:
+    case MVM_OP_sp_guardrwconc: case MVM_OP_sp_guardrwtype:
+        return MVM_LICM_CONT_GUARD;
+    default:
+        return 0;
+    }
+}
+
+/* Blocks that were eliminated still show up in predecessor lists and in
+ * the dominator tree, so we keep a note of those still alive. */
+static MVMint32 is_live(MVMSpeshGraph *g, MVMSpeshBB **live, MVMSpeshBB *bb) {
+    return bb->idx >= 0 && bb->idx < g->num_bbs && live[bb->idx] == bb;
+}
+static MVMint32 dominates(MVMSpeshBB **idoms, MVMSpeshBB *a, MVMSpeshBB *b) {
+    while (b && b != a)
+        b = idoms[b->idx];
+    return b == a;
+}
+static void record_idoms(MVMSpeshGraph *g, MVMSpeshBB **live, MVMSpeshBB **idoms, MVMSpeshBB *bb) {
+    MVMuint16 i;
+    for (i = 0; i < bb->num_children; i++) {
+        MVMSpeshBB *child = bb->children[i];
+        if (!is_live(g, live, child))
+            continue;
+        idoms[child->idx] = bb;
+        record_idoms(g, live, idoms, child);
+    }
+}
+
+/* State for the loop currently being considered. */
+typedef struct {
+    /* The loop header, and the block leading into it. */
+    MVMSpeshBB  *header;
+    MVMSpeshBB  *preheader;
+
+    /* Which blocks are in the loop, indexed by block index. */
+    MVMuint8    *in_loop;
+
+    /* The instruction in the loop that writes each SSA value, if any, as a
+     * flat array with offsets per local. Values made after we started (that
+     * is, the locals we hoist into) are out of range, and so outside of the
+     * loop. */
+    MVMSpeshIns **writers;
+    MVMuint32    *writer_offsets;
+    MVMuint16    *writer_counts;
+    MVMuint16     num_writer_locals;
+
+    /* Where to insert hoisted instructions in the preheader. */
+    MVMSpeshIns  *insert_after;
+
+    /* Immediate dominators of each block, and which blocks are alive. */
+    MVMSpeshBB  **idoms;
+    MVMSpeshBB  **live;
+
+    /* Deopt target at the start of an iteration, or -1 if none. */
+    MVMint32      osr_deopt_idx;
+
+    /* Whether the loop may run code we can't see, or binds lexicals or
+     * attributes, any of which means we can't hoist reads of them. */
+    MVMint32      may_run_code;
+    MVMint32      binds_lex;
+    MVMint32      binds_attr;
+} LoopState;
+
+static MVMSpeshIns ** loop_writer(LoopState *ls, MVMSpeshOperand o) {
+    if (o.reg.orig >= ls->num_writer_locals || o.reg.i >= ls->writer_counts[o.reg.orig])
+        return NULL;
+    return &ls->writers[ls->writer_offsets[o.reg.orig] + o.reg.i];
+}
+
+/* Works out if an operand read in the loop has the same value throughout it,
+ * and if so which operand it can be read from ahead of the loop. Values set
+ * from loop-invariant values (such as those we have already hoisted) count
+ * too. */
+static MVMint32 invariant_source(LoopState *ls, MVMSpeshOperand o, MVMSpeshOperand *source) {
+    MVMSpeshIns **writer = loop_writer(ls, o);
+    if (!writer || !*writer) {
+        *source = o;
+        return 1;
+    }
+    if ((*writer)->info->opcode == MVM_OP_set)
+        return invariant_source(ls, (*writer)->operands[1], source);
+    return 0;
+}
+
+/* Checks if a block in the loop runs on every iteration, by dominating all of
+ * the back edges. */
+static MVMint32 runs_every_iteration(MVMSpeshGraph *g, LoopState *ls, MVMSpeshBB *bb) {
+    MVMuint16 i;
+    for (i = 0; i < ls->header->num_pred; i++) {
+        MVMSpeshBB *pred = ls->header->pred[i];
+        if (is_live(g, ls->live, pred) && ls->in_loop[pred->idx]
+                && !dominates(ls->idoms, bb, pred))
+            return 0;
+    }
+    return 1;
+}
+
+/* Checks if any guard still in the loop guards the given invariant object.
+ * Reads of its attributes or contents rely on such a guard, so they may not
+ * move ahead of it. */
+static MVMint32 guarded_in_loop(MVMSpeshGraph *g, LoopState *ls, MVMSpeshOperand obj) {
+    MVMSpeshBB *bb;
+    for (bb = g->entry; bb; bb = bb->linear_next) {
+        MVMSpeshIns *ins;
+        if (!ls->in_loop[bb->idx])
+            continue;
+        for (ins = bb->first_ins; ins; ins = ins->next) {
+            MVMSpeshOperand source;
+            if (licm_kind(ins->info->opcode) < MVM_LICM_GUARD)
+                continue;
+            if (!invariant_source(ls, ins->operands[0], &source))
+                continue;
+            if (source.reg.orig == obj.reg.orig && source.reg.i == obj.reg.i)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/* Checks whether an instruction in the loop could be hoisted. Guards, and
+ * reads of attributes or containers, are only hoisted from blocks that run
+ * every iteration, so we don't deoptimize ahead of the loop over a path it
+ * rarely takes, nor read from an object a conditional guard would reject.
+ * The reads also have to wait for any guards on the object in the loop. */
+static MVMint32 can_hoist(MVMThreadContext *tc, MVMSpeshGraph *g, LoopState *ls, MVMSpeshBB *bb,
+                          MVMSpeshIns *ins) {
+    MVMSpeshAnn     *ann;
+    MVMSpeshOperand  source;
+    MVMint32         i;
+    MVMint32         kind = licm_kind(ins->info->opcode);
+    switch (kind) {
+    case MVM_LICM_PURE:
+        break;
+    case MVM_LICM_LEX:
+        if (ls->may_run_code || ls->binds_lex)
+            return 0;
+        break;
+    case MVM_LICM_ATTR:
+        if (ls->may_run_code || ls->binds_attr || !runs_every_iteration(g, ls, bb))
+            return 0;
+        if (!invariant_source(ls, ins->operands[1], &source) || guarded_in_loop(g, ls, source))
+            return 0;
+        break;
+    case MVM_LICM_CONT_GUARD:
+        if (ls->may_run_code || ls->binds_attr)
+            return 0;
+        /* Fall through. */
+    case MVM_LICM_GUARD:
+        if (ls->osr_deopt_idx < 0 || !runs_every_iteration(g, ls, bb))
+            return 0;
+        break;
+    default:
+        return 0;
+    }
+
+    /* Guards may only carry their deopt point; anything else may not carry
+     * annotations at all. */
+    for (ann = ins->annotations; ann; ann = ann->next)
+        if (kind < MVM_LICM_GUARD || ann->type != MVM_SPESH_ANN_DEOPT_ONE_INS)
+            return 0;
+
+    /* All of the registers read must be invariant. */
+    for (i = 0; i < ins->info->num_operands; i++)
+        if ((ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg)
+            if (!invariant_source(ls, ins->operands[i], &source))
+                return 0;
+    return 1;
+}
+
+/* Hoists an instruction into the preheader. Instructions producing a value
+ * compute it into a fresh local there, and become a set from it in the
+ * loop. It can't be a temporary, as those get reused by transforms in the
+ * loop body, which would overwrite it. Guards are moved outright, deoptimizing to the start of the loop. */
+static void hoist(MVMThreadContext *tc, MVMSpeshGraph *g, LoopState *ls, MVMSpeshBB *bb,
+                  MVMSpeshIns *ins) {
+    MVMSpeshIns *hoisted = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshIns));
+    MVMint32     i;
+    hoisted->info     = ins->info;
+    hoisted->operands = MVM_spesh_alloc(tc, g, ins->info->num_operands * sizeof(MVMSpeshOperand));
+    memcpy(hoisted->operands, ins->operands, ins->info->num_operands * sizeof(MVMSpeshOperand));
+
+    /* Read from values available ahead of the loop. */
+    for (i = 0; i < ins->info->num_operands; i++) {
+        if ((ins->info->operands[i] & MVM_operand_rw_mask) == MVM_operand_read_reg) {
+            MVMSpeshOperand source;
+            invariant_source(ls, ins->operands[i], &source);
+            if (source.reg.orig != ins->operands[i].reg.orig || source.reg.i != ins->operands[i].reg.i) {
+                get_facts_direct(tc, g, ins->operands[i])->usages--;
+                get_facts_direct(tc, g, source)->usages++;
+                hoisted->operands[i] = source;
+            }
+        }
+    }
+    MVM_spesh_manipulate_insert_ins(tc, ls->preheader, ls->insert_after, hoisted);
+    ls->insert_after = hoisted;
+
+    if (licm_kind(ins->info->opcode) >= MVM_LICM_GUARD) {
+        /* Give it a deopt point of its own, then drop the original, along
+         * with its deopt point. */
+        MVM_spesh_graph_add_deopt_annotation(tc, g, hoisted,
+            g->deopt_addrs[2 * ls->osr_deopt_idx], MVM_SPESH_ANN_DEOPT_ONE_INS);
+        for (i = 0; i < g->num_log_guards; i++) {
+            if (g->log_guards[i].ins == ins) {
+                g->log_guards[i].ins = hoisted;
+                g->log_guards[i].bb  = ls->preheader;
+            }
+        }
+        ins->annotations = NULL;
+        MVM_spesh_manipulate_delete_ins(tc, g, bb, ins);
+    }
+    else {
+        MVMSpeshOperand target = ins->operands[0];
+        MVMuint16       kind   = g->local_types
+            ? g->local_types[target.reg.orig]
+            : g->sf->body.local_types[target.reg.orig];
+        MVMSpeshOperand temp   = MVM_spesh_manipulate_new_local(tc, g, kind);
+        MVMSpeshFacts  *temp_facts;
+        hoisted->operands[0] = temp;
+        copy_facts(tc, g, temp, target);
+        temp_facts         = get_facts_direct(tc, g, temp);
+        temp_facts->usages = 1;
+        temp_facts->writer = hoisted;
+
+        ins->info        = MVM_op_get_op(MVM_OP_set);
+        ins->operands    = MVM_spesh_alloc(tc, g, 2 * sizeof(MVMSpeshOperand));
+        ins->operands[0] = target;
+        ins->operands[1] = temp;
+    }
+}
+
+/* Looks at what the loop does, to know what we can hoist out of it. */
+static void analyze_loop(MVMThreadContext *tc, MVMSpeshGraph *g, LoopState *ls) {
+    MVMSpeshBB *bb;
+    MVMuint32   total = 0;
+    MVMuint16   i;
+
+    ls->num_writer_locals = g->num_locals;
+    ls->writer_offsets    = MVM_malloc(g->num_locals * sizeof(MVMuint32));
+    ls->writer_counts     = MVM_malloc(g->num_locals * sizeof(MVMuint16));
+    for (i = 0; i < g->num_locals; i++) {
+        ls->writer_offsets[i] = total;
+        ls->writer_counts[i]  = g->fact_counts[i];
+        total += g->fact_counts[i];
+    }
+    ls->writers = MVM_calloc(total ? total : 1, sizeof(MVMSpeshIns *));
+
+    for (bb = g->entry; bb; bb = bb->linear_next) {
+        MVMSpeshIns *ins;
+        if (!ls->in_loop[bb->idx])
+            continue;
+        for (ins = bb->first_ins; ins; ins = ins->next) {
+            MVMuint16 op = ins->info->opcode;
+            MVMint32  j;
+
+            /* Note which values the loop writes. */
+            for (j = 0; j < ins->info->num_operands; j++) {
+                if (op == MVM_SSA_PHI ? j == 0
+                        : (ins->info->operands[j] & MVM_operand_rw_mask) == MVM_operand_write_reg) {
+                    MVMSpeshIns **writer = loop_writer(ls, ins->operands[j]);
+                    if (writer)
+                        *writer = ins;
+                }
+            }
+
+            /* Note anything that might change what the loop reads. */
+            switch (op) {
+            case MVM_SSA_PHI: case MVM_OP_set: case MVM_OP_goto:
+            case MVM_OP_if_i: case MVM_OP_unless_i: case MVM_OP_if_n: case MVM_OP_unless_n:
+            case MVM_OP_osrpoint:
+                break;
+            case MVM_OP_bindlex:
+                ls->binds_lex = 1;
+                break;
+            case MVM_OP_sp_p6obind_o: case MVM_OP_sp_p6obind_i:
+            case MVM_OP_sp_p6obind_n: case MVM_OP_sp_p6obind_s:
+            case MVM_OP_sp_bind_o: case MVM_OP_sp_bind_i64: case MVM_OP_sp_bind_i32:
+            case MVM_OP_sp_bind_i16: case MVM_OP_sp_bind_i8:
+            case MVM_OP_sp_bind_n: case MVM_OP_sp_bind_s:
+                ls->binds_attr = 1;
+                break;
+            default:
+                if (!licm_kind(op))
+                    ls->may_run_code = 1;
+            }
+        }
+    }
+}
+
+/* Finds the deopt point at the start of the loop header, if it has one (it
+ * will if the loop starts with an osrpoint). Deoptimizing there with the
+ * state we have in the preheader is just like entering the loop. */
+static MVMint32 find_loop_start_deopt(MVMSpeshBB *header, MVMSpeshBB *preheader) {
+    MVMSpeshIns *ins = header->first_ins;
+    MVMSpeshAnn *ann;
+    MVMint32     idx = -1;
+    if (header->inlined || preheader->inlined)
+        return -1;
+    while (ins && ins->info->opcode == MVM_SSA_PHI)
+        ins = ins->next;
+    if (!ins)
+        return -1;
+    for (ann = ins->annotations; ann; ann = ann->next) {
+        if (ann->type == MVM_SPESH_ANN_DEOPT_OSR)
+            idx = ann->data.deopt_idx;
+        else if (ann->type != MVM_SPESH_ANN_DEOPT_ONE_INS && ann->type != MVM_SPESH_ANN_DEOPT_ALL_INS)
+            return -1;
+    }
+    return idx;
+}
+
+/* Works out where instructions go in the preheader: at the end, but before
+ * any goto. If it ends in some other kind of branch, we can't use it. */
+static MVMint32 find_insert_point(MVMSpeshBB *preheader, MVMSpeshIns **after) {
+    MVMSpeshIns *last = preheader->last_ins;
+    MVMint32     i;
+    if (!last) {
+        *after = NULL;
+        return 1;
+    }
+    if (last->info->opcode == MVM_OP_goto) {
+        *after = last->prev;
+        return 1;
+    }
+    for (i = 0; i < last->info->num_operands; i++)
+        if ((last->info->operands[i] & MVM_operand_type_mask) == MVM_operand_ins)
+            return 0;
+    *after = last;
+    return 1;
+}
+
+/* Considers the loop headed by the given block, if it is one. */
+static void hoist_loop_invariants(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB **live,
+                                  MVMSpeshBB **idoms, MVMSpeshBB **work, MVMSpeshBB *header) {
+    LoopState  ls;
+    MVMint32   num_work = 0;
+    MVMint32   changed;
+    MVMuint16  i;
+
+    memset(&ls, 0, sizeof(LoopState));
+    ls.header  = header;
+    ls.live    = live;
+    ls.idoms   = idoms;
+    ls.in_loop = MVM_calloc(g->num_bbs, 1);
+
+    /* Back edges come from blocks the header dominates; walk back from them
+     * to find all of the loop body. */
+    ls.in_loop[header->idx] = 1;
+    for (i = 0; i < header->num_pred; i++) {
+        MVMSpeshBB *pred = header->pred[i];
+        if (is_live(g, live, pred) && dominates(idoms, header, pred) && !ls.in_loop[pred->idx]) {
+            ls.in_loop[pred->idx] = 1;
+            work[num_work++] = pred;
+        }
+    }
+    if (!num_work)
+        goto done;
+    while (num_work) {
+        MVMSpeshBB *bb = work[--num_work];
+        for (i = 0; i < bb->num_pred; i++) {
+            MVMSpeshBB *pred = bb->pred[i];
+            if (is_live(g, live, pred) && !ls.in_loop[pred->idx]) {
+                ls.in_loop[pred->idx] = 1;
+                work[num_work++] = pred;
+            }
+        }
+    }
+
+    /* Need exactly one way into the loop, from a block that only leads to
+     * the loop. */
+    for (i = 0; i < header->num_pred; i++) {
+        MVMSpeshBB *pred = header->pred[i];
+        if (!is_live(g, live, pred) || ls.in_loop[pred->idx])
+            continue;
+        if (ls.preheader && ls.preheader != pred)
+            goto done;
+        ls.preheader = pred;
+    }
+    if (!ls.preheader || ls.preheader->num_succ != 1 || ls.preheader->inlined != header->inlined)
+        goto done;
+    if (!find_insert_point(ls.preheader, &ls.insert_after))
+        goto done;
+    ls.osr_deopt_idx = find_loop_start_deopt(header, ls.preheader);
+
+    /* Hoist to a fixed point, since hoisting one thing may make things that
+     * depend on it invariant too. */
+    analyze_loop(tc, g, &ls);
+    do {
+        MVMSpeshBB *bb;
+        changed = 0;
+        for (bb = g->entry; bb; bb = bb->linear_next) {
+            MVMSpeshIns *ins;
+            if (!ls.in_loop[bb->idx])
+                continue;
+            ins = bb->first_ins;
+            while (ins) {
+                MVMSpeshIns *next = ins->next;
+                if (can_hoist(tc, g, &ls, bb, ins)) {
+                    hoist(tc, g, &ls, bb, ins);
+                    changed = 1;
+                }
+                ins = next;
+            }
+        }
+    } while (changed);
+
+    MVM_free(ls.writers);
+    MVM_free(ls.writer_offsets);
+    MVM_free(ls.writer_counts);
+  done:
+    MVM_free(ls.in_loop);
+}
+
+static void hoist_invariants(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    MVMSpeshBB **live  = MVM_calloc(g->num_bbs, sizeof(MVMSpeshBB *));
+    MVMSpeshBB **idoms = MVM_calloc(g->num_bbs, sizeof(MVMSpeshBB *));
+    MVMSpeshBB **work  = MVM_malloc(g->num_bbs * sizeof(MVMSpeshBB *));
+    MVMSpeshBB  *bb;
+    MVMint32     i;
+
+    for (bb = g->entry; bb; bb = bb->linear_next)
+        live[bb->idx] = bb;
+    record_idoms(g, live, idoms, g->entry);
+
+    /* Visit later headers first, so inner loops are usually done before
+     * the loops around them, which may then hoist things further. */
+    for (i = g->num_bbs - 1; i >= 0; i--)
+        if (live[i] && live[i] != g->entry)
+            hoist_loop_invariants(tc, g, live, idoms, work, live[i]);
+
+    MVM_free(work);
+    MVM_free(idoms);
+    MVM_free(live);
+}
+
 /* Goes through the various log-based guard instructions and removes any that
  * are not being made use of. */
 static void eliminate_unused_log_guards(MVMThreadContext *tc, MVMSpeshGraph *g) {
@@ -1812,8 +2644,10 @@ static void eliminate_unused_log_guards(MVMThreadContext *tc, MVMSpeshGraph *g)
 /* Drives the overall optimization work taking place on a spesh graph. */
 void MVM_spesh_optimize(MVMThreadContext *tc, MVMSpeshGraph *g) {
     optimize_bb(tc, g, g->entry);
+    eliminate_non_escaping_objects(tc, g);
     eliminate_dead_ins(tc, g);
     eliminate_dead_bbs(tc, g);
     eliminate_unused_log_guards(tc, g);
+    hoist_invariants(tc, g);
     second_pass(tc, g, g->entry);
 }
@@ -9,6 +9,7 @@ struct MVMSpeshCallInfo {
     MVMSpeshFacts *arg_facts[MAX_ARGS_FOR_OPT];
     MVMSpeshIns   *prepargs_ins;
     MVMSpeshIns   *arg_ins[MAX_ARGS_FOR_OPT];
+    MVMint32       call_count;
 };
 
 void MVM_spesh_optimize(MVMThreadContext *tc, MVMSpeshGraph *g);
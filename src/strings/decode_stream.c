@@ -421,6 +421,20 @@ MVMint64 MVM_string_decodestream_have_bytes(MVMThreadContext *tc, const MVMDecod
     return 0;
 }
 
+/* Gets the number of bytes in the stream that have not yet been decoded or
+ * taken. */
+MVMint64 MVM_string_decodestream_bytes_available(MVMThreadContext *tc, const MVMDecodeStream *ds) {
+    MVMDecodeStreamBytes *cur_bytes = ds->bytes_head;
+    MVMint64 found = 0;
+    while (cur_bytes) {
+        found += cur_bytes == ds->bytes_head
+            ? cur_bytes->length - ds->bytes_head_pos
+            : cur_bytes->length;
+        cur_bytes = cur_bytes->next;
+    }
+    return found;
+}
+
 /* Copies up to the requested number of bytes into the supplied buffer, and
  * returns the number of bytes we actually copied. Takes from from the start
  * of the stream. */
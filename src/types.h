@@ -169,9 +169,11 @@ typedef struct MVMSpeshLogGuard MVMSpeshLogGuard;
 typedef struct MVMSpeshCallInfo MVMSpeshCallInfo;
 typedef struct MVMSpeshInline MVMSpeshInline;
 typedef struct MVMSTable MVMSTable;
+typedef struct MVMTypeCheckIndex MVMTypeCheckIndex;
 typedef struct MVMStaticFrame MVMStaticFrame;
 typedef struct MVMStaticFrameBody MVMStaticFrameBody;
 typedef struct MVMStaticFrameInstrumentation MVMStaticFrameInstrumentation;
+typedef struct MVMFindMethCache MVMFindMethCache;
 typedef struct MVMStorageSpec MVMStorageSpec;
 typedef struct MVMString MVMString;
 typedef struct MVMStringBody MVMStringBody;
@@ -199,8 +201,11 @@ typedef struct MVMIOSockety MVMIOSockety;
 typedef struct MVMIOPipeable MVMIOPipeable;
 typedef struct MVMIOIntrospection MVMIOIntrospection;
 typedef struct MVMIOLockable MVMIOLockable;
+typedef struct MVMIOCopyable MVMIOCopyable;
 typedef struct MVMIOSyncStreamData MVMIOSyncStreamData;
+typedef struct MVMIOFileData MVMIOFileData;
 typedef struct MVMIOSyncPipeData MVMIOSyncPipeData;
+typedef struct MVMTimerWheel MVMTimerWheel;
 typedef struct MVMDecodeStream MVMDecodeStream;
 typedef struct MVMDecodeStreamBytes MVMDecodeStreamBytes;
 typedef struct MVMDecodeStreamChars MVMDecodeStreamChars;
@@ -222,6 +227,8 @@ typedef struct MVMJitInvoke MVMJitInvoke;
 typedef struct MVMJitJumpList MVMJitJumpList;
 typedef struct MVMJitControl MVMJitControl;
 typedef struct MVMJitCode MVMJitCode;
+typedef struct MVMJitArena MVMJitArena;
+typedef struct MVMJitArenaChunk MVMJitArenaChunk;
 typedef struct MVMProfileThreadData MVMProfileThreadData;
 typedef struct MVMProfileGC MVMProfileGC;
 typedef struct MVMProfileCallNode MVMProfileCallNode;
@@ -236,3 +243,17 @@ typedef struct MVMHeapSnapshotReference MVMHeapSnapshotReference;
 typedef struct MVMHeapSnapshotState MVMHeapSnapshotState;
 typedef struct MVMHeapSnapshotWorkItem MVMHeapSnapshotWorkItem;
 typedef struct MVMHeapSnapshotSeen MVMHeapSnapshotSeen;
+typedef struct MVMHeapSnapshotStringEntry MVMHeapSnapshotStringEntry;
+typedef struct MVMHeapSnapshotTableEntry MVMHeapSnapshotTableEntry;
+typedef struct MVMSamplingEntry MVMSamplingEntry;
+typedef struct MVMSamplingBuffer MVMSamplingBuffer;
+typedef struct MVMSamplingStack MVMSamplingStack;
+typedef struct MVMSamplingName MVMSamplingName;
+typedef struct MVMSamplingProfiler MVMSamplingProfiler;
+typedef struct MVMAllocSample MVMAllocSample;
+typedef struct MVMAllocProfileThread MVMAllocProfileThread;
+typedef struct MVMAllocSite MVMAllocSite;
+typedef struct MVMAllocProfiler MVMAllocProfiler;
+typedef struct MVMGCStats MVMGCStats;
+typedef struct MVMPreloadedFile MVMPreloadedFile;
+typedef struct MVMPreloader MVMPreloader;